@@ -0,0 +1,10 @@
+Opening trace file with gunzip: ../traces/gcc.ptr.gz
+
+** PIPELINE IS 1 WIDE **
+
+
+
+LAB2_NUM_INST           	 :          0
+LAB2_NUM_CYCLES         	 :          1
+LAB2_CPI                	 :        inf
+
@@ -0,0 +1,10 @@
+Opening trace file with gunzip: ../traces/sml.ptr.gz
+
+** PIPELINE IS 2 WIDE **
+
+
+
+LAB2_NUM_INST           	 :        100
+LAB2_NUM_CYCLES         	 :         77
+LAB2_CPI                	 :      0.770
+
@@ -0,0 +1,13 @@
+Opening trace file with gunzip: ../traces/gcc.ptr.gz
+
+** PIPELINE IS 2 WIDE **
+
+
+
+LAB2_NUM_INST           	 :          0
+LAB2_NUM_CYCLES         	 :          1
+LAB2_CPI                	 :        inf
+LAB2_BPRED_BRANCHES     	 :          0
+LAB2_BPRED_MISPRED      	 :          0
+LAB2_MISPRED_RATE       	 :       -nan
+
@@ -0,0 +1,13 @@
+Opening trace file with gunzip: ../traces/sml.ptr.gz
+
+** PIPELINE IS 2 WIDE **
+
+
+
+LAB2_NUM_INST           	 :        100
+LAB2_NUM_CYCLES         	 :         80
+LAB2_CPI                	 :      0.800
+LAB2_BPRED_BRANCHES     	 :         15
+LAB2_BPRED_MISPRED      	 :          7
+LAB2_MISPRED_RATE       	 :     46.667
+
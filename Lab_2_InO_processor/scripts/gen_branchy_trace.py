@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# gen_branchy_trace.py
+# Writes a synthetic trace whose conditional branches are hard enough to tell
+# branch predictors apart, which the bundled traces are not: loops, branches
+# correlated with older branches, biased random branches and short repeating
+# patterns, spread over 400 "functions" of which a few are hot.
+#
+# Usage: gen_branchy_trace.py <out.ptr.gz> [seed] [instructions]
+# (Default: seed 1, 3000000 instructions)
+#
+# The predictor comparisons were run on it with
+#     ./gen_branchy_trace.py branchy.ptr.gz 1 3000000
+#     ../src/sim -bpredsweep 2:12,2:15,2:18,3:1,3:8,3:32,3:64,4:1,4:8,4:64 \
+#         -bpredthreads 4 branchy.ptr.gz
+
+import gzip
+import random
+import struct
+import sys
+
+# One trace record, as read by the simulator (see trace.h)
+RECORD = struct.Struct('<Q9B7xQ3B5xQ')
+OP_ALU, OP_LD, OP_CBR = 0, 1, 3
+
+random.seed(int(sys.argv[2]) if len(sys.argv) > 2 else 1)
+target = int(sys.argv[3]) if len(sys.argv) > 3 else 3000000
+out = gzip.open(sys.argv[1], 'wb', compresslevel=1)
+history = []
+count = 0
+buf = []
+
+
+def inst(pc, op, direction=0):
+    global count
+    buf.append(RECORD.pack(pc, op, (pc >> 2) % 32, 1, (pc >> 4) % 32,
+                           (pc >> 6) % 32, 1, 1, 0, op == OP_CBR, 0, 0, 0,
+                           direction, pc + 64))
+    count += 1
+
+
+# A basic block of four instructions ending in a conditional branch
+def block(pc, taken):
+    for k in range(4):
+        inst(pc + 4 * k, OP_ALU if k % 3 else OP_LD)
+    inst(pc + 16, OP_CBR, taken)
+    history.append(taken)
+
+
+funcs = []
+for f in range(400):
+    kind = random.choice(['loop', 'corr', 'bias', 'pattern', 'corr2'])
+    funcs.append((0x400000 + f * 0x400, kind, random.randint(3, 40),
+                  random.randint(2, 60), random.random()))
+
+while count < target:
+    pc, kind, trip, dist, p = random.choice(
+        funcs[:random.choice([20, 80, 400])])
+    if kind == 'loop':
+        for i in range(trip):
+            block(pc, 1 if i < trip - 1 else 0)
+    elif kind == 'corr':
+        # Random branches, then one that repeats the branch dist back
+        for i in range(8):
+            block(pc + 0x40 * (i % 4), random.random() < 0.5)
+        block(pc + 0x200, history[-dist] if len(history) > dist else 0)
+    elif kind == 'corr2':
+        # Two random branches, a loop, then the XOR of the two
+        a = random.random() < 0.5
+        b = random.random() < 0.5
+        block(pc, a)
+        block(pc + 0x40, b)
+        for i in range(dist % 12):
+            block(pc + 0x80, 1 if i < (dist % 12) - 1 else 0)
+        block(pc + 0x100, a ^ b)
+    elif kind == 'bias':
+        for i in range(4):
+            block(pc + 0x40 * i, random.random() < (0.95 if p > 0.5 else 0.05))
+    else:
+        pattern = [(pc >> k) & 1 for k in range(trip % 7 + 2)]
+        for i in range(12):
+            block(pc, pattern[i % len(pattern)])
+    if len(buf) > 100000:
+        out.write(b''.join(buf))
+        buf = []
+# The pipeline needs an instruction after the last branch to resolve it
+inst(0x300000, OP_ALU)
+out.write(b''.join(buf))
+out.close()
+print(count)
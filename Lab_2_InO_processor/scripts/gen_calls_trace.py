@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+# gen_calls_trace.py
+# Writes a synthetic trace with calls, returns, jumps and taken branches with
+# real targets, to exercise the branch target buffer and the return address
+# stack: the bundled traces hit in any buffer. Calls, jumps and returns are
+# OP_OTHER instructions followed by a non-sequential address, which is how
+# the simulator recognizes them.
+#
+# Usage: gen_calls_trace.py <out.ptr.gz> [functions]
+# (Default: 300 functions)
+#
+# The target prediction figures were measured with
+#     ./gen_calls_trace.py calls.ptr.gz
+#     ../src/sim -pipewidth 2 -enablememfwd -enableexefwd -bpredpolicy 0 \
+#         -rasentries 8 [-btbentries <n>] calls.ptr.gz
+
+import gzip
+import random
+import struct
+import sys
+
+# One trace record, as read by the simulator (see trace.h)
+RECORD = struct.Struct('<Q9B7xQ3B5xQ')
+OP_ALU, OP_LD, OP_CBR, OP_OTHER = 0, 1, 3, 4
+
+random.seed(1)
+out = gzip.open(sys.argv[1], 'wb', compresslevel=1)
+buf = []
+count = 0
+
+
+def inst(pc, op, direction=0, target=0):
+    global count
+    buf.append(RECORD.pack(pc, op, (pc >> 2) % 32, op != OP_CBR,
+                           (pc >> 4) % 32, (pc >> 6) % 32, 1, 1,
+                           op == OP_CBR, 0, 0, 0, 0, direction, target))
+    count += 1
+
+
+num_funcs = int(sys.argv[2]) if len(sys.argv) > 2 else 300
+funcs = [0x400000]
+for f in range(num_funcs - 1):
+    funcs.append(funcs[-1] + random.randint(0x80, 0x800))
+callees = [random.sample(range(num_funcs), 3) for f in range(num_funcs)]
+
+
+# A function: a short loop, up to two calls, a jump over some code, a return
+def run(f, depth):
+    pc = funcs[f]
+    iters = random.randint(1, 4)
+    for it in range(iters):
+        for k in range(3):
+            inst(pc + 4 * k, OP_ALU)
+        inst(pc + 12, OP_CBR, 1 if it < iters - 1 else 0, pc)
+    pc += 16
+    if depth < 6:
+        for c in callees[f][:random.randint(0, 2)]:
+            inst(pc, OP_OTHER)
+            run(c, depth + 1)
+            pc += 5
+    inst(pc, OP_OTHER)
+    pc += 0x40
+    inst(pc, OP_ALU)
+    inst(pc + 4, OP_OTHER)
+
+
+while count < 3000000:
+    run(random.randrange(num_funcs), 0)
+    inst(0x300000, OP_ALU)
+    if len(buf) > 100000:
+        out.write(b''.join(buf))
+        buf = []
+inst(0x300004, OP_ALU)
+out.write(b''.join(buf))
+out.close()
+print(count)
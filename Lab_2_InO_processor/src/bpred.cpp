@@ -8,27 +8,27 @@
 // Implements the branch predictor class.
 
 #include "bpred.h"
-// Needed to get the BPRED_POLICY variable
+// Needed to get the BPRED_HISTORY_BITS variable
 #include "pipeline.h"
 #include <iostream>
 #include <bitset>
-#include <map>
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*
-* Function to make the upper bits of the address
-* apart from the lower 12 bits
+* Function to make a mask of the lower bits of an address
 * 
-* @param address: address to mask
+* @param bits: number of lower bits to keep
 */
-uint64_t mask_12_bits(uint64_t address)
+uint64_t mask_low_bits(uint32_t bits)
 {
-    // To make the lower 12 bits we need to create a mask 00000...1111
-    // where the 1s are the lower 12 bits
+    // To keep the lower bits we need to create a mask 00000...1111
+    // where the 1s are the lower bits
     uint64_t mask = -1; // to create a 11111...1 type of number
-    mask = mask << 12;
-    mask = ~mask;
-    address = mask & address;
-    return address;
+    mask = mask << bits;
+    return ~mask;
 }
 
 BranchDirection convert_ghsare_state_direction(BPredGharePrediction current)
@@ -51,13 +51,8 @@ BranchDirection convert_ghsare_state_direction(BPredGharePrediction current)
 */
 uint64_t BPred::get_pht_key(uint64_t pc)
 {
-    // Get lower 12 bits of PC
-    uint64_t pc_masked = mask_12_bits(pc);
-    uint64_t ghr_masked = mask_12_bits(global_history_register);
-
-    // Take the xor
-    uint64_t pht_key = pc_masked ^ ghr_masked;
-    return pht_key;
+    // Take the xor of the lower history_bits bits of the PC and GHR
+    return (pc ^ global_history_register) & pht_mask;
 }
 
 /*
@@ -67,82 +62,694 @@ uint64_t BPred::get_pht_key(uint64_t pc)
 */
 BPredGharePrediction BPred::get_gshare_prediction(uint64_t pht_key)
 {
-    BPredGharePrediction reset_state = WEAKLY_TAKEN;
-    // Check if key in pattern history table
-    if (pattern_history_table.find(pht_key) ==
-        pattern_history_table.end())
+    uint8_t packed = pattern_history_table[pht_key / BPRED_COUNTERS_PER_BYTE];
+    uint32_t shift = (pht_key % BPRED_COUNTERS_PER_BYTE) * 2;
+    uint32_t counter = (packed >> shift) & 3;
+    // The states are listed from strongly taken down to strongly not taken
+    return (BPredGharePrediction)(STRONGLY_NOTTAKEN - counter);
+}
+
+/*
+* Function to update the PHT table entry
+* @param pht_key key to access the PHT
+* @param bdirection direction the branch took
+*/
+void BPred::update_gshare_prediction(uint64_t pht_key, BranchDirection bdirection)
+{
+    // model the FSM as a 2-bit saturating counter
+    uint8_t &packed = pattern_history_table[pht_key / BPRED_COUNTERS_PER_BYTE];
+    uint32_t shift = (pht_key % BPRED_COUNTERS_PER_BYTE) * 2;
+    uint32_t counter = (packed >> shift) & 3;
+    if (bdirection == TAKEN)
     {
-        // key not yet in PHT => BPRED is warming up
-        pattern_history_table[pht_key] = reset_state;
-        return reset_state;
+        counter = sat_increment(counter, 3);
     }
     else
     {
-        // key in PHT => BPRED has warmed up
-        return pattern_history_table[pht_key];
+        counter = sat_decrement(counter);
     }
+    packed = (packed & ~(3 << shift)) | (counter << shift);
+}
 
-    // Adding safety
-    return reset_state;
+/*
+* Function to get the local component's prediction for the pc
+*
+* @param pc: Program counter address
+*/
+BranchDirection BPred::get_local_prediction(uint64_t pc)
+{
+    uint16_t history = local_history_table[pc % TOURNAMENT_LOCAL_ENTRIES];
+    // The upper half of the counter range predicts taken
+    if (local_counters[history] > TOURNAMENT_LOCAL_COUNTER_MAX / 2)
+    {
+        return TAKEN;
+    }
+    return NOT_TAKEN;
 }
 
 /*
-* Function to update the PHT table entry
-* @param pht_key key to access the PHT
-* @param bdirection direction the branch took
+* Function to push an outcome into the local history of the pc
+*
+* @param pc: Program counter address
+* @param bdirection direction the branch took, or was predicted to take
 */
-void BPred::update_gshare_prediction(uint64_t pht_key, BranchDirection bdirection)
+void BPred::push_local_history(uint64_t pc, BranchDirection bdirection)
 {
-    // during update we are sure it exists are during get
-    // it would have been reset if the state did not exist
-    BPredGharePrediction current_state = pattern_history_table[pht_key];
-    BPredGharePrediction new_state;
-    if (bdirection == TAKEN)
+    uint16_t &history = local_history_table[pc % TOURNAMENT_LOCAL_ENTRIES];
+    history = ((history << 1) | bdirection) &
+              mask_low_bits(TOURNAMENT_LOCAL_HISTORY_BITS);
+}
+
+/*
+* Function to check whether the chooser picks the global component
+*/
+bool BPred::get_chooser_global()
+{
+    return chooser_table[global_history_register & pht_mask] >= 2;
+}
+
+/*
+* Function to find the components of a tournament prediction for the pc, with
+* the current global and local histories
+*
+* @param pc: Program counter address
+* @param l set to the components
+*/
+void BPred::lookup_tournament(uint64_t pc, TournamentLookup *l)
+{
+    l->chooser_index = global_history_register & pht_mask;
+    l->local_history = local_history_table[pc % TOURNAMENT_LOCAL_ENTRIES];
+    l->local_pred = get_local_prediction(pc);
+    l->global_pred = convert_ghsare_state_direction(
+        get_gshare_prediction(get_pht_key(pc)));
+    l->chose_global = get_chooser_global();
+}
+
+/*
+* Function to train the chooser and the local counter a tournament prediction
+* was made from, and count which component was right
+*
+* @param l the components of the prediction
+* @param resolution direction the branch took
+*/
+void BPred::train_tournament(const TournamentLookup *l,
+                             BranchDirection resolution)
+{
+    if (l->chose_global)
     {
-        // model the FSM
-        switch (current_state)
-        {
-        case STRONGLY_NOTTAKEN:
-            new_state = WEAKLY_NOTTAKEN;
-            break;
-        case WEAKLY_NOTTAKEN:
-            new_state = WEAKLY_TAKEN;
-            break;
-        case WEAKLY_TAKEN:
-            new_state = STRONGLY_TAKEN;
-            break;
-        case STRONGLY_TAKEN:
-            new_state = STRONGLY_TAKEN;
-            break;
-        default:
-            new_state = WEAKLY_TAKEN;
-            break;
+        stat_chose_global++;
+    }
+    if (l->local_pred == resolution)
+    {
+        stat_local_correct++;
+    }
+    if (l->global_pred == resolution)
+    {
+        stat_global_correct++;
+    }
+
+    // Train the chooser towards whichever component was right, when only
+    // one of them was
+    uint8_t &choice = chooser_table[l->chooser_index];
+    if (l->local_pred != l->global_pred)
+    {
+        choice = l->global_pred == resolution ? sat_increment(choice, 3)
+                                              : sat_decrement(choice);
+    }
+
+    uint8_t &counter = local_counters[l->local_history];
+    if (resolution == TAKEN)
+    {
+        counter = sat_increment(counter, TOURNAMENT_LOCAL_COUNTER_MAX);
+    }
+    else
+    {
+        counter = sat_decrement(counter);
+    }
+}
+
+/*
+* Function to restore the local histories of the in-flight branches from the
+* given one to the youngest, youngest first so that the oldest checkpoint of
+* each history wins
+*
+* @param from the oldest branch to restore
+*/
+void BPred::restore_local_histories(std::deque<BPredInflight>::iterator from)
+{
+    for (auto it = inflight.end(); it != from;)
+    {
+        it--;
+        local_history_table[it->pc % TOURNAMENT_LOCAL_ENTRIES] =
+            it->tournament_lookup.local_history;
+    }
+}
+
+/*
+* Function to train the gshare PHT and the tournament tables with the current
+* global history
+*
+* @param pc: Program counter address
+* @param resolution direction the branch took
+*/
+void BPred::train_global(uint64_t pc, BranchDirection resolution)
+{
+    if (policy == BPRED_TOURNAMENT)
+    {
+        TournamentLookup l;
+        lookup_tournament(pc, &l);
+        train_tournament(&l, resolution);
+        push_local_history(pc, resolution);
+    }
+
+    // Update the PHT
+    uint64_t pht_key = get_pht_key(pc);
+    update_gshare_prediction(pht_key, resolution);
+}
+
+/*
+* Function to get the storage of the predictor's tables in bits
+*/
+uint64_t BPred::storage_bits()
+{
+    if (policy == BPRED_GSHARE)
+    {
+        return (pht_mask + 1) * 2 + history_bits;
+    }
+    if (policy == BPRED_TAGE)
+    {
+        return tage.storage_bits;
+    }
+    if (policy == BPRED_PERCEPTRON)
+    {
+        return perceptron.storage_bits;
+    }
+    if (policy == BPRED_TOURNAMENT)
+    {
+        return (pht_mask + 1) * 2 * 2 + history_bits +
+               TOURNAMENT_LOCAL_ENTRIES * TOURNAMENT_LOCAL_HISTORY_BITS +
+               (1ULL << TOURNAMENT_LOCAL_HISTORY_BITS) * 3;
+    }
+    return 0;
+}
+
+/*
+* Function to size the TAGE tables to a storage budget and reset them
+*
+* @param budget_kb the storage budget in KB
+*/
+void TagePredictor::init(uint32_t budget_kb)
+{
+    uint64_t budget_bits = (uint64_t)budget_kb * 1024 * 8;
+
+    // An eighth of the budget goes to the 2-bit bimodal counters
+    log_bimodal = 1;
+    while ((2ULL << (log_bimodal + 1)) <= budget_bits / 8)
+    {
+        log_bimodal++;
+    }
+
+    // Longer histories get longer tags, as their aliasing costs more
+    uint64_t bits_per_row = 0;
+    for (int i = 0; i < TAGE_NUM_TABLES; i++)
+    {
+        tag_bits[i] = 8 + i / 2;
+        bits_per_row += 3 + 2 + tag_bits[i];
+        history_lengths[i] = (uint32_t)(TAGE_MIN_HISTORY *
+                                        pow((double)TAGE_MAX_HISTORY /
+                                                TAGE_MIN_HISTORY,
+                                            (double)i / (TAGE_NUM_TABLES - 1)) +
+                                        0.5);
+    }
+    uint64_t tagged_bits = budget_bits - (2ULL << log_bimodal);
+    log_tagged = 1;
+    while ((bits_per_row << (log_tagged + 1)) <= tagged_bits)
+    {
+        log_tagged++;
+    }
+
+    bimodal.assign(1ULL << log_bimodal, 2);
+    TageEntry empty = {0, 0, 0};
+    for (int i = 0; i < TAGE_NUM_TABLES; i++)
+    {
+        tables[i].assign(1ULL << log_tagged, empty);
+        index_folds[i] = {0, history_lengths[i], log_tagged,
+                          history_lengths[i] % log_tagged};
+        for (int j = 0; j < 2; j++)
+        {
+            uint32_t width = tag_bits[i] - j;
+            tag_folds[j][i] = {0, history_lengths[i], width,
+                               history_lengths[i] % width};
+        }
+    }
+    storage_bits = (2ULL << log_bimodal) + (bits_per_row << log_tagged) +
+                   TAGE_MAX_HISTORY + 16 + 4;
+
+    memset(history, 0, sizeof(history));
+    history_ptr = 0;
+    path_history = 0;
+    use_alt_on_na = 0;
+    num_updates = 0;
+    random_state = 1;
+    last_lookup_valid = false;
+}
+
+/*
+* Function to find the entries of every TAGE table for a branch, and which
+* of them provide the prediction
+*/
+void TagePredictor::lookup(uint64_t pc, TageLookup *l)
+{
+    l->pc = pc;
+    l->bimodal_index = (pc ^ (pc >> log_bimodal)) & ((1ULL << log_bimodal) - 1);
+    l->provider = -1;
+    l->alt = -1;
+    uint64_t index_mask = (1ULL << log_tagged) - 1;
+    for (int i = 0; i < TAGE_NUM_TABLES; i++)
+    {
+        uint64_t path = path_history &
+                        ((1ULL << std::min(history_lengths[i], 16u)) - 1);
+        l->indices[i] = (pc ^ (pc >> log_tagged) ^ index_folds[i].comp ^
+                         path ^ (path >> log_tagged)) &
+                        index_mask;
+        l->tags[i] = (pc ^ tag_folds[0][i].comp ^ (tag_folds[1][i].comp << 1)) &
+                     ((1ULL << tag_bits[i]) - 1);
+        if (tables[i][l->indices[i]].tag == l->tags[i])
+        {
+            l->alt = l->provider;
+            l->provider = i;
         }
     }
+
+    bool bimodal_pred = bimodal[l->bimodal_index] >= 2;
+    l->alt_pred = l->alt >= 0 ? tables[l->alt][l->indices[l->alt]].ctr >= 0
+                              : bimodal_pred;
+    if (l->provider < 0)
+    {
+        l->provider_pred = l->pred = bimodal_pred;
+        return;
+    }
+
+    // A weak, not yet useful provider is likely a fresh allocation
+    TageEntry &entry = tables[l->provider][l->indices[l->provider]];
+    l->provider_pred = entry.ctr >= 0;
+    bool weak = entry.ctr == 0 || entry.ctr == -1;
+    if (weak && entry.u == 0 && use_alt_on_na >= 0)
+    {
+        l->pred = l->alt_pred;
+    }
     else
     {
-        // not taken
-        // model the FSM
-        switch (current_state)
+        l->pred = l->provider_pred;
+    }
+}
+
+/*
+* Function to predict a branch with TAGE
+*
+* @param pc the address of the branch
+*/
+BranchDirection TagePredictor::predict(uint64_t pc)
+{
+    lookup(pc, &last_lookup);
+    last_lookup_valid = true;
+    return last_lookup.pred ? TAKEN : NOT_TAKEN;
+}
+
+/*
+* Function to shift the newest history bit into a folded history and the bit
+* leaving its window out of it
+*/
+void TagePredictor::fold_update(FoldedHistory *f)
+{
+    uint32_t newest = history[history_ptr];
+    uint32_t oldest = history[(history_ptr + f->length) &
+                              (TAGE_HISTORY_BUFFER - 1)];
+    f->comp = (f->comp << 1) | newest;
+    f->comp ^= oldest << f->out_point;
+    f->comp ^= f->comp >> f->width;
+    f->comp &= (1u << f->width) - 1;
+}
+
+/*
+* Function to train TAGE with the outcome of the branch last predicted
+*
+* @param pc the address of the branch
+* @param resolution the actual outcome of the branch
+*/
+void TagePredictor::update(uint64_t pc, BranchDirection resolution)
+{
+    if (!last_lookup_valid || last_lookup.pc != pc)
+    {
+        lookup(pc, &last_lookup);
+    }
+    last_lookup_valid = false;
+    train(&last_lookup, resolution == TAKEN);
+    push_history(pc, resolution == TAKEN);
+}
+
+/*
+* Function to train the TAGE tables with the outcome of a branch, at the
+* entries its prediction was made from
+*
+* @param l the lookup the branch was predicted with
+* @param taken whether the branch was taken
+*/
+void TagePredictor::train(const TageLookup *l, bool taken)
+{
+
+    // On a misprediction, allocate an entry with a longer history, starting
+    // at a random one of the next two tables
+    if (l->pred != taken && l->provider < TAGE_NUM_TABLES - 1)
+    {
+        random_state = random_state * 1103515245 + 12345;
+        int start = l->provider + 1;
+        if (start < TAGE_NUM_TABLES - 1 && ((random_state >> 16) & 1))
         {
-        case STRONGLY_NOTTAKEN:
-            new_state = STRONGLY_NOTTAKEN;
-            break;
-        case WEAKLY_NOTTAKEN:
-            new_state = STRONGLY_NOTTAKEN;
-            break;
-        case WEAKLY_TAKEN:
-            new_state = WEAKLY_NOTTAKEN;
-            break;
-        case STRONGLY_TAKEN:
-            new_state = WEAKLY_TAKEN;
-            break;
-        default:
-            new_state = WEAKLY_TAKEN;
-            break;
+            start++;
+        }
+        bool allocated = false;
+        for (int i = start; i < TAGE_NUM_TABLES && !allocated; i++)
+        {
+            TageEntry &entry = tables[i][l->indices[i]];
+            if (entry.u == 0)
+            {
+                entry.tag = l->tags[i];
+                entry.ctr = taken ? 0 : -1;
+                allocated = true;
+            }
+        }
+        if (!allocated)
+        {
+            for (int i = l->provider + 1; i < TAGE_NUM_TABLES; i++)
+            {
+                TageEntry &entry = tables[i][l->indices[i]];
+                entry.u = sat_decrement(entry.u);
+            }
+        }
+    }
+
+    if (l->provider >= 0)
+    {
+        TageEntry &entry = tables[l->provider][l->indices[l->provider]];
+        bool weak = entry.ctr == 0 || entry.ctr == -1;
+        if (weak && l->provider_pred != l->alt_pred)
+        {
+            if (l->alt_pred == taken)
+            {
+                use_alt_on_na = std::min(use_alt_on_na + 1, 7);
+            }
+            else
+            {
+                use_alt_on_na = std::max(use_alt_on_na - 1, -8);
+            }
+        }
+        // A fresh entry has not learnt yet, so the alternate keeps training
+        if (weak && entry.u == 0)
+        {
+            if (l->alt >= 0)
+            {
+                TageEntry &alt = tables[l->alt][l->indices[l->alt]];
+                alt.ctr = taken ? std::min(alt.ctr + 1, 3)
+                                : std::max(alt.ctr - 1, -4);
+            }
+            else
+            {
+                uint8_t &ctr = bimodal[l->bimodal_index];
+                ctr = taken ? sat_increment(ctr, 3) : sat_decrement(ctr);
+            }
+        }
+        entry.ctr = taken ? std::min(entry.ctr + 1, 3)
+                          : std::max(entry.ctr - 1, -4);
+        if (l->provider_pred != l->alt_pred)
+        {
+            entry.u = l->provider_pred == taken ? sat_increment(entry.u, 3)
+                                                : sat_decrement(entry.u);
+        }
+    }
+    else
+    {
+        uint8_t &ctr = bimodal[l->bimodal_index];
+        ctr = taken ? sat_increment(ctr, 3) : sat_decrement(ctr);
+    }
+
+    // Age the useful counters, so that stale entries can be replaced
+    if (++num_updates % TAGE_USEFUL_RESET_PERIOD == 0)
+    {
+        for (int i = 0; i < TAGE_NUM_TABLES; i++)
+        {
+            for (TageEntry &entry : tables[i])
+            {
+                entry.u >>= 1;
+            }
+        }
+    }
+
+}
+
+/*
+* Function to push the outcome of a branch into the TAGE global and path
+* histories
+*
+* @param pc the address of the branch
+* @param taken whether the branch was taken
+*/
+void TagePredictor::push_history(uint64_t pc, bool taken)
+{
+    history_ptr = (history_ptr - 1) & (TAGE_HISTORY_BUFFER - 1);
+    history[history_ptr] = taken;
+    path_history = ((path_history << 1) | (pc & 1)) & 0xFFFF;
+    for (int i = 0; i < TAGE_NUM_TABLES; i++)
+    {
+        fold_update(&index_folds[i]);
+        fold_update(&tag_folds[0][i]);
+        fold_update(&tag_folds[1][i]);
+    }
+}
+
+/*
+* Function to checkpoint the TAGE histories. The history buffer itself needs
+* no copy, as later outcomes are only written past its current position.
+*
+* @param h the checkpoint to fill
+*/
+void TagePredictor::save_history(TageHistory *h)
+{
+    h->history_ptr = history_ptr;
+    h->path_history = path_history;
+    for (int i = 0; i < TAGE_NUM_TABLES; i++)
+    {
+        h->index_comps[i] = index_folds[i].comp;
+        h->tag_comps[0][i] = tag_folds[0][i].comp;
+        h->tag_comps[1][i] = tag_folds[1][i].comp;
+    }
+}
+
+/*
+* Function to restore the TAGE histories from a checkpoint
+*
+* @param h the checkpoint
+*/
+void TagePredictor::restore_history(const TageHistory *h)
+{
+    history_ptr = h->history_ptr;
+    path_history = h->path_history;
+    for (int i = 0; i < TAGE_NUM_TABLES; i++)
+    {
+        index_folds[i].comp = h->index_comps[i];
+        tag_folds[0][i].comp = h->tag_comps[0][i];
+        tag_folds[1][i].comp = h->tag_comps[1][i];
+    }
+}
+
+/*
+* Function to size the perceptron tables to a storage budget and reset them
+*
+* @param budget_kb the storage budget in KB
+*/
+void PerceptronPredictor::init(uint32_t budget_kb)
+{
+    uint64_t budget_bits = (uint64_t)budget_kb * 1024 * 8;
+
+    log_rows = 1;
+    while (((uint64_t)PERCEPTRON_NUM_TABLES * 8 << (log_rows + 1)) <= budget_bits)
+    {
+        log_rows++;
+    }
+    weights.assign((size_t)PERCEPTRON_NUM_TABLES << log_rows, 0);
+
+    // The first table sees no history; the others split it into segments of
+    // geometrically increasing length, so recent branches get the most weights
+    segment_starts[0] = segment_ends[0] = 0;
+    for (int i = 1; i < PERCEPTRON_NUM_TABLES; i++)
+    {
+        uint32_t end = (uint32_t)(2 * pow(PERCEPTRON_MAX_HISTORY / 2.0,
+                                          (double)(i - 1) /
+                                              (PERCEPTRON_NUM_TABLES - 2)) +
+                                  0.5);
+        segment_starts[i] = segment_ends[i - 1];
+        segment_ends[i] = std::max(end, segment_starts[i] + 1);
+    }
+
+    theta = (int32_t)(1.93 * PERCEPTRON_NUM_TABLES + 14);
+    theta_counter = 0;
+    storage_bits = (uint64_t)PERCEPTRON_NUM_TABLES * 8 << log_rows;
+    storage_bits += PERCEPTRON_MAX_HISTORY + 8 + 7;
+
+    memset(history, 0, sizeof(history));
+    last_lookup_valid = false;
+}
+
+/*
+* Function to get bits start (included) to end (excluded) of the global
+* history, at most 64 of them
+*/
+uint64_t PerceptronPredictor::history_segment(uint32_t start, uint32_t end)
+{
+    uint32_t word = start / 64;
+    uint32_t shift = start % 64;
+    uint32_t width = end - start;
+    uint64_t segment = history[word] >> shift;
+    if (shift != 0 && shift + width > 64)
+    {
+        segment |= history[word + 1] << (64 - shift);
+    }
+    if (width < 64)
+    {
+        segment &= (1ULL << width) - 1;
+    }
+    return segment;
+}
+
+/*
+* Function to find the weight of every perceptron table for a branch, and
+* their sum
+*/
+void PerceptronPredictor::lookup(uint64_t pc, PerceptronLookup *l)
+{
+    uint64_t row_mask = (1ULL << log_rows) - 1;
+    l->pc = pc;
+    l->sum = 0;
+    for (int i = 0; i < PERCEPTRON_NUM_TABLES; i++)
+    {
+        // Fold the segment down to the row index width
+        uint64_t hash = pc ^ (pc >> log_rows);
+        uint64_t segment = history_segment(segment_starts[i], segment_ends[i]);
+        for (; segment != 0; segment >>= log_rows)
+        {
+            hash ^= segment;
+        }
+        l->indices[i] = ((uint64_t)i << log_rows) | (hash & row_mask);
+        l->sum += weights[l->indices[i]];
+    }
+}
+
+/*
+* Function to predict a branch with the hashed perceptron
+*
+* @param pc the address of the branch
+*/
+BranchDirection PerceptronPredictor::predict(uint64_t pc)
+{
+    lookup(pc, &last_lookup);
+    last_lookup_valid = true;
+    return last_lookup.sum >= 0 ? TAKEN : NOT_TAKEN;
+}
+
+/*
+* Function to train the hashed perceptron with the outcome of the branch last
+* predicted
+*
+* @param pc the address of the branch
+* @param resolution the actual outcome of the branch
+*/
+void PerceptronPredictor::update(uint64_t pc, BranchDirection resolution)
+{
+    if (!last_lookup_valid || last_lookup.pc != pc)
+    {
+        lookup(pc, &last_lookup);
+    }
+    last_lookup_valid = false;
+    train(&last_lookup, resolution == TAKEN);
+    push_history(resolution == TAKEN);
+}
+
+/*
+* Function to train the perceptron weights with the outcome of a branch, at
+* the weights its prediction was made from
+*
+* @param l the lookup the branch was predicted with
+* @param taken whether the branch was taken
+*/
+void PerceptronPredictor::train(const PerceptronLookup *l, bool taken)
+{
+    bool mispredicted = (l->sum >= 0) != taken;
+    bool low_confidence = abs(l->sum) <= theta;
+
+    if (mispredicted || low_confidence)
+    {
+        // Move every weight one step towards the outcome, saturating at the
+        // limits of 8 bits
+        for (int i = 0; i < PERCEPTRON_NUM_TABLES; i++)
+        {
+            int8_t &w = weights[l->indices[i]];
+            w = taken ? std::min(w + 1, 127) : std::max(w - 1, -128);
+        }
+    }
+
+    // Raise the threshold when mispredictions dominate the training, and
+    // lower it when correct but unconfident predictions do
+    if (mispredicted)
+    {
+        if (++theta_counter >= 64)
+        {
+            theta++;
+            theta_counter = 0;
         }
     }
-    pattern_history_table[pht_key] = new_state;
+    else if (low_confidence)
+    {
+        if (--theta_counter <= -64)
+        {
+            theta--;
+            theta_counter = 0;
+        }
+    }
+
+}
+
+/*
+* Function to push the outcome of a branch into the perceptron global history
+*
+* @param taken whether the branch was taken
+*/
+void PerceptronPredictor::push_history(bool taken)
+{
+    for (int i = PERCEPTRON_MAX_HISTORY / 64 - 1; i > 0; i--)
+    {
+        history[i] = (history[i] << 1) | (history[i - 1] >> 63);
+    }
+    history[0] = (history[0] << 1) | taken;
+}
+
+/*
+* Function to checkpoint the perceptron global history
+*
+* @param h the checkpoint to fill
+*/
+void PerceptronPredictor::save_history(PerceptronHistory *h)
+{
+    memcpy(h->bits, history, sizeof(history));
+}
+
+/*
+* Function to restore the perceptron global history from a checkpoint
+*
+* @param h the checkpoint
+*/
+void PerceptronPredictor::restore_history(const PerceptronHistory *h)
+{
+    memcpy(history, h->bits, sizeof(history));
 }
 
 /**
@@ -153,11 +760,59 @@ void BPred::update_gshare_prediction(uint64_t pht_key, BranchDirection bdirectio
  * @param policy the policy this branch predictor should use
  */
 BPred::BPred(BPredPolicy policy)
+    : BPred(policy, BPRED_HISTORY_BITS,
+            policy == BPRED_PERCEPTRON ? PERCEPTRON_BUDGET_KB : TAGE_BUDGET_KB)
+{
+}
+
+/**
+ * Construct a branch predictor with the given policy and PHT index width, so
+ * that predictors of several configurations can run side by side.
+ * 
+ * @param policy the policy this branch predictor should use
+ * @param history_bits the number of PC and history bits indexing the PHT
+ * @param budget_kb the storage budget in KB of the TAGE or perceptron
+ *                  predictor
+ */
+BPred::BPred(BPredPolicy policy, uint32_t history_bits, uint32_t budget_kb)
 {
     // TODO: Initialize member variables here.
+    this->policy = policy;
     stat_num_branches = 0;
     stat_num_mispred = 0;
+    stat_local_correct = 0;
+    stat_global_correct = 0;
+    stat_chose_global = 0;
+    stat_history_repairs = 0;
+    next_inflight_id = 0;
     global_history_register = 0;
+
+    // Every counter starts weakly taken (0b10)
+    this->history_bits = history_bits;
+    pht_mask = mask_low_bits(history_bits);
+    uint64_t num_counters = pht_mask + 1;
+    if (policy == BPRED_GSHARE || policy == BPRED_TOURNAMENT)
+    {
+        pattern_history_table.assign((num_counters + BPRED_COUNTERS_PER_BYTE - 1) /
+                                         BPRED_COUNTERS_PER_BYTE,
+                                     0xAA);
+    }
+    if (policy == BPRED_TOURNAMENT)
+    {
+        // Local counters start weakly taken, and the chooser weakly global
+        local_history_table.assign(TOURNAMENT_LOCAL_ENTRIES, 0);
+        local_counters.assign(1ULL << TOURNAMENT_LOCAL_HISTORY_BITS,
+                              TOURNAMENT_LOCAL_COUNTER_MAX / 2 + 1);
+        chooser_table.assign(num_counters, 2);
+    }
+    if (policy == BPRED_TAGE)
+    {
+        tage.init(budget_kb);
+    }
+    if (policy == BPRED_PERCEPTRON)
+    {
+        perceptron.init(budget_kb);
+    }
     // As a reminder, you can declare any additional member variables you need
     // in the BPred class in bpred.h and initialize them here.
 }
@@ -178,17 +833,34 @@ BranchDirection BPred::predict(uint64_t pc)
     // Note that you do not have to handle the BPRED_PERFECT policy here; this
     // function will not be called for that policy.
 
-    if (BPRED_POLICY == BPRED_ALWAYS_TAKEN)
+    if (policy == BPRED_ALWAYS_TAKEN)
     {
         return TAKEN; // This is just a placeholder.
     }
-    else if (BPRED_POLICY == BPRED_GSHARE)
+    else if (policy == BPRED_GSHARE)
     {
         // code for gshare here
         uint64_t pht_key = get_pht_key(pc);
         BPredGharePrediction gshare_state = get_gshare_prediction(pht_key);
         return convert_ghsare_state_direction(gshare_state);
     }
+    else if (policy == BPRED_TAGE)
+    {
+        return tage.predict(pc);
+    }
+    else if (policy == BPRED_PERCEPTRON)
+    {
+        return perceptron.predict(pc);
+    }
+    else if (policy == BPRED_TOURNAMENT)
+    {
+        if (get_chooser_global())
+        {
+            uint64_t pht_key = get_pht_key(pc);
+            return convert_ghsare_state_direction(get_gshare_prediction(pht_key));
+        }
+        return get_local_prediction(pc);
+    }
     // place holder for default return
     return TAKEN;
 }
@@ -216,13 +888,11 @@ void BPred::update(uint64_t pc, BranchDirection prediction,
         stat_num_mispred = sat_increment(stat_num_mispred, UINT64_MAX);
     }
 
-    if (BPRED_POLICY == BPRED_GSHARE)
+    if (policy == BPRED_GSHARE || policy == BPRED_TOURNAMENT)
     {
         //print_branch_state(pc, resolution, prediction);
         // Update the PHT before the GHR is update else the hash key will change
-        // Update the PHT
-        uint64_t pht_key = get_pht_key(pc);
-        update_gshare_prediction(pht_key, resolution);
+        train_global(pc, resolution);
         // Update the GHR
         // Left shift the GHR
         global_history_register = global_history_register << 1;
@@ -232,36 +902,206 @@ void BPred::update(uint64_t pc, BranchDirection prediction,
             global_history_register = global_history_register | 1;
         }
     }
+    else if (policy == BPRED_TAGE)
+    {
+        tage.update(pc, resolution);
+    }
+    else if (policy == BPRED_PERCEPTRON)
+    {
+        perceptron.update(pc, resolution);
+    }
     // TODO: Update any other internal state you may need to keep track of.
 
     // Note that you do not have to handle the BPRED_PERFECT policy here; this
     // function will not be called for that policy.
 }
 
-template<typename K, typename V>
-void print_map(std::unordered_map<K, V> const& m)
-{
-    std::map<uint64_t, BPredGharePrediction> ordered(m.begin(), m.end());
-    for (auto const& pair : ordered) {
-        std::cout << "{" << (unsigned long)(pair.first) << ": ";
-        switch (pair.second)
-        {
-        case STRONGLY_NOTTAKEN:
-            std::cout << "STRONGLY_NOTTAKEN}\n";
-            break;
-        case WEAKLY_NOTTAKEN:
-            std::cout << "WEAKLY_NOTTAKEN}\n";
-            break;
-        case WEAKLY_TAKEN:
-            std::cout << "WEAKLY_TAKEN}\n";
-            break;
-        case STRONGLY_TAKEN:
-            std::cout << "STRONGLY_TAKEN}\n";
-            break;
+/**
+ * Get a prediction for the branch with the given address, and push it into
+ * the global history right away, as a real front end does. The history
+ * before the prediction is checkpointed until the branch resolves.
+ *
+ * @param pc the address (program counter) of the branch to predict
+ * @param inflight_id set to the id to resolve the branch with
+ * @return the prediction for whether the branch is taken or not taken
+ */
+BranchDirection BPred::predict_speculative(uint64_t pc, uint64_t *inflight_id)
+{
+    BPredInflight b;
+    b.id = next_inflight_id++;
+    b.pc = pc;
+    b.global_history_register = global_history_register;
+    if (policy == BPRED_TAGE)
+    {
+        tage.save_history(&b.tage_history);
+        tage.lookup(pc, &b.tage_lookup);
+        b.prediction = b.tage_lookup.pred ? TAKEN : NOT_TAKEN;
+        tage.push_history(pc, b.prediction == TAKEN);
+    }
+    else if (policy == BPRED_PERCEPTRON)
+    {
+        perceptron.save_history(&b.perceptron_history);
+        perceptron.lookup(pc, &b.perceptron_lookup);
+        b.prediction = b.perceptron_lookup.sum >= 0 ? TAKEN : NOT_TAKEN;
+        perceptron.push_history(b.prediction == TAKEN);
+    }
+    else if (policy == BPRED_TOURNAMENT)
+    {
+        const TournamentLookup &l = b.tournament_lookup;
+        lookup_tournament(pc, &b.tournament_lookup);
+        b.prediction = l.chose_global ? l.global_pred : l.local_pred;
+        push_local_history(pc, b.prediction);
+        global_history_register = (global_history_register << 1) |
+                                  b.prediction;
+    }
+    else
+    {
+        b.prediction = predict(pc);
+        global_history_register = (global_history_register << 1) |
+                                  b.prediction;
+    }
+    inflight.push_back(b);
+    *inflight_id = b.id;
+    return b.prediction;
+}
+
+/**
+ * Resolve a branch predicted by predict_speculative(): update the statistics,
+ * train the tables as of its prediction, and on a misprediction restore the
+ * history from its checkpoint with the actual outcome pushed instead.
+ *
+ * @param inflight_id the id the branch was predicted with
+ * @param resolution the actual outcome of the branch
+ */
+void BPred::resolve(uint64_t inflight_id, BranchDirection resolution)
+{
+    // Branches usually resolve in order, so this is nearly always the front
+    auto it = inflight.begin();
+    while (it != inflight.end() && it->id != inflight_id)
+    {
+        it++;
+    }
+    if (it == inflight.end())
+    {
+        return;
+    }
+    const BPredInflight &b = *it;
+
+    stat_num_branches = sat_increment(stat_num_branches, UINT64_MAX);
+    bool mispredicted = b.prediction != resolution;
+    if (mispredicted)
+    {
+        stat_num_mispred = sat_increment(stat_num_mispred, UINT64_MAX);
+    }
+
+    if (policy == BPRED_GSHARE || policy == BPRED_TOURNAMENT)
+    {
+        // Train the tables the prediction was made from, not what the
+        // histories have become since
+        if (policy == BPRED_TOURNAMENT)
+        {
+            train_tournament(&b.tournament_lookup, resolution);
+        }
+        uint64_t speculative_history = global_history_register;
+        global_history_register = b.global_history_register;
+        update_gshare_prediction(get_pht_key(b.pc), resolution);
+        global_history_register = speculative_history;
+    }
+    else if (policy == BPRED_TAGE)
+    {
+        tage.train(&b.tage_lookup, resolution == TAKEN);
+    }
+    else if (policy == BPRED_PERCEPTRON)
+    {
+        perceptron.train(&b.perceptron_lookup, resolution == TAKEN);
+    }
+
+    if (!mispredicted)
+    {
+        inflight.erase(it);
+        return;
+    }
+
+    // The younger branches were on the wrong path
+    stat_history_repairs++;
+    global_history_register = (b.global_history_register << 1) | resolution;
+    if (policy == BPRED_TAGE)
+    {
+        tage.restore_history(&b.tage_history);
+        tage.push_history(b.pc, resolution == TAKEN);
+    }
+    else if (policy == BPRED_PERCEPTRON)
+    {
+        perceptron.restore_history(&b.perceptron_history);
+        perceptron.push_history(resolution == TAKEN);
+    }
+    else if (policy == BPRED_TOURNAMENT)
+    {
+        restore_local_histories(it);
+        push_local_history(b.pc, resolution);
+    }
+    inflight.erase(it, inflight.end());
+}
+
+/**
+ * Drop every branch predicted by predict_speculative() and not resolved yet,
+ * restoring the history from the checkpoint of the oldest one.
+ */
+void BPred::squash_inflight()
+{
+    if (inflight.empty())
+    {
+        return;
+    }
+    const BPredInflight &b = inflight.front();
+    global_history_register = b.global_history_register;
+    if (policy == BPRED_TAGE)
+    {
+        tage.restore_history(&b.tage_history);
+    }
+    else if (policy == BPRED_PERCEPTRON)
+    {
+        perceptron.restore_history(&b.perceptron_history);
+    }
+    else if (policy == BPRED_TOURNAMENT)
+    {
+        restore_local_histories(inflight.begin());
+    }
+    inflight.clear();
+}
+
+/*
+* Function to print the PHT counters that have left the reset state
+*/
+static void print_pht(BPred *bpred)
+{
+    if (bpred->pattern_history_table.empty())
+    {
+        return;
+    }
+    for (uint64_t key = 0; key <= bpred->pht_mask; key++)
+    {
+        BPredGharePrediction state = bpred->get_gshare_prediction(key);
+        if (state == WEAKLY_TAKEN)
+        {
+            continue;
+        }
+        std::cout << "{" << (unsigned long)(key) << ": ";
+        switch (state)
+        {
+        case STRONGLY_NOTTAKEN:
+            std::cout << "STRONGLY_NOTTAKEN}\n";
+            break;
+        case WEAKLY_NOTTAKEN:
+            std::cout << "WEAKLY_NOTTAKEN}\n";
+            break;
+        case STRONGLY_TAKEN:
+            std::cout << "STRONGLY_TAKEN}\n";
+            break;
         default:
-            break;
-        }
-    }
+            break;
+        }
+    }
 }
 
 /*
@@ -276,6 +1116,6 @@ void BPred::print_branch_state(uint64_t pc, BranchDirection resolution, BranchDi
     std::cout << (unsigned long)(global_history_register);
     std::cout << "\nPHT Key                   = " << (unsigned long)(get_pht_key(pc));
     std::cout << "\nPattern history table state\n";
-    print_map<uint64_t, BPredGharePrediction>(pattern_history_table);
+    print_pht(this);
     std::cout << "\n\n";
 }
@@ -13,7 +13,48 @@
 #define _BPRED_H_
 
 #include <inttypes.h>
-#include <unordered_map>
+#include <deque>
+#include <vector>
+
+/** The default number of PC and global history bits that index the PHT. */
+#define BPRED_DEFAULT_HISTORY_BITS 12
+
+/** The number of 2-bit PHT counters packed into each byte. */
+#define BPRED_COUNTERS_PER_BYTE 4
+
+/** The number of local histories of the tournament predictor. */
+#define TOURNAMENT_LOCAL_ENTRIES 1024
+
+/** The number of past outcomes each local history holds. */
+#define TOURNAMENT_LOCAL_HISTORY_BITS 10
+
+/** The maximum value of the 3-bit local prediction counters. */
+#define TOURNAMENT_LOCAL_COUNTER_MAX 7
+
+/** The default storage budget of the TAGE predictor in KB. */
+#define TAGE_DEFAULT_BUDGET_KB 8
+
+/** The number of tagged tables of the TAGE predictor. */
+#define TAGE_NUM_TABLES 7
+
+/** The global history lengths of the shortest and longest tagged tables. */
+#define TAGE_MIN_HISTORY 4
+#define TAGE_MAX_HISTORY 256
+
+/** The size of the circular global history buffer, a power of two. */
+#define TAGE_HISTORY_BUFFER 512
+
+/** The number of updates between two halvings of the useful counters. */
+#define TAGE_USEFUL_RESET_PERIOD (1 << 18)
+
+/** The default storage budget of the hashed perceptron predictor in KB. */
+#define PERCEPTRON_DEFAULT_BUDGET_KB 8
+
+/** The number of weight tables of the hashed perceptron predictor. */
+#define PERCEPTRON_NUM_TABLES 16
+
+/** The global history length split into segments across the tables. */
+#define PERCEPTRON_MAX_HISTORY 128
 
 /**
  * The possible branch prediction policies the simulator can use.
@@ -25,6 +66,9 @@ typedef enum BPredPolicyEnum
     BPRED_PERFECT,      // The branch predictor is (magically) always correct.
     BPRED_ALWAYS_TAKEN, // The branch predictor always predicts a branch taken.
     BPRED_GSHARE,       // The branch predictor uses the Gshare algorithm.
+    BPRED_TAGE,         // The branch predictor uses the TAGE algorithm.
+    BPRED_PERCEPTRON,   // The branch predictor uses a hashed perceptron.
+    BPRED_TOURNAMENT,   // The branch predictor chooses between local and gshare.
     NUM_BPRED_POLICIES
 } BPredPolicy;
 
@@ -50,6 +94,250 @@ typedef enum BPredGharePredictionEnum
     STRONGLY_NOTTAKEN
 } BPredGharePrediction;
 
+/*
+* An entry of a TAGE tagged table
+*/
+typedef struct TageEntryStruct
+{
+    int8_t ctr;   // 3-bit signed prediction counter, taken if >= 0
+    uint8_t u;    // 2-bit useful counter
+    uint16_t tag; // Partial tag of the branch and history
+} TageEntry;
+
+/*
+* A global history of some length folded by XOR down to a few bits, updated
+* incrementally as a circular shift register
+*/
+typedef struct FoldedHistoryStruct
+{
+    uint32_t comp;      // The folded history
+    uint32_t length;    // The number of history bits folded
+    uint32_t width;     // The number of bits they are folded into
+    uint32_t out_point; // Where the bit leaving the history is folded out
+} FoldedHistory;
+
+/*
+* The tables entries a TAGE prediction was made from, kept from predict() to
+* update()
+*/
+typedef struct TageLookupStruct
+{
+    uint64_t pc;
+    uint32_t indices[TAGE_NUM_TABLES];
+    uint16_t tags[TAGE_NUM_TABLES];
+    uint32_t bimodal_index;
+    int provider;      // The longest-history hitting table, or -1
+    int alt;           // The next hitting table, or -1 for the bimodal table
+    bool provider_pred;
+    bool alt_pred;
+    bool pred;
+} TageLookup;
+
+/*
+* A checkpoint of the TAGE global and path histories
+*/
+typedef struct TageHistoryStruct
+{
+    uint32_t history_ptr;
+    uint32_t path_history;
+    uint32_t index_comps[TAGE_NUM_TABLES];
+    uint32_t tag_comps[2][TAGE_NUM_TABLES];
+} TageHistory;
+
+/**
+ * A TAGE predictor: a bimodal base predictor and TAGE_NUM_TABLES tagged tables
+ * indexed with geometrically increasing global history lengths. The longest
+ * history that hits provides the prediction, and a misprediction allocates an
+ * entry in a table with a longer history.
+ */
+class TagePredictor
+{
+public:
+    /** The total number of bits of state of the predictor. */
+    uint64_t storage_bits;
+
+    /**
+     * Size the tables to fit the given storage budget and reset them. The
+     * bimodal table takes about an eighth of the budget.
+     * 
+     * @param budget_kb the storage budget in KB
+     */
+    void init(uint32_t budget_kb);
+
+    /**
+     * Predict the branch with the given address.
+     * 
+     * @param pc the address of the branch
+     * @return the prediction for whether the branch is taken or not taken
+     */
+    BranchDirection predict(uint64_t pc);
+
+    /**
+     * Train the tables with the outcome of the branch last predicted, and
+     * push the outcome into the global history.
+     * 
+     * @param pc the address of the branch
+     * @param resolution the actual outcome of the branch
+     */
+    void update(uint64_t pc, BranchDirection resolution);
+
+    /*
+    * Functions to predict and train a branch in separate steps, so that the
+    * history can move on speculatively in between
+    */
+    void lookup(uint64_t pc, TageLookup *l);
+    void train(const TageLookup *l, bool taken);
+    void push_history(uint64_t pc, bool taken);
+    void save_history(TageHistory *h);
+    void restore_history(const TageHistory *h);
+
+private:
+    uint32_t log_bimodal;
+    uint32_t log_tagged;
+    uint32_t tag_bits[TAGE_NUM_TABLES];
+    uint32_t history_lengths[TAGE_NUM_TABLES];
+
+    /* Bimodal 2-bit counters, taken if >= 2 */
+    std::vector<uint8_t> bimodal;
+    std::vector<TageEntry> tables[TAGE_NUM_TABLES];
+
+    /* Circular global history, newest outcome at history_ptr */
+    uint8_t history[TAGE_HISTORY_BUFFER];
+    uint32_t history_ptr;
+    uint32_t path_history;
+    FoldedHistory index_folds[TAGE_NUM_TABLES];
+    FoldedHistory tag_folds[2][TAGE_NUM_TABLES];
+
+    /* Whether to trust the alternate prediction over a new provider entry */
+    int8_t use_alt_on_na;
+    uint64_t num_updates;
+    uint32_t random_state;
+
+    TageLookup last_lookup;
+    bool last_lookup_valid;
+
+    void fold_update(FoldedHistory *f);
+};
+
+/*
+* The weights a hashed perceptron prediction was made from, kept from
+* predict() to update()
+*/
+typedef struct PerceptronLookupStruct
+{
+    uint64_t pc;
+    uint32_t indices[PERCEPTRON_NUM_TABLES];
+    int32_t sum;
+} PerceptronLookup;
+
+/*
+* A checkpoint of the perceptron global history
+*/
+typedef struct PerceptronHistoryStruct
+{
+    uint64_t bits[PERCEPTRON_MAX_HISTORY / 64];
+} PerceptronHistory;
+
+/**
+ * A hashed perceptron predictor: PERCEPTRON_NUM_TABLES tables of 8-bit
+ * weights, the first indexed by the branch address alone and each other by
+ * the address hashed with its own segment of the global history. The sign of
+ * the sum of the selected weights is the prediction, and the weights train
+ * on a misprediction or when the sum is below an adaptive threshold.
+ */
+class PerceptronPredictor
+{
+public:
+    /** The total number of bits of state of the predictor. */
+    uint64_t storage_bits;
+
+    /**
+     * Size the tables to fit the given storage budget and reset them.
+     * 
+     * @param budget_kb the storage budget in KB
+     */
+    void init(uint32_t budget_kb);
+
+    /**
+     * Predict the branch with the given address.
+     * 
+     * @param pc the address of the branch
+     * @return the prediction for whether the branch is taken or not taken
+     */
+    BranchDirection predict(uint64_t pc);
+
+    /**
+     * Train the weights with the outcome of the branch last predicted, and
+     * push the outcome into the global history.
+     * 
+     * @param pc the address of the branch
+     * @param resolution the actual outcome of the branch
+     */
+    void update(uint64_t pc, BranchDirection resolution);
+
+    /*
+    * Functions to predict and train a branch in separate steps, so that the
+    * history can move on speculatively in between
+    */
+    void lookup(uint64_t pc, PerceptronLookup *l);
+    void train(const PerceptronLookup *l, bool taken);
+    void push_history(bool taken);
+    void save_history(PerceptronHistory *h);
+    void restore_history(const PerceptronHistory *h);
+
+private:
+    uint32_t log_rows;
+    uint32_t segment_starts[PERCEPTRON_NUM_TABLES];
+    uint32_t segment_ends[PERCEPTRON_NUM_TABLES];
+
+    /* The weights of every table, one table after the other */
+    std::vector<int8_t> weights;
+
+    /* Global history, newest outcome in bit 0 of history[0] */
+    uint64_t history[PERCEPTRON_MAX_HISTORY / 64];
+
+    /* Training threshold, and the counter that adapts it */
+    int32_t theta;
+    int32_t theta_counter;
+
+    PerceptronLookup last_lookup;
+    bool last_lookup_valid;
+
+    uint64_t history_segment(uint32_t start, uint32_t end);
+};
+
+/*
+* The components a tournament prediction was made from, kept from
+* predict_speculative() to resolve(). The local history is the one before the
+* prediction was pushed into it, so it is also the checkpoint to repair from.
+*/
+typedef struct TournamentLookupStruct
+{
+    uint32_t chooser_index;
+    uint16_t local_history;
+    BranchDirection local_pred;
+    BranchDirection global_pred;
+    bool chose_global;
+} TournamentLookup;
+
+/*
+* A branch predicted with a speculatively updated history and not resolved
+* yet: the history before its prediction, and the table entries the
+* prediction was made from
+*/
+typedef struct BPredInflightStruct
+{
+    uint64_t id;
+    uint64_t pc;
+    BranchDirection prediction;
+    uint64_t global_history_register;
+    TageLookup tage_lookup;
+    TageHistory tage_history;
+    PerceptronLookup perceptron_lookup;
+    PerceptronHistory perceptron_history;
+    TournamentLookup tournament_lookup;
+} BPredInflight;
+
 /**
  * A branch predictor.
  * 
@@ -71,8 +359,50 @@ public:
     /* Global history register */
     uint64_t global_history_register;
 
-    /* Patter history table */
-    std::unordered_map<uint64_t, BPredGharePrediction> pattern_history_table;
+    /* Number of PC and global history bits that index the PHT */
+    uint32_t history_bits;
+
+    /* Mask of the low history_bits bits */
+    uint64_t pht_mask;
+
+    /*
+    * Pattern history table: 2^history_bits 2-bit saturating counters, packed
+    * four per byte, where 0 is strongly not taken and 3 is strongly taken
+    */
+    std::vector<uint8_t> pattern_history_table;
+
+    /* TAGE predictor, used by the BPRED_TAGE policy */
+    TagePredictor tage;
+
+    /* Hashed perceptron predictor, used by the BPRED_PERCEPTRON policy */
+    PerceptronPredictor perceptron;
+
+    /*
+    * Tournament predictor, after the Alpha 21264: per-branch local histories
+    * index 3-bit counters, the PHT above is the global component, and 2-bit
+    * chooser counters indexed by the global history pick between the two,
+    * where 0 and 1 choose local and 2 and 3 choose global
+    */
+    std::vector<uint16_t> local_history_table;
+    std::vector<uint8_t> local_counters;
+    std::vector<uint8_t> chooser_table;
+
+    /* Number of branches each tournament component predicted correctly */
+    uint64_t stat_local_correct;
+    uint64_t stat_global_correct;
+
+    /* Number of branches the chooser sent to the global component */
+    uint64_t stat_chose_global;
+
+    /*
+    * Branches predicted by predict_speculative() and not resolved yet,
+    * oldest first, and the id of the next one
+    */
+    std::deque<BPredInflight> inflight;
+    uint64_t next_inflight_id;
+
+    /* Number of times a misprediction repaired the speculative history */
+    uint64_t stat_history_repairs;
 
     /**
      * Construct a branch predictor with the given policy.
@@ -83,6 +413,22 @@ public:
      */
     BPred(BPredPolicy policy);
 
+    /**
+     * Construct a branch predictor with the given policy and PHT index width,
+     * so that predictors of several configurations can run side by side.
+     * 
+     * @param policy the policy this branch predictor should use
+     * @param history_bits the number of PC and history bits indexing the PHT
+     * @param budget_kb the storage budget in KB of the TAGE or perceptron
+     *                  predictor
+     */
+    BPred(BPredPolicy policy, uint32_t history_bits, uint32_t budget_kb);
+
+    /*
+    * Function to get the storage of the predictor's tables in bits
+    */
+    uint64_t storage_bits();
+
     /**
      * Get a prediction for the branch with the given address.
      * 
@@ -107,6 +453,41 @@ public:
     void update(uint64_t pc, BranchDirection prediction,
                 BranchDirection resolution);
 
+    /**
+     * Get a prediction for the branch with the given address, and push it
+     * into the global history right away, as a real front end does. The
+     * history before the prediction is checkpointed until the branch
+     * resolves.
+     * 
+     * @param pc the address (program counter) of the branch to predict
+     * @param inflight_id set to the id to resolve the branch with
+     * @return the prediction for whether the branch is taken or not taken
+     */
+    BranchDirection predict_speculative(uint64_t pc, uint64_t *inflight_id);
+
+    /**
+     * Resolve a branch predicted by predict_speculative(): update the
+     * statistics, train the tables as of its prediction, and on a
+     * misprediction restore the history from its checkpoint with the
+     * actual outcome pushed instead.
+     * 
+     * @param inflight_id the id the branch was predicted with
+     * @param resolution the actual outcome of the branch
+     */
+    void resolve(uint64_t inflight_id, BranchDirection resolution);
+
+    /**
+     * Drop every branch predicted by predict_speculative() and not resolved
+     * yet, restoring the history from the checkpoint of the oldest one.
+     */
+    void squash_inflight();
+
+    /*
+    * Function to train the gshare PHT and the tournament tables with the
+    * current global history
+    */
+    void train_global(uint64_t pc, BranchDirection resolution);
+
     /*
     * Function to get the PHT key from the pc
     */
@@ -122,6 +503,38 @@ public:
     */
     void update_gshare_prediction(uint64_t pht_key, BranchDirection bdirection);
 
+    /*
+    * Function to get the local component's prediction for the pc
+    */
+    BranchDirection get_local_prediction(uint64_t pc);
+
+    /*
+    * Function to push an outcome into the local history of the pc
+    */
+    void push_local_history(uint64_t pc, BranchDirection bdirection);
+
+    /*
+    * Function to find the components of a tournament prediction for the pc
+    */
+    void lookup_tournament(uint64_t pc, TournamentLookup *l);
+
+    /*
+    * Function to train the chooser and the local counter a tournament
+    * prediction was made from, and count which component was right
+    */
+    void train_tournament(const TournamentLookup *l, BranchDirection resolution);
+
+    /*
+    * Function to restore the local histories of the in-flight branches from
+    * the given one to the youngest
+    */
+    void restore_local_histories(std::deque<BPredInflight>::iterator from);
+
+    /*
+    * Function to check whether the chooser picks the global component
+    */
+    bool get_chooser_global();
+
     /*
     * Function to print the GHR and PHT
     */
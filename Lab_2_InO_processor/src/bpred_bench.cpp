@@ -0,0 +1,77 @@
+// bpred_bench.cpp
+// Times the branch predictor on its own, outside the pipeline: predict and
+// update pairs over a synthetic stream of conditional branches.
+//
+// Build with "make bench", and run as
+//     ./bpred_bench [policy] [branches] [pcs] [taken_percent]
+// where policy is the -bpredpolicy number (default 2, gshare). The stream is
+// fixed by its arguments, so the misprediction count must not change when
+// only the speed of the predictor does.
+
+#include "bpred.h"
+#include "pipeline.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// The predictor sizes, which sim.cpp otherwise sets from the command line
+uint32_t BPRED_HISTORY_BITS = BPRED_DEFAULT_HISTORY_BITS;
+uint32_t TAGE_BUDGET_KB = TAGE_DEFAULT_BUDGET_KB;
+uint32_t PERCEPTRON_BUDGET_KB = PERCEPTRON_DEFAULT_BUDGET_KB;
+
+/*
+* Number of branches generated ahead of the timed loop, and replayed as many
+* times as needed, so that generating them is not timed
+*/
+#define BENCH_STREAM_LENGTH (1 << 20)
+
+int main(int argc, char **argv)
+{
+    int policy = (argc > 1) ? atoi(argv[1]) : BPRED_GSHARE;
+    uint64_t num_branches = (argc > 2) ? strtoull(argv[2], NULL, 10) : 20000000;
+    uint32_t num_pcs = (argc > 3) ? atoi(argv[3]) : 3000;
+    uint32_t taken_percent = (argc > 4) ? atoi(argv[4]) : 70;
+    if (policy < 0 || policy >= NUM_BPRED_POLICIES || num_pcs == 0)
+    {
+        fprintf(stderr, "Usage: %s [policy] [branches] [pcs] "
+                "[taken_percent]\n", argv[0]);
+        return 1;
+    }
+
+    // A fixed-seed LCG, so that every build sees the same stream
+    std::vector<uint64_t> pcs(BENCH_STREAM_LENGTH);
+    std::vector<BranchDirection> directions(BENCH_STREAM_LENGTH);
+    uint64_t seed = 42;
+    for (uint32_t i = 0; i < BENCH_STREAM_LENGTH; i++)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        pcs[i] = 0x400000 + 4 * ((seed >> 33) % num_pcs);
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        directions[i] = ((seed >> 33) % 100 < taken_percent) ? TAKEN
+                                                              : NOT_TAKEN;
+    }
+
+    BPred *bpred = new BPred((BPredPolicy)policy);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_branches; i++)
+    {
+        uint32_t slot = i & (BENCH_STREAM_LENGTH - 1);
+        BranchDirection prediction = bpred->predict(pcs[slot]);
+        bpred->update(pcs[slot], prediction, directions[slot]);
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+
+    printf("BENCH_POLICY           \t\t : %10d\n", policy);
+    printf("BENCH_BRANCHES         \t\t : %10llu\n",
+           (unsigned long long)bpred->stat_num_branches);
+    printf("BENCH_MISPRED          \t\t : %10llu\n",
+           (unsigned long long)bpred->stat_num_mispred);
+    printf("BENCH_SECONDS          \t\t : %10.3f\n", seconds);
+    printf("BENCH_MBRANCHES_PER_SEC\t\t : %10.1f\n",
+           num_branches / seconds / 1e6);
+    delete bpred;
+    return 0;
+}
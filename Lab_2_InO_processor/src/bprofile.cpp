@@ -0,0 +1,110 @@
+// bprofile.cpp
+// Implements the branch profiler class.
+
+#include "bprofile.h"
+#include <algorithm>
+
+/**
+ * Construct an empty profiler.
+ *
+ * @param capacity the number of branches to track
+ */
+BranchProfiler::BranchProfiler(uint32_t capacity)
+{
+    this->capacity = capacity;
+    entries.reserve(capacity);
+    slots.reserve(capacity);
+    stat_evictions = 0;
+    stat_total_cycles = 0;
+}
+
+/*
+* Function to find the counters of a branch, replacing the tracked branch
+* that lost the fewest cycles if it is not tracked yet
+*/
+BranchProfileEntry *BranchProfiler::find_or_insert(uint64_t pc)
+{
+    auto slot = slots.find(pc);
+    if (slot != slots.end())
+    {
+        return &entries[slot->second];
+    }
+
+    if (entries.size() < capacity)
+    {
+        BranchProfileEntry entry = {pc, 0, 0, 0, 0, 0};
+        entries.push_back(entry);
+        slots[pc] = entries.size() - 1;
+        by_cycles.insert(std::make_pair(0, entries.size() - 1));
+        return &entries.back();
+    }
+
+    // The new branch may have lost as many cycles as the one it replaces,
+    // so it inherits them; its place in by_cycles does not change
+    uint32_t victim = by_cycles.begin()->second;
+    BranchProfileEntry *entry = &entries[victim];
+    slots.erase(entry->pc);
+    slots[pc] = victim;
+    stat_evictions++;
+    uint64_t cycles = entry->cycles;
+    *entry = {pc, 0, 0, 0, cycles, cycles};
+    return entry;
+}
+
+/**
+ * Count one execution of a conditional branch.
+ *
+ * @param pc the address of the branch
+ * @param taken whether it was taken
+ * @param mispredicted whether its direction was mispredicted
+ */
+void BranchProfiler::record_branch(uint64_t pc, bool taken, bool mispredicted)
+{
+    BranchProfileEntry *entry = find_or_insert(pc);
+    entry->execs++;
+    entry->taken += taken;
+    entry->mispreds += mispredicted;
+}
+
+/**
+ * Charge fetch cycles lost to a branch.
+ *
+ * @param pc the address of the branch
+ * @param cycles the number of cycles
+ */
+void BranchProfiler::add_cycles(uint64_t pc, uint64_t cycles)
+{
+    BranchProfileEntry *entry = find_or_insert(pc);
+    uint32_t slot = entry - &entries[0];
+    by_cycles.erase(std::make_pair(entry->cycles, slot));
+    entry->cycles += cycles;
+    by_cycles.insert(std::make_pair(entry->cycles, slot));
+    stat_total_cycles += cycles;
+}
+
+/**
+ * Get the tracked branches that surely lost the most cycles, leaving out
+ * the cycles they may have inherited.
+ *
+ * @param k the maximum number of branches to return
+ * @return the branches, the costliest first
+ */
+std::vector<BranchProfileEntry> BranchProfiler::top(uint32_t k)
+{
+    std::vector<BranchProfileEntry> sorted = entries;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const BranchProfileEntry &a, const BranchProfileEntry &b) {
+                  uint64_t a_cycles = a.cycles - a.error;
+                  uint64_t b_cycles = b.cycles - b.error;
+                  if (a_cycles != b_cycles)
+                  {
+                      return a_cycles > b_cycles;
+                  }
+                  return a.mispreds > b.mispreds;
+              });
+    if (sorted.size() > k)
+    {
+        sorted.resize(k);
+    }
+    return sorted;
+}
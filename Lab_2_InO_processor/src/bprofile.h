@@ -0,0 +1,98 @@
+// bprofile.h
+// Declares the branch profiler class, which finds the static branches that
+// cost the pipeline the most cycles.
+
+#ifndef _BPROFILE_H_
+#define _BPROFILE_H_
+
+#include <inttypes.h>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * The number of branches the profiler tracks for each one it reports, so
+ * that the reported ones are unlikely to have been evicted on the way.
+ */
+#define BPROFILE_SLOTS_PER_REPORTED 8
+
+/*
+* The counters of a static branch
+*/
+typedef struct BranchProfileEntryStruct
+{
+    uint64_t pc;
+    uint64_t execs;    // Times it was fetched
+    uint64_t mispreds; // Times its direction was mispredicted
+    uint64_t taken;    // Times it was taken
+    uint64_t cycles;   // Fetch cycles lost to it, including error
+    uint64_t error;    // Cycles inherited from the branch it replaced
+} BranchProfileEntry;
+
+/**
+ * A per-branch profile of executions, mispredictions and the fetch cycles
+ * lost to each static conditional branch.
+ *
+ * Memory stays flat however many branches the trace has: a fixed number of
+ * branches are tracked, and a new one replaces the one that lost the fewest
+ * cycles, inheriting its count as an upper bound on the error (the
+ * Space-Saving algorithm). A branch that lost more cycles than any replaced
+ * one is always tracked.
+ */
+class BranchProfiler
+{
+public:
+    /** The number of times a tracked branch was replaced by a new one. */
+    uint64_t stat_evictions;
+
+    /** The total number of fetch cycles lost to any branch. */
+    uint64_t stat_total_cycles;
+
+    /**
+     * Construct an empty profiler.
+     *
+     * @param capacity the number of branches to track
+     */
+    BranchProfiler(uint32_t capacity);
+
+    /**
+     * Count one execution of a conditional branch.
+     *
+     * @param pc the address of the branch
+     * @param taken whether it was taken
+     * @param mispredicted whether its direction was mispredicted
+     */
+    void record_branch(uint64_t pc, bool taken, bool mispredicted);
+
+    /**
+     * Charge fetch cycles lost to a branch.
+     *
+     * @param pc the address of the branch
+     * @param cycles the number of cycles
+     */
+    void add_cycles(uint64_t pc, uint64_t cycles);
+
+    /**
+     * Get the tracked branches that surely lost the most cycles, leaving
+     * out the cycles they may have inherited.
+     *
+     * @param k the maximum number of branches to return
+     * @return the branches, the costliest first
+     */
+    std::vector<BranchProfileEntry> top(uint32_t k);
+
+private:
+    uint32_t capacity;
+    std::vector<BranchProfileEntry> entries;
+
+    /* The slot of each tracked branch */
+    std::unordered_map<uint64_t, uint32_t> slots;
+
+    /* The slots ordered by cycles, to find the one to replace */
+    std::set<std::pair<uint64_t, uint32_t>> by_cycles;
+
+    BranchProfileEntry *find_or_insert(uint64_t pc);
+};
+
+#endif
@@ -0,0 +1,172 @@
+// btb.cpp
+// Implements the branch target buffer and return address stack classes.
+
+#include "btb.h"
+#include <stddef.h>
+
+/**
+ * Construct an empty branch target buffer.
+ *
+ * @param num_entries the total number of entries, a multiple of assoc
+ * @param assoc the number of entries per set
+ * @param policy the replacement policy
+ */
+BTB::BTB(uint32_t num_entries, uint32_t assoc, BTBReplPolicy policy)
+{
+    this->num_sets = num_entries / assoc;
+    this->assoc = assoc;
+    this->policy = policy;
+    BTBEntry empty = {false, 0, 0, 0};
+    entries.assign(num_entries, empty);
+    num_accesses = 0;
+    random_state = 1;
+    stat_lookups = 0;
+    stat_hits = 0;
+    stat_target_mispred = 0;
+}
+
+/*
+* Function to find the entry of a control transfer, or NULL if it has none
+*/
+BTBEntry *BTB::find(uint64_t pc)
+{
+    BTBEntry *set = &entries[(pc % num_sets) * assoc];
+    for (uint32_t way = 0; way < assoc; way++)
+    {
+        if (set[way].valid && set[way].tag == pc)
+        {
+            return &set[way];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Look up the target of the control transfer with the given address.
+ *
+ * @param pc the address of the control transfer
+ * @param target set to the predicted target on a hit
+ * @return whether the buffer holds an entry for pc
+ */
+bool BTB::predict(uint64_t pc, uint64_t *target)
+{
+    stat_lookups++;
+    BTBEntry *entry = find(pc);
+    if (entry == NULL)
+    {
+        return false;
+    }
+    stat_hits++;
+    if (policy == BTB_REPL_LRU)
+    {
+        entry->stamp = ++num_accesses;
+    }
+    *target = entry->target;
+    return true;
+}
+
+/**
+ * Record the actual target of a taken control transfer, installing an entry
+ * for it if needed.
+ *
+ * @param pc the address of the control transfer
+ * @param target the address it went to
+ */
+void BTB::update(uint64_t pc, uint64_t target)
+{
+    BTBEntry *entry = find(pc);
+    if (entry != NULL)
+    {
+        if (entry->target != target)
+        {
+            stat_target_mispred++;
+            entry->target = target;
+        }
+        return;
+    }
+
+    // Fill an invalid way first, else evict by the replacement policy
+    BTBEntry *set = &entries[(pc % num_sets) * assoc];
+    BTBEntry *victim = NULL;
+    for (uint32_t way = 0; way < assoc && victim == NULL; way++)
+    {
+        if (!set[way].valid)
+        {
+            victim = &set[way];
+        }
+    }
+    if (victim == NULL && policy == BTB_REPL_RANDOM)
+    {
+        random_state = random_state * 1103515245 + 12345;
+        victim = &set[(random_state >> 16) % assoc];
+    }
+    else if (victim == NULL)
+    {
+        // Both LRU and FIFO evict the oldest stamp
+        victim = &set[0];
+        for (uint32_t way = 1; way < assoc; way++)
+        {
+            if (set[way].stamp < victim->stamp)
+            {
+                victim = &set[way];
+            }
+        }
+    }
+    victim->valid = true;
+    victim->tag = pc;
+    victim->target = target;
+    victim->stamp = ++num_accesses;
+}
+
+/**
+ * Construct an empty return address stack.
+ *
+ * @param num_entries the number of entries, after which the oldest ones are
+ *                    overwritten
+ */
+ReturnAddressStack::ReturnAddressStack(uint32_t num_entries)
+{
+    stack.assign(num_entries, 0);
+    top = 0;
+    count = 0;
+    stat_returns = 0;
+}
+
+/**
+ * Push the address of a possible call.
+ *
+ * @param call_pc the address of the call
+ */
+void ReturnAddressStack::push(uint64_t call_pc)
+{
+    top = (top + 1) % stack.size();
+    stack[top] = call_pc;
+    if (count < stack.size())
+    {
+        count++;
+    }
+}
+
+/**
+ * Find the call a control transfer returns from, as the newest entry it lands
+ * just after, and pop that entry and any above it.
+ *
+ * @param target the address the control transfer went to
+ * @return whether the transfer is a return predicted by the stack
+ */
+bool ReturnAddressStack::pop_return(uint64_t target)
+{
+    for (uint32_t depth = 0; depth < count; depth++)
+    {
+        uint64_t call_pc = stack[(top + stack.size() - depth) % stack.size()];
+        if (target > call_pc && target - call_pc <= MAX_INST_LENGTH)
+        {
+            // The entries above the call were jumps
+            top = (top + stack.size() - depth - 1) % stack.size();
+            count -= depth + 1;
+            stat_returns++;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,145 @@
+// btb.h
+// Declares the branch target buffer and return address stack classes, which
+// predict at fetch where taken control transfers go.
+
+#ifndef _BTB_H_
+#define _BTB_H_
+
+#include <inttypes.h>
+#include <vector>
+
+/** The default associativity of the branch target buffer. */
+#define BTB_DEFAULT_ASSOC 4
+
+/** The default number of entries of the return address stack. */
+#define RAS_DEFAULT_ENTRIES 16
+
+/** The default number of cycles fetch is idle after a target misprediction. */
+#define BTB_DEFAULT_MISS_PENALTY 1
+
+/**
+ * The maximum length of an instruction in bytes: an instruction at most this
+ * far after another one follows it sequentially.
+ */
+#define MAX_INST_LENGTH 15
+
+/** The possible replacement policies of the branch target buffer. */
+typedef enum BTBReplPolicyEnum
+{
+    BTB_REPL_LRU,    // Evict the least recently used entry.
+    BTB_REPL_FIFO,   // Evict the entry installed first.
+    BTB_REPL_RANDOM, // Evict a random entry.
+    NUM_BTB_REPL_POLICIES
+} BTBReplPolicy;
+
+/*
+* An entry of the branch target buffer
+*/
+typedef struct BTBEntryStruct
+{
+    bool valid;
+    uint64_t tag;    // The address of the control transfer
+    uint64_t target; // The address it last went to
+    uint64_t stamp;  // When it was last used or installed, for replacement
+} BTBEntry;
+
+/**
+ * A set-associative branch target buffer, holding the last target of each
+ * taken control transfer.
+ */
+class BTB
+{
+public:
+    /** The number of lookups, and how many of them found an entry. */
+    uint64_t stat_lookups;
+    uint64_t stat_hits;
+
+    /** The number of entries found that held a stale target. */
+    uint64_t stat_target_mispred;
+
+    /**
+     * Construct an empty branch target buffer.
+     *
+     * @param num_entries the total number of entries, a multiple of assoc
+     * @param assoc the number of entries per set
+     * @param policy the replacement policy
+     */
+    BTB(uint32_t num_entries, uint32_t assoc, BTBReplPolicy policy);
+
+    /**
+     * Look up the target of the control transfer with the given address.
+     *
+     * @param pc the address of the control transfer
+     * @param target set to the predicted target on a hit
+     * @return whether the buffer holds an entry for pc
+     */
+    bool predict(uint64_t pc, uint64_t *target);
+
+    /**
+     * Record the actual target of a taken control transfer, installing an
+     * entry for it if needed.
+     *
+     * @param pc the address of the control transfer
+     * @param target the address it went to
+     */
+    void update(uint64_t pc, uint64_t target);
+
+private:
+    uint32_t num_sets;
+    uint32_t assoc;
+    BTBReplPolicy policy;
+
+    /* The entries of every set, one set after the other */
+    std::vector<BTBEntry> entries;
+    uint64_t num_accesses;
+    uint32_t random_state;
+
+    BTBEntry *find(uint64_t pc);
+};
+
+/**
+ * A circular return address stack. Calls push their own address, and a
+ * return is predicted to go just after a call on the stack.
+ *
+ * The trace does not tell calls from jumps, so every jump is pushed as a
+ * possible call; a return then pops the newest call it lands after, along
+ * with the jumps pushed above it. Jumps still take up entries, so a small
+ * stack loses calls sooner than it would in hardware.
+ */
+class ReturnAddressStack
+{
+public:
+    /** The number of returns predicted. */
+    uint64_t stat_returns;
+
+    /**
+     * Construct an empty return address stack.
+     *
+     * @param num_entries the number of entries, after which the oldest ones
+     *                    are overwritten
+     */
+    ReturnAddressStack(uint32_t num_entries);
+
+    /**
+     * Push the address of a possible call.
+     *
+     * @param call_pc the address of the call
+     */
+    void push(uint64_t call_pc);
+
+    /**
+     * Find the call a control transfer returns from, as the newest entry it
+     * lands just after, and pop that entry and any above it.
+     *
+     * @param target the address the control transfer went to
+     * @return whether the transfer is a return predicted by the stack
+     */
+    bool pop_return(uint64_t target);
+
+private:
+    std::vector<uint64_t> stack;
+    uint32_t top;
+    uint32_t count;
+};
+
+#endif
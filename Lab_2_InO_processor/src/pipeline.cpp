@@ -13,6 +13,9 @@
 #include <stdio.h>
 #include <unistd.h>
 
+/** The number of trace records read at a time by pipe_skip_insts(). */
+#define PIPE_SKIP_BATCH 1024
+
 /**
  * Read a single trace record from the trace file and use it to populate the
  * given fetch_op.
@@ -82,6 +85,116 @@ void pipe_get_fetch_op(Pipeline* p, PipelineLatch* fetch_op)
     fetch_op->op_id = ++p->last_op_id;
 }
 
+/**
+ * Fast-forward over the next trace records without timing them.
+ *
+ * The records are read in bulk. With warm set, conditional branches still
+ * train the branch predictor, so that it is warm when timing resumes.
+ *
+ * @param p the pipeline
+ * @param num_insts the number of trace records to skip
+ * @param warm whether to train the branch predictor on the skipped branches
+ * @return the number of records skipped, which is less than num_insts only at
+ *         the end of the trace
+ */
+uint64_t pipe_skip_insts(Pipeline* p, uint64_t num_insts, bool warm)
+{
+    TraceRec trace_recs[PIPE_SKIP_BATCH];
+    uint64_t skipped = 0;
+
+    while (skipped < num_insts)
+    {
+        uint64_t batch = num_insts - skipped;
+        if (batch > PIPE_SKIP_BATCH)
+        {
+            batch = PIPE_SKIP_BATCH;
+        }
+
+        uint8_t* buf = (uint8_t*)trace_recs;
+        size_t bytes_left = batch * sizeof(TraceRec);
+        size_t bytes_read_total = 0;
+        while (bytes_left > 0)
+        {
+            ssize_t bytes_read_last = read(p->trace_fd, buf + bytes_read_total,
+                bytes_left);
+            if (bytes_read_last <= 0)
+            {
+                break;
+            }
+            bytes_read_total += bytes_read_last;
+            bytes_left -= bytes_read_last;
+        }
+
+        uint64_t num_read = bytes_read_total / sizeof(TraceRec);
+        if (warm && p->btb)
+        {
+            for (uint64_t i = 0; i < num_read; i++)
+            {
+                pipe_check_btb(p, &trace_recs[i]);
+                p->fetch_last_rec = trace_recs[i];
+                p->fetch_last_valid = true;
+                p->fetch_last_mispred = false;
+            }
+        }
+        else
+        {
+            p->fetch_last_valid = false;
+        }
+        if (warm && p->b_pred)
+        {
+            for (uint64_t i = 0; i < num_read; i++)
+            {
+                if (trace_recs[i].op_type != OP_CBR)
+                {
+                    continue;
+                }
+                uint64_t pc = trace_recs[i].inst_addr;
+                BranchDirection prediction = p->b_pred->predict(pc);
+                p->b_pred->update(pc, prediction,
+                    static_cast<BranchDirection>(trace_recs[i].br_dir));
+            }
+        }
+        skipped += num_read;
+        p->last_op_id += num_read;
+
+        if (bytes_left > 0)
+        {
+            // End of the trace
+            p->halt = true;
+            break;
+        }
+    }
+    return skipped;
+}
+
+/**
+ * Squash every instruction in flight and clear all stalls, leaving the
+ * pipeline empty. The squashed instructions are dropped from the simulation.
+ *
+ * @param p the pipeline
+ */
+void pipe_flush(Pipeline* p)
+{
+    for (uint8_t latch_type = 0; latch_type < NUM_LATCH_TYPES; latch_type++)
+    {
+        for (unsigned int i = 0; i < MAX_PIPE_WIDTH; i++)
+        {
+            p->pipe_latch[latch_type][i].valid = false;
+            p->pipe_latch[latch_type][i].stall = false;
+        }
+    }
+    p->fetch_cbr_stall = false;
+    if (p->b_pred)
+    {
+        p->b_pred->squash_inflight();
+    }
+    p->fetch_last_valid = false;
+    p->fetch_redirect_pending = false;
+    p->fetch_redirect_stall = 0;
+    p->fetch_queue_head = 0;
+    p->fetch_queue_count = 0;
+}
+
 /**
  * Allocate and initialize a new pipeline.
  *
@@ -107,6 +220,27 @@ Pipeline* pipe_init(int trace_fd)
         p->b_pred = new BPred(BPRED_POLICY);
     }
 
+    // Allocate a branch target buffer and return address stack if needed.
+    if (BTB_ENTRIES > 0)
+    {
+        p->btb = new BTB(BTB_ENTRIES, BTB_ASSOC, BTB_REPL_POLICY);
+        p->ras = new ReturnAddressStack(RAS_ENTRIES);
+    }
+
+    // Allocate a fetch queue if needed.
+    if (FETCH_QUEUE_DEPTH > 0)
+    {
+        p->fetch_queue = (PipelineLatch*)calloc(FETCH_QUEUE_DEPTH,
+                                                sizeof(PipelineLatch));
+    }
+
+    // Allocate a branch profiler if needed.
+    if (BPRED_PROFILE_TOP > 0)
+    {
+        p->bprofile = new BranchProfiler(BPRED_PROFILE_TOP *
+                                         BPROFILE_SLOTS_PER_REPORTED);
+    }
+
     return p;
 }
 
@@ -234,6 +368,13 @@ void pipe_cycle_WB(Pipeline* p)
             {
                 p->fetch_cbr_stall = false;
             }
+            if (BPRED_SPEC_HISTORY && BPRED_POLICY != BPRED_PERFECT &&
+                p->pipe_latch[MA_LATCH][i].trace_rec.op_type == OP_CBR)
+            {
+                p->b_pred->resolve(p->pipe_latch[MA_LATCH][i].bpred_inflight_id,
+                    static_cast<BranchDirection>(
+                        p->pipe_latch[MA_LATCH][i].trace_rec.br_dir));
+            }
         }
     }
 }
@@ -658,6 +799,27 @@ void pipe_cycle_ID(Pipeline* p)
  */
 void pipe_cycle_IF(Pipeline* p)
 {
+    // Fetch is idle for whole cycles while it is redirected.
+    bool redirecting = p->fetch_redirect_stall > 0;
+    bool cbr_stalled = p->fetch_cbr_stall;
+    if (redirecting)
+    {
+        p->fetch_redirect_stall--;
+        p->stat_fetch_redirect_cycles++;
+    }
+
+    if (FETCH_QUEUE_DEPTH > 0)
+    {
+        // A stalled fetch only costs ID a cycle once the queue runs dry.
+        if (pipe_cycle_fetch_queue(p, redirecting))
+        {
+            pipe_profile_fetch_stall(p, redirecting, cbr_stalled);
+        }
+        return;
+    }
+
+    pipe_profile_fetch_stall(p, redirecting, cbr_stalled);
+
     for (unsigned int i = 0; i < PIPE_WIDTH; i++)
     {
         if (p->pipe_latch[IF_LATCH][i].stall)
@@ -667,19 +829,17 @@ void pipe_cycle_IF(Pipeline* p)
             // keeping it available for ID to process again in the next cycle.
             continue;
         }
-        if (p->fetch_cbr_stall)
+        if (p->fetch_cbr_stall || redirecting)
         {
             p->pipe_latch[IF_LATCH][i].valid = false;
             continue;
         }
-        // Read an instruction from the trace file.
         PipelineLatch fetch_op;
-        pipe_get_fetch_op(p, &fetch_op);
-
-        // Handle branch (mis)prediction.
-        if (BPRED_POLICY != BPRED_PERFECT)
+        if (!pipe_fetch_next(p, &fetch_op))
         {
-            pipe_check_bpred(p, &fetch_op);
+            redirecting = true;
+            p->pipe_latch[IF_LATCH][i].valid = false;
+            continue;
         }
 
         // Copy the instruction to the IF latch.
@@ -687,6 +847,159 @@ void pipe_cycle_IF(Pipeline* p)
     }
 }
 
+/**
+ * Simulate one cycle of the Instruction Fetch stage (IF) with a fetch queue:
+ * fetch and predict up to PIPE_WIDTH instructions into the queue, and hand
+ * the oldest ones in it to the lanes ID did not stall.
+ *
+ * @param p the pipeline to simulate
+ * @param redirecting whether fetch is idle this cycle for a redirect
+ * @return whether a lane ID did not stall got no instruction because the
+ *         queue was empty
+ */
+bool pipe_cycle_fetch_queue(Pipeline* p, bool redirecting)
+{
+    // Fetch runs ahead of ID until the queue is full.
+    for (unsigned int i = 0; i < PIPE_WIDTH; i++)
+    {
+        if (p->fetch_cbr_stall || redirecting)
+        {
+            break;
+        }
+        if (p->fetch_queue_count == FETCH_QUEUE_DEPTH)
+        {
+            p->stat_fetch_queue_full_cycles++;
+            break;
+        }
+        PipelineLatch fetch_op;
+        if (!pipe_fetch_next(p, &fetch_op))
+        {
+            redirecting = true;
+            break;
+        }
+        if (fetch_op.valid)
+        {
+            uint32_t tail = (p->fetch_queue_head + p->fetch_queue_count) %
+                            FETCH_QUEUE_DEPTH;
+            p->fetch_queue[tail] = fetch_op;
+            p->fetch_queue_count++;
+        }
+    }
+    p->stat_fetch_queue_occupancy += p->fetch_queue_count;
+
+    bool starved = false;
+    bool backend_stalled = false;
+    for (unsigned int i = 0; i < PIPE_WIDTH; i++)
+    {
+        if (p->pipe_latch[IF_LATCH][i].stall)
+        {
+            // ID keeps the instruction in this lane for the next cycle.
+            backend_stalled = true;
+            continue;
+        }
+        if (p->fetch_queue_count == 0)
+        {
+            starved = true;
+            p->pipe_latch[IF_LATCH][i].valid = false;
+            continue;
+        }
+        p->pipe_latch[IF_LATCH][i] = p->fetch_queue[p->fetch_queue_head];
+        p->fetch_queue_head = (p->fetch_queue_head + 1) % FETCH_QUEUE_DEPTH;
+        p->fetch_queue_count--;
+    }
+    p->stat_fetch_starved_cycles += starved;
+    p->stat_backend_stall_cycles += backend_stalled;
+    return starved;
+}
+
+/**
+ * Charge a fetch cycle lost to a redirect or to a mispredicted conditional
+ * branch to that branch in the branch profiler, if there is one.
+ *
+ * @param p the pipeline
+ * @param redirecting whether fetch was idle this cycle for a redirect
+ * @param cbr_stalled whether fetch was stalled this cycle on a mispredicted
+ *                    conditional branch
+ */
+void pipe_profile_fetch_stall(Pipeline* p, bool redirecting, bool cbr_stalled)
+{
+    if (!p->bprofile)
+    {
+        return;
+    }
+    if (redirecting)
+    {
+        if (p->fetch_redirect_profiled)
+        {
+            p->bprofile->add_cycles(p->fetch_redirect_pc, 1);
+        }
+    }
+    else if (cbr_stalled)
+    {
+        p->bprofile->add_cycles(p->fetch_cbr_stall_pc, 1);
+    }
+}
+
+/**
+ * Fetch the next instruction, from the trace or from a target held back by a
+ * redirect, and check it against the branch target buffer and the branch
+ * predictor.
+ *
+ * @param p the pipeline
+ * @param fetch_op set to the instruction fetched
+ * @return false if the instruction went to a mispredicted target, in which
+ *         case it is held back until the redirect is over
+ */
+bool pipe_fetch_next(Pipeline* p, PipelineLatch* fetch_op)
+{
+    if (p->fetch_redirect_pending)
+    {
+        // Fetch the target held back by the redirect.
+        *fetch_op = p->fetch_redirect_op;
+        p->fetch_redirect_pending = false;
+    }
+    else
+    {
+        // Read an instruction from the trace file.
+        pipe_get_fetch_op(p, fetch_op);
+
+        // If the last instruction went to a mispredicted target, the rest of
+        // this fetch group is lost, and this instruction waits for the
+        // redirect.
+        if (p->btb && fetch_op->valid &&
+            pipe_check_btb(p, &fetch_op->trace_rec))
+        {
+            p->fetch_redirect_op = *fetch_op;
+            p->fetch_redirect_pending = true;
+            p->fetch_redirect_stall = BTB_MISS_PENALTY;
+            p->stat_fetch_redirects++;
+            p->fetch_redirect_pc = p->fetch_last_rec.inst_addr;
+            p->fetch_redirect_profiled = p->fetch_last_rec.op_type == OP_CBR;
+            return false;
+        }
+    }
+
+    // Handle branch (mis)prediction.
+    if (BPRED_POLICY != BPRED_PERFECT)
+    {
+        pipe_check_bpred(p, fetch_op);
+    }
+    if (p->bprofile && fetch_op->valid &&
+        fetch_op->trace_rec.op_type == OP_CBR)
+    {
+        p->bprofile->record_branch(fetch_op->trace_rec.inst_addr,
+                                   fetch_op->trace_rec.br_dir == TAKEN,
+                                   fetch_op->is_mispred_cbr);
+    }
+    if (fetch_op->valid)
+    {
+        p->fetch_last_rec = fetch_op->trace_rec;
+        p->fetch_last_valid = true;
+        p->fetch_last_mispred = fetch_op->is_mispred_cbr;
+    }
+    return true;
+}
+
 /**
  * If the instruction just fetched is a conditional branch, check for a branch
  * misprediction, update the branch predictor, and set appropriate flags in the
@@ -704,14 +1017,28 @@ void pipe_check_bpred(Pipeline* p, PipelineLatch* fetch_op)
     if (fetch_op->trace_rec.op_type == OP_CBR)
     {
         BranchDirection resolution = static_cast<BranchDirection>(fetch_op->trace_rec.br_dir);
-        BranchDirection prediction = p->b_pred->predict(fetch_op->trace_rec.inst_addr);
+        BranchDirection prediction;
+        if (BPRED_SPEC_HISTORY)
+        {
+            // The predictor is trained when the branch reaches WB.
+            prediction = p->b_pred->predict_speculative(
+                fetch_op->trace_rec.inst_addr, &fetch_op->bpred_inflight_id);
+        }
+        else
+        {
+            prediction = p->b_pred->predict(fetch_op->trace_rec.inst_addr);
+        }
         if (resolution != prediction)
         {
             fetch_op->is_mispred_cbr = true;
             p->fetch_cbr_stall = true;
+            p->fetch_cbr_stall_pc = fetch_op->trace_rec.inst_addr;
         }
         // Update the bpred state
-        p->b_pred->update(fetch_op->trace_rec.inst_addr, prediction, resolution);
+        if (!BPRED_SPEC_HISTORY)
+        {
+            p->b_pred->update(fetch_op->trace_rec.inst_addr, prediction, resolution);
+        }
     }
     // TODO: If the branch predictor mispredicted, mark the fetch_op
     // accordingly.
@@ -721,3 +1048,64 @@ void pipe_check_bpred(Pipeline* p, PipelineLatch* fetch_op)
     // TODO: If needed, stall the IF stage by setting the flag
     // p->fetch_cbr_stall.
 }
+
+/**
+ * Tell from the address of the instruction just fetched whether the last one
+ * fetched was a taken control transfer, predict its target with the branch
+ * target buffer or the return address stack, and train them.
+ *
+ * A taken conditional branch is looked up in the branch target buffer. Other
+ * control transfers are only seen as a jump in the instruction addresses
+ * after an OP_OTHER instruction, since the trace does not tell calls, returns
+ * and jumps apart: one landing just after a call on the return address stack
+ * is a return it predicts, and any other is pushed on it as a possible call
+ * and looked up in the branch target buffer.
+ *
+ * @param p the pipeline
+ * @param fetch_rec the trace record of the instruction just fetched
+ * @return whether the target was mispredicted, so that fetch must be
+ *         redirected before this instruction
+ */
+bool pipe_check_btb(Pipeline* p, const TraceRec* fetch_rec)
+{
+    if (!p->fetch_last_valid)
+    {
+        return false;
+    }
+    const TraceRec* last = &p->fetch_last_rec;
+    uint64_t target = fetch_rec->inst_addr;
+
+    if (last->op_type == OP_CBR)
+    {
+        if (last->br_dir != TAKEN)
+        {
+            return false;
+        }
+    }
+    else if (last->op_type == OP_OTHER)
+    {
+        // Records of the same instruction share its address.
+        if (target >= last->inst_addr &&
+            target - last->inst_addr <= MAX_INST_LENGTH)
+        {
+            return false;
+        }
+        if (p->ras->pop_return(target))
+        {
+            return false;
+        }
+        p->ras->push(last->inst_addr);
+    }
+    else
+    {
+        return false;
+    }
+
+    uint64_t predicted_target = 0;
+    bool hit = p->btb->predict(last->inst_addr, &predicted_target);
+    p->btb->update(last->inst_addr, target);
+
+    // A mispredicted direction already stalled fetch until the branch
+    // resolved, which covers the target too.
+    return !(hit && predicted_target == target) && !p->fetch_last_mispred;
+}
@@ -13,6 +13,8 @@
 
 #include "trace.h"
 #include "bpred.h"
+#include "btb.h"
+#include "bprofile.h"
 #include <inttypes.h>
 
 /**
@@ -64,6 +66,102 @@ extern uint32_t ENABLE_EXE_FWD;
  */
 extern BPredPolicy BPRED_POLICY;
 
+/**
+ * The number of PC and global history bits that index the gshare pattern
+ * history table.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredhistbits.
+ */
+extern uint32_t BPRED_HISTORY_BITS;
+
+/**
+ * The storage budget of the TAGE predictor in KB.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -tagebudgetkb.
+ */
+extern uint32_t TAGE_BUDGET_KB;
+
+/**
+ * The storage budget of the hashed perceptron predictor in KB.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -perceptronbudgetkb.
+ */
+extern uint32_t PERCEPTRON_BUDGET_KB;
+
+/**
+ * A Boolean indicating whether the branch predictor should update its global
+ * history speculatively at prediction time, and train and repair it when the
+ * branch reaches the Write Back stage (WB), instead of doing both at fetch.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredspechist.
+ */
+extern uint32_t BPRED_SPEC_HISTORY;
+
+/**
+ * The number of entries of the branch target buffer, or 0 to let taken
+ * control transfers fetch from their target for free.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbentries.
+ */
+extern uint32_t BTB_ENTRIES;
+
+/**
+ * The associativity of the branch target buffer.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbassoc.
+ */
+extern uint32_t BTB_ASSOC;
+
+/**
+ * The replacement policy of the branch target buffer.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbrepl.
+ */
+extern BTBReplPolicy BTB_REPL_POLICY;
+
+/**
+ * The number of entries of the return address stack.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -rasentries.
+ */
+extern uint32_t RAS_ENTRIES;
+
+/**
+ * The number of cycles fetch is idle after the target of a taken control
+ * transfer was mispredicted, on top of the rest of its fetch group.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbmisspenalty.
+ */
+extern uint32_t BTB_MISS_PENALTY;
+
+/**
+ * The number of conditional branches reported by the branch profiler, ranked
+ * by the fetch cycles lost to them, or 0 to not profile branches.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredprofile.
+ */
+extern uint32_t BPRED_PROFILE_TOP;
+
+/**
+ * The number of instructions the fetch queue between IF and ID holds, or 0
+ * to fetch straight into the IF latch. With a queue, fetch and the branch
+ * predictor run ahead of ID while it stalls.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -fetchqueue.
+ */
+extern uint32_t FETCH_QUEUE_DEPTH;
+
 /**
  * One of the latches in the pipeline. Each one of these can contain one
  * operation to be processed by the next pipeline stage.
@@ -122,6 +220,14 @@ typedef struct PipelineLatchStruct
      * This is only relevant for part B of the lab.
      */
     bool is_mispred_cbr;
+
+    /**
+     * The id the branch predictor gave this conditional branch, to resolve
+     * it with once it reaches the Write Back stage (WB).
+     * 
+     * This is only used when BPRED_SPEC_HISTORY is set.
+     */
+    uint64_t bpred_inflight_id;
 } PipelineLatch;
 
 /**
@@ -184,6 +290,65 @@ typedef struct Pipeline
      */
     bool fetch_cbr_stall;
 
+    /**
+     * The branch target buffer and return address stack, or NULL if
+     * BTB_ENTRIES is 0.
+     */
+    BTB *btb;
+    ReturnAddressStack *ras;
+
+    /**
+     * The last instruction fetched, and whether it was a mispredicted
+     * conditional branch. Whether it redirected fetch is only known from
+     * the address of the next instruction.
+     */
+    TraceRec fetch_last_rec;
+    bool fetch_last_valid;
+    bool fetch_last_mispred;
+
+    /**
+     * An instruction fetched from a mispredicted target, held back until the
+     * redirect is over, and the number of idle fetch cycles left until then.
+     */
+    PipelineLatch fetch_redirect_op;
+    bool fetch_redirect_pending;
+    uint32_t fetch_redirect_stall;
+
+    /** The number of fetch redirects, and the idle fetch cycles they cost. */
+    uint64_t stat_fetch_redirects;
+    uint64_t stat_fetch_redirect_cycles;
+
+    /**
+     * The branch profiler, or NULL if BPRED_PROFILE_TOP is 0, and the
+     * addresses of the branches that set fetch_cbr_stall and the pending
+     * redirect, which the idle fetch cycles are charged to. Redirects after
+     * other control transfers are not charged.
+     */
+    BranchProfiler *bprofile;
+    uint64_t fetch_cbr_stall_pc;
+    uint64_t fetch_redirect_pc;
+    bool fetch_redirect_profiled;
+
+    /**
+     * The fetch queue, a circular buffer of FETCH_QUEUE_DEPTH instructions
+     * fetched and predicted but not yet handed to ID, or NULL if
+     * FETCH_QUEUE_DEPTH is 0.
+     */
+    PipelineLatch *fetch_queue;
+    uint32_t fetch_queue_head;
+    uint32_t fetch_queue_count;
+
+    /**
+     * The number of cycles ID had a free lane but the fetch queue was empty,
+     * the cycles ID stalled a lane, and the cycles the queue was full so
+     * that the stall reached fetch, along with the queue occupancy summed
+     * over all cycles.
+     */
+    uint64_t stat_fetch_starved_cycles;
+    uint64_t stat_backend_stall_cycles;
+    uint64_t stat_fetch_queue_full_cycles;
+    uint64_t stat_fetch_queue_occupancy;
+
     /**
      * The total number of committed instructions.
      * 
@@ -281,6 +446,41 @@ void pipe_cycle_MA(Pipeline *p);
  */
 void pipe_cycle_WB(Pipeline *p);
 
+/**
+ * Simulate one cycle of the Instruction Fetch stage (IF) with a fetch queue:
+ * fetch and predict up to PIPE_WIDTH instructions into the queue, and hand
+ * the oldest ones in it to the lanes ID did not stall.
+ * 
+ * @param p the pipeline to simulate
+ * @param redirecting whether fetch is idle this cycle for a redirect
+ * @return whether a lane ID did not stall got no instruction because the
+ *         queue was empty
+ */
+bool pipe_cycle_fetch_queue(Pipeline *p, bool redirecting);
+
+/**
+ * Charge a fetch cycle lost to a redirect or to a mispredicted conditional
+ * branch to that branch in the branch profiler, if there is one.
+ * 
+ * @param p the pipeline
+ * @param redirecting whether fetch was idle this cycle for a redirect
+ * @param cbr_stalled whether fetch was stalled this cycle on a mispredicted
+ *                    conditional branch
+ */
+void pipe_profile_fetch_stall(Pipeline *p, bool redirecting, bool cbr_stalled);
+
+/**
+ * Fetch the next instruction, from the trace or from a target held back by a
+ * redirect, and check it against the branch target buffer and the branch
+ * predictor.
+ * 
+ * @param p the pipeline
+ * @param fetch_op set to the instruction fetched
+ * @return false if the instruction went to a mispredicted target, in which
+ *         case it is held back until the redirect is over
+ */
+bool pipe_fetch_next(Pipeline *p, PipelineLatch *fetch_op);
+
 /**
  * If the instruction just fetched is a conditional branch, check for a branch
  * misprediction, update the branch predictor, and set appropriate flags in the
@@ -293,6 +493,18 @@ void pipe_cycle_WB(Pipeline *p);
  */
 void pipe_check_bpred(Pipeline *p, PipelineLatch *fetch_op);
 
+/**
+ * Tell from the address of the instruction just fetched whether the last one
+ * fetched was a taken control transfer, predict its target with the branch
+ * target buffer or the return address stack, and train them.
+ * 
+ * @param p the pipeline
+ * @param fetch_rec the trace record of the instruction just fetched
+ * @return whether the target was mispredicted, so that fetch must be
+ *         redirected before this instruction
+ */
+bool pipe_check_btb(Pipeline *p, const TraceRec *fetch_rec);
+
 /**
  * Print out the state of the pipeline latches for debugging purposes.
  * 
@@ -303,4 +515,26 @@ void pipe_check_bpred(Pipeline *p, PipelineLatch *fetch_op);
  */
 void pipe_print_state(Pipeline *p);
 
+/**
+ * Fast-forward over the next trace records without timing them.
+ * 
+ * The records are read in bulk. With warm set, conditional branches still
+ * train the branch predictor, so that it is warm when timing resumes.
+ * 
+ * @param p the pipeline
+ * @param num_insts the number of trace records to skip
+ * @param warm whether to train the branch predictor on the skipped branches
+ * @return the number of records skipped, which is less than num_insts only at
+ *         the end of the trace
+ */
+uint64_t pipe_skip_insts(Pipeline *p, uint64_t num_insts, bool warm);
+
+/**
+ * Squash every instruction in flight and clear all stalls, leaving the
+ * pipeline empty. The squashed instructions are dropped from the simulation.
+ * 
+ * @param p the pipeline
+ */
+void pipe_flush(Pipeline *p);
+
 #endif
@@ -8,13 +8,18 @@
 
 #include "pipeline.h"
 #include "bpred.h"
+#include "simpoint.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 /**
  * The width of the pipeline; that is, the maximum number of instructions that
@@ -57,6 +62,181 @@ uint32_t ENABLE_EXE_FWD = 0;
  */
 BPredPolicy BPRED_POLICY = BPRED_PERFECT;
 
+/**
+ * The number of PC and global history bits that index the gshare pattern
+ * history table, which holds 2^BPRED_HISTORY_BITS counters.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredhistbits.
+ */
+uint32_t BPRED_HISTORY_BITS = BPRED_DEFAULT_HISTORY_BITS;
+
+/**
+ * The storage budget of the TAGE predictor in KB.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -tagebudgetkb.
+ */
+uint32_t TAGE_BUDGET_KB = TAGE_DEFAULT_BUDGET_KB;
+
+/**
+ * The storage budget of the hashed perceptron predictor in KB.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -perceptronbudgetkb.
+ */
+uint32_t PERCEPTRON_BUDGET_KB = PERCEPTRON_DEFAULT_BUDGET_KB;
+
+/**
+ * A Boolean indicating whether the branch predictor should update its global
+ * history speculatively at prediction time, and train and repair it when the
+ * branch reaches the Write Back stage (WB), instead of doing both at fetch.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredspechist.
+ */
+uint32_t BPRED_SPEC_HISTORY = 0;
+
+/**
+ * The number of entries of the branch target buffer, or 0 to let taken
+ * control transfers fetch from their target for free.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbentries.
+ */
+uint32_t BTB_ENTRIES = 0;
+
+/**
+ * The associativity of the branch target buffer.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbassoc.
+ */
+uint32_t BTB_ASSOC = BTB_DEFAULT_ASSOC;
+
+/**
+ * The replacement policy of the branch target buffer.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbrepl.
+ */
+BTBReplPolicy BTB_REPL_POLICY = BTB_REPL_LRU;
+
+/**
+ * The number of entries of the return address stack.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -rasentries.
+ */
+uint32_t RAS_ENTRIES = RAS_DEFAULT_ENTRIES;
+
+/**
+ * The number of cycles fetch is idle after the target of a taken control
+ * transfer was mispredicted, on top of the rest of its fetch group.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -btbmisspenalty.
+ */
+uint32_t BTB_MISS_PENALTY = BTB_DEFAULT_MISS_PENALTY;
+
+/**
+ * The number of conditional branches reported by the branch profiler, ranked
+ * by the fetch cycles lost to them, or 0 to not profile branches.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredprofile.
+ */
+uint32_t BPRED_PROFILE_TOP = 0;
+
+/**
+ * The number of instructions the fetch queue between IF and ID holds, or 0
+ * to fetch straight into the IF latch. With a queue, fetch and the branch
+ * predictor run ahead of ID while it stalls.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -fetchqueue.
+ */
+uint32_t FETCH_QUEUE_DEPTH = 0;
+
+/**
+ * The largest number of SimPoints to simulate, or 0 to simulate the whole
+ * trace.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint.
+ */
+uint32_t SIMPOINT_MAX_K = 0;
+
+/**
+ * The number of instructions in each SimPoint interval.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint_interval.
+ */
+uint64_t SIMPOINT_INTERVAL = 100000;
+
+/**
+ * The number of instructions before each SimPoint that train the branch
+ * predictor without being timed.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint_warmup.
+ */
+uint64_t SIMPOINT_WARMUP = 100000;
+
+/**
+ * A Boolean indicating whether the whole trace should also be simulated to
+ * measure the error of the SimPoint estimates.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint_validate.
+ */
+uint32_t SIMPOINT_VALIDATE = 0;
+
+/**
+ * A Boolean indicating whether only the branch predictor should be evaluated,
+ * on the conditional branches of the trace, without simulating the pipeline.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredonly.
+ */
+uint32_t BPRED_ONLY = 0;
+
+/** A branch predictor configuration evaluated by -bpredsweep. */
+typedef struct BPredConfigStruct
+{
+    BPredPolicy policy;
+    uint32_t size; // PHT index bits for Gshare and Tournament, storage
+                   // budget in KB otherwise, or 0 while parsing for the
+                   // size set by the other command-line arguments
+} BPredConfig;
+
+/**
+ * The branch predictor configurations evaluated side by side in one pass over
+ * the trace, or empty to evaluate only BPRED_POLICY.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredsweep.
+ */
+std::vector<BPredConfig> BPRED_SWEEP;
+
+/**
+ * The number of threads the predictors of -bpredsweep are split across.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -bpredthreads.
+ */
+uint32_t BPRED_THREADS = 1;
+
+/** The number of trace records read at once in branch-predictor-only mode. */
+#define BPRED_ONLY_BATCH 65536
+
+/**
+ * The number of branches buffered before they are handed to the predictors,
+ * large enough that splitting them across threads pays off.
+ */
+#define BPRED_BRANCH_BATCH (1 << 20)
+
 #define HEARTBEAT_CYCLES 10000
 #define STAT_CYCLES (HEARTBEAT_CYCLES * 50)
 
@@ -64,6 +244,9 @@ Pipeline *pipeline;
 uint64_t last_hbeat_inst = 0;
 
 int parse_args(int argc, char *argv[], char **trace_filename);
+int simulate_trace(const char *trace_filename);
+int simulate_simpoints(const char *trace_filename);
+int simulate_bpred_only(const char *trace_filename);
 int open_gunzip_pipe(const char *filename, int *fd, pid_t *pid);
 int check_heartbeat();
 void print_stats();
@@ -78,44 +261,550 @@ int main(int argc, char *argv[])
     status = parse_args(argc, argv, &trace_filename);
     if (status != 0)
     {
-        return status;
+        return status;
+    }
+
+    if (SIMPOINT_MAX_K)
+    {
+        return simulate_simpoints(trace_filename);
+    }
+
+    if (BPRED_ONLY)
+    {
+        return simulate_bpred_only(trace_filename);
+    }
+
+    status = simulate_trace(trace_filename);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    // Print statistics.
+    print_stats();
+    return 0;
+}
+
+/**
+ * Simulate the whole trace, leaving the final state in the global pipeline.
+ * 
+ * @param trace_filename the trace file to simulate
+ * @return 0 on success, or the exit status on failure
+ */
+int simulate_trace(const char *trace_filename)
+{
+    int status;
+
+    // Open the trace file using gunzip.
+    int trace_fd;
+    pid_t pid;
+    printf("Opening trace file with gunzip: %s\n", trace_filename);
+    status = open_gunzip_pipe(trace_filename, &trace_fd, &pid);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    // Simulate the pipeline.
+    pipeline = pipe_init(trace_fd);
+    last_hbeat_inst = 0;
+    status = 0;
+    while (status == 0 && !pipeline->halt)
+    {
+        pipe_cycle(pipeline);
+        status = check_heartbeat();
+    }
+    close(trace_fd);
+    if (status != 0)
+    {
+        waitpid(pid, NULL, 0);
+        return status;
+    }
+
+    // Wait for the child process to finish.
+    waitpid(pid, &status, 0);
+    status = WEXITSTATUS(status);
+    if (status == 127)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Read trace records in bulk.
+ * 
+ * @param trace_fd the file descriptor from which to read trace records
+ * @param trace_recs the buffer to fill
+ * @param max_recs the size of the buffer in trace records
+ * @return the number of whole records read, which is 0 at the end of the trace
+ */
+static size_t read_trace_recs(int trace_fd, TraceRec *trace_recs,
+                              size_t max_recs)
+{
+    uint8_t *buf = (uint8_t *)trace_recs;
+    size_t bytes_left = max_recs * sizeof(TraceRec);
+    size_t bytes_read_total = 0;
+    while (bytes_left > 0)
+    {
+        ssize_t bytes_read_last = read(trace_fd, buf + bytes_read_total,
+                                       bytes_left);
+        if (bytes_read_last <= 0)
+        {
+            break;
+        }
+        bytes_read_total += bytes_read_last;
+        bytes_left -= bytes_read_last;
+    }
+    return bytes_read_total / sizeof(TraceRec);
+}
+
+/**
+ * Pick SimPoints from the basic block vectors of the trace, simulate only
+ * those intervals (after warming the branch predictor over the instructions
+ * before each one), and print the weighted CPI and misprediction rate. With
+ * -simpoint_validate, also simulate the whole trace and print the errors.
+ * 
+ * @param trace_filename the trace file to simulate
+ * @return 0 on success, or the exit status on failure
+ */
+int simulate_simpoints(const char *trace_filename)
+{
+    int status;
+    int trace_fd;
+    pid_t pid;
+
+    // Profile the basic block vectors of the whole trace.
+    printf("Profiling trace file with gunzip: %s\n", trace_filename);
+    status = open_gunzip_pipe(trace_filename, &trace_fd, &pid);
+    if (status != 0)
+    {
+        return status;
+    }
+    SimPointProfiler *sp = simpoint_profiler_new(SIMPOINT_INTERVAL);
+    static TraceRec trace_recs[4096];
+    size_t num_read;
+    while ((num_read = read_trace_recs(trace_fd, trace_recs, 4096)) > 0)
+    {
+        for (size_t i = 0; i < num_read; i++)
+        {
+            simpoint_profile_inst(sp, trace_recs[i].inst_addr,
+                                  trace_recs[i].op_type == OP_CBR);
+        }
+    }
+    close(trace_fd);
+    waitpid(pid, NULL, 0);
+
+    std::vector<SimPoint> points = simpoint_pick(sp, SIMPOINT_MAX_K);
+    if (points.empty())
+    {
+        fprintf(stderr, "Error: trace is shorter than one SimPoint interval\n");
+        return 1;
+    }
+
+    // Simulate each SimPoint, fast-forwarding over the rest of the trace.
+    printf("Opening trace file with gunzip: %s\n", trace_filename);
+    status = open_gunzip_pipe(trace_filename, &trace_fd, &pid);
+    if (status != 0)
+    {
+        return status;
+    }
+    pipeline = pipe_init(trace_fd);
+
+    std::vector<double> cpis, branches, mispreds;
+    uint64_t detailed_inst = 0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        uint64_t start = points[i].interval * SIMPOINT_INTERVAL;
+        if (start > pipeline->last_op_id + SIMPOINT_WARMUP)
+        {
+            pipe_skip_insts(pipeline,
+                            start - SIMPOINT_WARMUP - pipeline->last_op_id,
+                            false);
+        }
+        if (start > pipeline->last_op_id)
+        {
+            pipe_skip_insts(pipeline, start - pipeline->last_op_id, true);
+        }
+
+        uint64_t start_cycle = pipeline->stat_num_cycle;
+        uint64_t start_inst = pipeline->stat_retired_inst;
+        uint64_t start_branches = 0;
+        uint64_t start_mispred = 0;
+        if (pipeline->b_pred)
+        {
+            start_branches = pipeline->b_pred->stat_num_branches;
+            start_mispred = pipeline->b_pred->stat_num_mispred;
+        }
+        while (!pipeline->halt &&
+               pipeline->stat_retired_inst - start_inst < SIMPOINT_INTERVAL)
+        {
+            pipe_cycle(pipeline);
+        }
+
+        uint64_t num_inst = pipeline->stat_retired_inst - start_inst;
+        uint64_t num_cycle = pipeline->stat_num_cycle - start_cycle;
+        detailed_inst += num_inst;
+        cpis.push_back(num_inst ? (double)num_cycle / (double)num_inst : 0.0);
+        if (pipeline->b_pred)
+        {
+            branches.push_back(pipeline->b_pred->stat_num_branches -
+                               start_branches);
+            mispreds.push_back(pipeline->b_pred->stat_num_mispred -
+                               start_mispred);
+        }
+        else
+        {
+            branches.push_back(0);
+            mispreds.push_back(0);
+        }
+
+        // The instructions in flight past the interval are dropped.
+        pipe_flush(pipeline);
+    }
+    close(trace_fd);
+    waitpid(pid, NULL, 0);
+
+    double cpi = simpoint_weighted(points, cpis);
+    double mispred_rate = 100.0 * simpoint_weighted_ratio(points, mispreds,
+                                                          branches);
+
+    simpoint_print_points(sp, points);
+    printf("%8s %10s %10s %10s\n", "POINT", "CPI", "BRANCHES", "MISPRED");
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        printf("%8lu %10.3f %10.0f %10.0f\n", (unsigned long)i, cpis[i],
+               branches[i], mispreds[i]);
+    }
+    printf("\n");
+    printf("LAB2_SIMPOINT_DETAILED_INST \t : %10lu\n",
+           (unsigned long)detailed_inst);
+    printf("LAB2_SIMPOINT_CPI       \t : %10.3f\n", cpi);
+    if (BPRED_POLICY != BPRED_PERFECT)
+    {
+        printf("LAB2_SIMPOINT_MISPRED_RATE \t : %10.3f\n", mispred_rate);
+    }
+
+    if (!SIMPOINT_VALIDATE)
+    {
+        printf("\n");
+        return 0;
+    }
+
+    status = simulate_trace(trace_filename);
+    if (status != 0)
+    {
+        return status;
+    }
+    print_stats();
+
+    double full_cpi = (double)pipeline->stat_num_cycle /
+                      (double)pipeline->stat_retired_inst;
+    printf("LAB2_SIMPOINT_CPI_ERR_PERC \t : %10.3f\n",
+           100.0 * (cpi - full_cpi) / full_cpi);
+    if (BPRED_POLICY != BPRED_PERFECT)
+    {
+        double full_mispred_rate = 0.0;
+        if (pipeline->b_pred->stat_num_branches)
+        {
+            full_mispred_rate = 100.0 *
+                                (double)pipeline->b_pred->stat_num_mispred /
+                                (double)pipeline->b_pred->stat_num_branches;
+        }
+        printf("LAB2_SIMPOINT_MISPRED_ERR \t : %10.3f\n",
+               mispred_rate - full_mispred_rate);
+    }
+    printf("\n");
+    return 0;
+}
+
+/** A conditional branch decoded from the trace for the predictors. */
+typedef struct BranchRecStruct
+{
+    uint64_t inst_addr;
+    BranchDirection br_dir;
+} BranchRec;
+
+/*
+* Function to print the conditional branches that lost the most fetch cycles,
+* with how much of all lost cycles they surely account for and how many more
+* they may have
+*/
+static void print_branch_profile(BranchProfiler *bprofile)
+{
+    std::vector<BranchProfileEntry> top = bprofile->top(BPRED_PROFILE_TOP);
+    uint64_t total_cycles = bprofile->stat_total_cycles;
+    uint64_t covered_cycles = 0;
+
+    printf("\nBRANCH PROFILE (top %lu by lost fetch cycles)\n",
+           (unsigned long)BPRED_PROFILE_TOP);
+    printf("%6s %18s %10s %10s %8s %8s %10s %8s %10s\n", "RANK", "PC",
+           "EXECS", "MISPRED", "MISP%", "TAKEN%", "CYCLES", "CYC%", "MAX_ERR");
+    for (size_t i = 0; i < top.size(); i++)
+    {
+        const BranchProfileEntry *entry = &top[i];
+        uint64_t execs = entry->execs ? entry->execs : 1;
+        uint64_t cycles = entry->cycles - entry->error;
+        printf("%6lu %#18lx %10lu %10lu %8.2f %8.2f %10lu %8.2f %10lu\n",
+               (unsigned long)i + 1, (unsigned long)entry->pc,
+               (unsigned long)entry->execs, (unsigned long)entry->mispreds,
+               100.0 * (double)entry->mispreds / (double)execs,
+               100.0 * (double)entry->taken / (double)execs,
+               (unsigned long)cycles,
+               100.0 * (double)cycles /
+                   (double)(total_cycles ? total_cycles : 1),
+               (unsigned long)entry->error);
+        covered_cycles += cycles;
+    }
+    printf("\n");
+    printf("LAB2_PROFILE_LOST_CYCLES \t : %10lu\n",
+           (unsigned long)total_cycles);
+    printf("LAB2_PROFILE_TOP_CYCLES_PERC \t : %10.3f\n",
+           100.0 * (double)covered_cycles /
+               (double)(total_cycles ? total_cycles : 1));
+    printf("LAB2_PROFILE_EVICTIONS  \t : %10lu\n",
+           (unsigned long)bprofile->stat_evictions);
+}
+
+/*
+* Function to check whether the size of a predictor configuration is its PHT
+* index bits, rather than a storage budget in KB
+*/
+static bool bpred_size_is_history_bits(BPredPolicy policy)
+{
+    return policy == BPRED_GSHARE || policy == BPRED_TOURNAMENT;
+}
+
+/*
+* Function to get the size of a predictor configuration set by the
+* command-line arguments
+*/
+static uint32_t bpred_default_size(BPredPolicy policy)
+{
+    if (bpred_size_is_history_bits(policy))
+    {
+        return BPRED_HISTORY_BITS;
+    }
+    if (policy == BPRED_PERCEPTRON)
+    {
+        return PERCEPTRON_BUDGET_KB;
+    }
+    return TAGE_BUDGET_KB;
+}
+
+/*
+* Function to print how often each tournament component was right, and how
+* often the chooser picked each of them
+*/
+static void print_tournament_stats(BPred *b_pred)
+{
+    double branches = b_pred->stat_num_branches ? b_pred->stat_num_branches : 1;
+    uint64_t chose_local = b_pred->stat_num_branches - b_pred->stat_chose_global;
+
+    printf("LAB2_TOURN_LOCAL_ACCURACY \t : %10.3f\n",
+           100.0 * (double)b_pred->stat_local_correct / branches);
+    printf("LAB2_TOURN_GLOBAL_ACCURACY \t : %10.3f\n",
+           100.0 * (double)b_pred->stat_global_correct / branches);
+    printf("LAB2_TOURN_CHOSE_LOCAL  \t : %10.3f\n",
+           100.0 * (double)chose_local / branches);
+    printf("LAB2_TOURN_CHOSE_GLOBAL \t : %10.3f\n",
+           100.0 * (double)b_pred->stat_chose_global / branches);
+}
+
+/**
+ * Feed a block of branches to some of the predictors, in program order.
+ * 
+ * @param b_preds the predictors
+ * @param first the index of the first predictor to feed
+ * @param stride the distance between the indices of the predictors to feed
+ * @param branches the branches
+ */
+static void run_bpreds(std::vector<BPred *> *b_preds, size_t first,
+                       size_t stride, const std::vector<BranchRec> *branches)
+{
+    for (size_t i = first; i < b_preds->size(); i += stride)
+    {
+        BPred *b_pred = (*b_preds)[i];
+        for (const BranchRec &branch : *branches)
+        {
+            BranchDirection prediction = b_pred->predict(branch.inst_addr);
+            b_pred->update(branch.inst_addr, prediction, branch.br_dir);
+        }
+    }
+}
+
+/**
+ * Feed a block of branches to every predictor, split across BPRED_THREADS
+ * threads by predictor, and return the time it took in seconds.
+ * 
+ * @param b_preds the predictors
+ * @param branches the branches
+ * @return the elapsed time in seconds
+ */
+static double run_bpreds_parallel(std::vector<BPred *> &b_preds,
+                                  const std::vector<BranchRec> &branches)
+{
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    size_t num_threads = std::min((size_t)BPRED_THREADS, b_preds.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; t++)
+    {
+        threads.emplace_back(run_bpreds, &b_preds, t, num_threads, &branches);
+    }
+    run_bpreds(&b_preds, 0, num_threads, &branches);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    return (double)(end_time.tv_sec - start_time.tv_sec) +
+           (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+}
+
+/**
+ * Evaluate branch predictors alone: decode the conditional branches of the
+ * trace once and stream them through BPred::predict() and BPred::update() of
+ * each predictor in program order, as the pipeline does at fetch, without
+ * simulating the pipeline. A single predictor prints its misprediction rate,
+ * MPKI and accuracy; the predictors of -bpredsweep print a comparison table.
+ * 
+ * @param trace_filename the trace file to read
+ * @return 0 on success, or the exit status on failure
+ */
+int simulate_bpred_only(const char *trace_filename)
+{
+    int status;
+    int trace_fd;
+    pid_t pid;
+
+    printf("Opening trace file with gunzip: %s\n", trace_filename);
+    status = open_gunzip_pipe(trace_filename, &trace_fd, &pid);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    std::vector<BPredConfig> configs = BPRED_SWEEP;
+    if (configs.empty())
+    {
+        configs.push_back({BPRED_POLICY, bpred_default_size(BPRED_POLICY)});
+    }
+    std::vector<BPred *> b_preds;
+    for (const BPredConfig &config : configs)
+    {
+        if (bpred_size_is_history_bits(config.policy))
+        {
+            b_preds.push_back(new BPred(config.policy, config.size,
+                                        TAGE_BUDGET_KB));
+        }
+        else
+        {
+            b_preds.push_back(new BPred(config.policy, BPRED_HISTORY_BITS,
+                                        config.size));
+        }
+    }
+
+    std::vector<TraceRec> trace_recs(BPRED_ONLY_BATCH);
+    std::vector<BranchRec> branches;
+    branches.reserve(BPRED_BRANCH_BATCH);
+    uint64_t num_inst = 0;
+    // Only the predictors are timed, since gunzip is usually the bottleneck
+    double seconds = 0.0;
+
+    size_t num_recs;
+    while ((num_recs = read_trace_recs(trace_fd, trace_recs.data(),
+                                       BPRED_ONLY_BATCH)) > 0)
+    {
+        num_inst += num_recs;
+        for (size_t i = 0; i < num_recs; i++)
+        {
+            if (trace_recs[i].op_type == OP_CBR)
+            {
+                branches.push_back({trace_recs[i].inst_addr,
+                                    (BranchDirection)trace_recs[i].br_dir});
+            }
+        }
+        if (branches.size() >= BPRED_BRANCH_BATCH - BPRED_ONLY_BATCH)
+        {
+            seconds += run_bpreds_parallel(b_preds, branches);
+            branches.clear();
+        }
     }
+    seconds += run_bpreds_parallel(b_preds, branches);
 
-    // Open the trace file using gunzip.
-    int trace_fd;
-    pid_t pid;
-    printf("Opening trace file with gunzip: %s\n", trace_filename);
-    status = open_gunzip_pipe(trace_filename, &trace_fd, &pid);
-    if (status != 0)
+    close(trace_fd);
+    waitpid(pid, &status, 0);
+    if (WEXITSTATUS(status) == 127)
     {
-        return status;
+        for (BPred *b_pred : b_preds)
+        {
+            delete b_pred;
+        }
+        return 1;
     }
 
-    // Simulate the pipeline.
-    pipeline = pipe_init(trace_fd);
-    status = 0;
-    while (status == 0 && !pipeline->halt)
+    uint64_t total_branches = 0;
+    printf("\n");
+    if (!BPRED_SWEEP.empty())
     {
-        pipe_cycle(pipeline);
-        status = check_heartbeat();
+        printf("%8s %8s %10s %10s %10s %10s %10s %10s\n", "CONFIG", "POLICY",
+               "SIZE", "STORAGE_KB", "BRANCHES", "MISPRED", "RATE", "MPKI");
     }
-    close(trace_fd);
-    if (status != 0)
+    for (size_t i = 0; i < b_preds.size(); i++)
     {
-        waitpid(pid, NULL, 0);
-        return status;
-    }
+        unsigned long stat_num_branches = b_preds[i]->stat_num_branches;
+        unsigned long stat_num_mispred = b_preds[i]->stat_num_mispred;
+        total_branches += stat_num_branches;
+        double mispred_rate = 0.0;
+        double mpki = 0.0;
+        if (stat_num_branches)
+        {
+            mispred_rate = 100.0 * (double)stat_num_mispred /
+                           (double)stat_num_branches;
+        }
+        if (num_inst)
+        {
+            mpki = 1000.0 * (double)stat_num_mispred / (double)num_inst;
+        }
 
-    // Wait for the child process to finish.
-    waitpid(pid, &status, 0);
-    status = WEXITSTATUS(status);
-    if (status == 127)
+        if (!BPRED_SWEEP.empty())
+        {
+            double storage_kb = b_preds[i]->storage_bits() / 8192.0;
+            printf("%8lu %8d %10u %10.3f %10lu %10lu %10.3f %10.3f\n",
+                   (unsigned long)i, (int)configs[i].policy,
+                   configs[i].size, storage_kb, stat_num_branches,
+                   stat_num_mispred, mispred_rate, mpki);
+            continue;
+        }
+        printf("LAB2_NUM_INST           \t : %10lu\n", (unsigned long)num_inst);
+        printf("LAB2_BPRED_BRANCHES     \t : %10lu\n", stat_num_branches);
+        printf("LAB2_BPRED_MISPRED      \t : %10lu\n", stat_num_mispred);
+        printf("LAB2_MISPRED_RATE       \t : %10.3f\n", mispred_rate);
+        printf("LAB2_BPRED_MPKI         \t : %10.3f\n", mpki);
+        printf("LAB2_BPRED_ACCURACY     \t : %10.3f\n", 100.0 - mispred_rate);
+        if (configs[i].policy == BPRED_TOURNAMENT)
+        {
+            print_tournament_stats(b_preds[i]);
+        }
+    }
+    if (!BPRED_SWEEP.empty())
     {
-        return 1;
+        printf("\n");
+        printf("LAB2_NUM_INST           \t : %10lu\n", (unsigned long)num_inst);
+        printf("LAB2_BPRED_CONFIGS      \t : %10lu\n",
+               (unsigned long)b_preds.size());
     }
+    printf("LAB2_BPRED_MBRANCH_PER_SEC \t : %10.3f\n",
+           seconds > 0 ? (double)total_branches / seconds / 1e6 : 0.0);
+    printf("\n");
 
-    // Print statistics.
-    print_stats();
+    for (BPred *b_pred : b_preds)
+    {
+        delete b_pred;
+    }
     return 0;
 }
 
@@ -181,6 +870,298 @@ int parse_args(int argc, char *argv[], char **trace_filename)
 
                 BPRED_POLICY = (BPredPolicy)policy;
             }
+            else if (strcmp(argv[i], "-bpredhistbits") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -bpredhistbits\n");
+                    return 2;
+                }
+
+                int history_bits = atoi(argv[i]);
+                if (history_bits < 1 || history_bits > 30)
+                {
+                    fprintf(stderr, "Error: history bits must be between 1 and 30\n");
+                    return 2;
+                }
+
+                BPRED_HISTORY_BITS = history_bits;
+            }
+            else if (strcmp(argv[i], "-tagebudgetkb") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -tagebudgetkb\n");
+                    return 2;
+                }
+
+                int budget_kb = atoi(argv[i]);
+                if (budget_kb < 1 || budget_kb > 65536)
+                {
+                    fprintf(stderr, "Error: TAGE budget must be between 1 and 65536 KB\n");
+                    return 2;
+                }
+
+                TAGE_BUDGET_KB = budget_kb;
+            }
+            else if (strcmp(argv[i], "-perceptronbudgetkb") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -perceptronbudgetkb\n");
+                    return 2;
+                }
+
+                int budget_kb = atoi(argv[i]);
+                if (budget_kb < 1 || budget_kb > 65536)
+                {
+                    fprintf(stderr, "Error: perceptron budget must be between 1 and 65536 KB\n");
+                    return 2;
+                }
+
+                PERCEPTRON_BUDGET_KB = budget_kb;
+            }
+            else if (strcmp(argv[i], "-bpredspechist") == 0)
+            {
+                BPRED_SPEC_HISTORY = 1;
+            }
+            else if (strcmp(argv[i], "-btbentries") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -btbentries\n");
+                    return 2;
+                }
+
+                int entries = atoi(argv[i]);
+                if (entries < 0)
+                {
+                    fprintf(stderr, "Error: invalid argument for -btbentries\n");
+                    return 2;
+                }
+
+                BTB_ENTRIES = entries;
+            }
+            else if (strcmp(argv[i], "-btbassoc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -btbassoc\n");
+                    return 2;
+                }
+
+                int assoc = atoi(argv[i]);
+                if (assoc < 1)
+                {
+                    fprintf(stderr, "Error: invalid argument for -btbassoc\n");
+                    return 2;
+                }
+
+                BTB_ASSOC = assoc;
+            }
+            else if (strcmp(argv[i], "-btbrepl") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -btbrepl\n");
+                    return 2;
+                }
+
+                int repl = atoi(argv[i]);
+                if (repl < 0 || repl >= NUM_BTB_REPL_POLICIES)
+                {
+                    fprintf(stderr, "Error: invalid argument for -btbrepl\n");
+                    return 2;
+                }
+
+                BTB_REPL_POLICY = (BTBReplPolicy)repl;
+            }
+            else if (strcmp(argv[i], "-rasentries") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -rasentries\n");
+                    return 2;
+                }
+
+                int entries = atoi(argv[i]);
+                if (entries < 1)
+                {
+                    fprintf(stderr, "Error: invalid argument for -rasentries\n");
+                    return 2;
+                }
+
+                RAS_ENTRIES = entries;
+            }
+            else if (strcmp(argv[i], "-btbmisspenalty") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -btbmisspenalty\n");
+                    return 2;
+                }
+
+                int penalty = atoi(argv[i]);
+                if (penalty < 0)
+                {
+                    fprintf(stderr, "Error: invalid argument for -btbmisspenalty\n");
+                    return 2;
+                }
+
+                BTB_MISS_PENALTY = penalty;
+            }
+            else if (strcmp(argv[i], "-bpredprofile") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -bpredprofile\n");
+                    return 2;
+                }
+
+                int top = atoi(argv[i]);
+                if (top < 1 || top > 65536)
+                {
+                    fprintf(stderr, "Error: -bpredprofile must be between 1 and 65536\n");
+                    return 2;
+                }
+
+                BPRED_PROFILE_TOP = top;
+            }
+            else if (strcmp(argv[i], "-fetchqueue") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -fetchqueue\n");
+                    return 2;
+                }
+
+                int depth = atoi(argv[i]);
+                if (depth < 0 || depth > 4096)
+                {
+                    fprintf(stderr, "Error: fetch queue depth must be between 0 and 4096\n");
+                    return 2;
+                }
+
+                FETCH_QUEUE_DEPTH = depth;
+            }
+            else if (strcmp(argv[i], "-bpredonly") == 0)
+            {
+                BPRED_ONLY = 1;
+            }
+            else if (strcmp(argv[i], "-bpredsweep") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -bpredsweep\n");
+                    return 2;
+                }
+
+                // A comma-separated list of <policy>[:<size>]
+                BPRED_SWEEP.clear();
+                char *saveptr;
+                for (char *token = strtok_r(argv[i], ",", &saveptr);
+                     token != NULL; token = strtok_r(NULL, ",", &saveptr))
+                {
+                    char *end;
+                    long policy = strtol(token, &end, 10);
+                    if (end == token || policy <= BPRED_PERFECT ||
+                        policy >= NUM_BPRED_POLICIES)
+                    {
+                        fprintf(stderr, "Error: invalid predictor in -bpredsweep: %s\n", token);
+                        return 2;
+                    }
+                    // Without a size, the default is filled in once all the
+                    // arguments are parsed, so -bpredhistbits and the budgets
+                    // apply wherever they appear
+                    long size = 0;
+                    long max_size = bpred_size_is_history_bits((BPredPolicy)policy)
+                                        ? 30
+                                        : 65536;
+                    if (*end == ':')
+                    {
+                        size = strtol(end + 1, &end, 10);
+                        if (size < 1 || size > max_size)
+                        {
+                            end = token;
+                        }
+                    }
+                    if (*end != '\0')
+                    {
+                        fprintf(stderr, "Error: invalid predictor in -bpredsweep: %s\n", token);
+                        return 2;
+                    }
+                    BPRED_SWEEP.push_back({(BPredPolicy)policy, (uint32_t)size});
+                }
+                if (BPRED_SWEEP.empty())
+                {
+                    fprintf(stderr, "Error: invalid argument for -bpredsweep\n");
+                    return 2;
+                }
+                BPRED_ONLY = 1;
+            }
+            else if (strcmp(argv[i], "-bpredthreads") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -bpredthreads\n");
+                    return 2;
+                }
+
+                int threads = atoi(argv[i]);
+                if (threads < 1)
+                {
+                    fprintf(stderr, "Error: invalid argument for -bpredthreads\n");
+                    return 2;
+                }
+
+                BPRED_THREADS = threads;
+            }
+            else if (strcmp(argv[i], "-simpoint") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -simpoint\n");
+                    return 2;
+                }
+
+                int max_k = atoi(argv[i]);
+                if (max_k < 1)
+                {
+                    fprintf(stderr, "Error: invalid argument for -simpoint\n");
+                    return 2;
+                }
+
+                SIMPOINT_MAX_K = max_k;
+            }
+            else if (strcmp(argv[i], "-simpoint_interval") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -simpoint_interval\n");
+                    return 2;
+                }
+
+                SIMPOINT_INTERVAL = strtoull(argv[i], NULL, 10);
+                if (SIMPOINT_INTERVAL == 0)
+                {
+                    fprintf(stderr, "Error: invalid argument for -simpoint_interval\n");
+                    return 2;
+                }
+            }
+            else if (strcmp(argv[i], "-simpoint_warmup") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -simpoint_warmup\n");
+                    return 2;
+                }
+
+                SIMPOINT_WARMUP = strtoull(argv[i], NULL, 10);
+            }
+            else if (strcmp(argv[i], "-simpoint_validate") == 0)
+            {
+                SIMPOINT_VALIDATE = 1;
+            }
             else
             {
                 fprintf(stderr, "Error: unrecognized option: %s\n", argv[i]);
@@ -205,6 +1186,39 @@ int parse_args(int argc, char *argv[], char **trace_filename)
         return 2;
     }
 
+    for (BPredConfig &config : BPRED_SWEEP)
+    {
+        if (config.size == 0)
+        {
+            config.size = bpred_default_size(config.policy);
+        }
+    }
+
+    if (BPRED_ONLY && ((BPRED_SWEEP.empty() && BPRED_POLICY == BPRED_PERFECT) ||
+                       SIMPOINT_MAX_K))
+    {
+        fprintf(stderr, "Error: -bpredonly needs a non-perfect -bpredpolicy and no -simpoint\n");
+        return 2;
+    }
+
+    if (BPRED_PROFILE_TOP && (BPRED_ONLY || SIMPOINT_MAX_K))
+    {
+        fprintf(stderr, "Error: -bpredprofile needs the whole pipeline simulated, without -bpredonly or -simpoint\n");
+        return 2;
+    }
+
+    if (FETCH_QUEUE_DEPTH && FETCH_QUEUE_DEPTH < PIPE_WIDTH)
+    {
+        fprintf(stderr, "Error: -fetchqueue must be 0 or at least the pipe width\n");
+        return 2;
+    }
+
+    if (BTB_ENTRIES % BTB_ASSOC != 0)
+    {
+        fprintf(stderr, "Error: -btbentries must be a multiple of -btbassoc\n");
+        return 2;
+    }
+
     return 0;
 }
 
@@ -306,6 +1320,53 @@ void print_stats()
         printf("LAB2_BPRED_BRANCHES     \t : %10lu\n", stat_num_branches);
         printf("LAB2_BPRED_MISPRED      \t : %10lu\n", stat_num_mispred);
         printf("LAB2_MISPRED_RATE       \t : %10.3f\n", bpred_mispred_rate);
+        if (BPRED_SPEC_HISTORY)
+        {
+            printf("LAB2_BPRED_HIST_REPAIRS \t : %10lu\n",
+                   (unsigned long)pipeline->b_pred->stat_history_repairs);
+        }
+        if (BPRED_POLICY == BPRED_TOURNAMENT)
+        {
+            print_tournament_stats(pipeline->b_pred);
+        }
+    }
+
+    if (pipeline->btb)
+    {
+        BTB *btb = pipeline->btb;
+        ReturnAddressStack *ras = pipeline->ras;
+        double btb_hit_rate = 100.0 * (double)btb->stat_hits /
+                              (double)(btb->stat_lookups ? btb->stat_lookups : 1);
+
+        printf("LAB2_BTB_LOOKUPS        \t : %10lu\n",
+               (unsigned long)btb->stat_lookups);
+        printf("LAB2_BTB_HIT_RATE       \t : %10.3f\n", btb_hit_rate);
+        printf("LAB2_BTB_TARGET_MISPRED \t : %10lu\n",
+               (unsigned long)btb->stat_target_mispred);
+        printf("LAB2_RAS_RETURNS        \t : %10lu\n",
+               (unsigned long)ras->stat_returns);
+        printf("LAB2_FETCH_REDIRECTS    \t : %10lu\n",
+               (unsigned long)pipeline->stat_fetch_redirects);
+        printf("LAB2_REDIRECT_STALL_CYCLES \t : %10lu\n",
+               (unsigned long)pipeline->stat_fetch_redirect_cycles);
+    }
+
+    if (pipeline->fetch_queue)
+    {
+        printf("LAB2_FETCH_STARVED_CYCLES \t : %10lu\n",
+               (unsigned long)pipeline->stat_fetch_starved_cycles);
+        printf("LAB2_BACKEND_STALL_CYCLES \t : %10lu\n",
+               (unsigned long)pipeline->stat_backend_stall_cycles);
+        printf("LAB2_FETCH_QUEUE_FULL_CYCLES \t : %10lu\n",
+               (unsigned long)pipeline->stat_fetch_queue_full_cycles);
+        printf("LAB2_FETCH_QUEUE_AVG_OCC \t : %10.3f\n",
+               (double)pipeline->stat_fetch_queue_occupancy /
+                   (double)(stat_num_cycle ? stat_num_cycle : 1));
+    }
+
+    if (pipeline->bprofile)
+    {
+        print_branch_profile(pipeline->bprofile);
     }
 
     printf("\n");
@@ -322,5 +1383,47 @@ void print_usage(char *program_name)
     fprintf(stderr, "    -enableexefwd       Enable forwarding from Execute (EX) stage (disabled by\n");
     fprintf(stderr, "                        default)\n");
     fprintf(stderr, "    -bpredpolicy <num>  Set branch predictor [0: Perfect, 1: Always Taken,\n");
-    fprintf(stderr, "                        2: Gshare] (Default: 0)\n");
+    fprintf(stderr, "                        2: Gshare, 3: TAGE, 4: Hashed Perceptron,\n");
+    fprintf(stderr, "                        5: Tournament]\n");
+    fprintf(stderr, "                        (Default: 0)\n");
+    fprintf(stderr, "    -bpredhistbits <num>  Set PC and history bits indexing the Gshare and\n");
+    fprintf(stderr, "                        Tournament PHT\n");
+    fprintf(stderr, "                        (Default: 12)\n");
+    fprintf(stderr, "    -tagebudgetkb <num>  Set storage budget in KB of the TAGE predictor\n");
+    fprintf(stderr, "                        (Default: 8)\n");
+    fprintf(stderr, "    -perceptronbudgetkb <num>  Set storage budget in KB of the hashed\n");
+    fprintf(stderr, "                        perceptron predictor (Default: 8)\n");
+    fprintf(stderr, "    -bpredspechist      Update the predictor history speculatively at fetch,\n");
+    fprintf(stderr, "                        and train and repair it at WB (disabled by default)\n");
+    fprintf(stderr, "    -btbentries <num>   Set entries of the branch target buffer, 0 to fetch\n");
+    fprintf(stderr, "                        taken targets for free (Default: 0)\n");
+    fprintf(stderr, "    -btbassoc <num>     Set associativity of the branch target buffer\n");
+    fprintf(stderr, "                        (Default: 4)\n");
+    fprintf(stderr, "    -btbrepl <num>      Set branch target buffer replacement [0: LRU,\n");
+    fprintf(stderr, "                        1: FIFO, 2: Random] (Default: 0)\n");
+    fprintf(stderr, "    -rasentries <num>   Set entries of the return address stack (Default: 16)\n");
+    fprintf(stderr, "    -btbmisspenalty <num>  Set idle fetch cycles after a mispredicted target\n");
+    fprintf(stderr, "                        (Default: 1)\n");
+    fprintf(stderr, "    -bpredprofile <num>  Profile each conditional branch and report the\n");
+    fprintf(stderr, "                        <num> that lost the most fetch cycles (disabled by\n");
+    fprintf(stderr, "                        default)\n");
+    fprintf(stderr, "    -fetchqueue <num>   Set instructions held by a fetch queue between IF and\n");
+    fprintf(stderr, "                        ID, letting fetch run ahead of ID stalls; 0 for none\n");
+    fprintf(stderr, "                        (Default: 0)\n");
+    fprintf(stderr, "    -bpredonly          Evaluate only the branch predictor on the trace's\n");
+    fprintf(stderr, "                        branches, without the pipeline (disabled by default)\n");
+    fprintf(stderr, "    -bpredsweep <list>  Like -bpredonly, for each predictor in a comma-separated\n");
+    fprintf(stderr, "                        list of <policy>[:<size>], in one trace pass; the size\n");
+    fprintf(stderr, "                        is the history bits for Gshare and Tournament, else\n");
+    fprintf(stderr, "                        the budget in KB, set by -bpredhistbits and the\n");
+    fprintf(stderr, "                        budget options when omitted\n");
+    fprintf(stderr, "    -bpredthreads <num>  Split the -bpredsweep predictors across <num>\n");
+    fprintf(stderr, "                        threads (Default: 1)\n");
+    fprintf(stderr, "    -simpoint <num>     Simulate only up to <num> SimPoints and print weighted\n");
+    fprintf(stderr, "                        estimates (disabled by default)\n");
+    fprintf(stderr, "    -simpoint_interval <num>  Set instructions per SimPoint interval\n");
+    fprintf(stderr, "                        (Default: 100000)\n");
+    fprintf(stderr, "    -simpoint_warmup <num>  Set instructions warming the predictor before\n");
+    fprintf(stderr, "                        each SimPoint (Default: 100000)\n");
+    fprintf(stderr, "    -simpoint_validate  Also simulate the whole trace and print the errors\n");
 }
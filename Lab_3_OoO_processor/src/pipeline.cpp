@@ -17,6 +17,9 @@
 #include <climits>
 #include <algorithm>
 
+/** The number of trace records read at a time by pipe_skip_insts(). */
+#define PIPE_SKIP_BATCH 1024
+
 /**
  * The width of the pipeline; that is, the maximum number of instructions that
  * can be processed during any given cycle in each of the issue, schedule, and
@@ -139,6 +142,87 @@ void pipe_fetch_inst(Pipeline *p, PipelineLatch *fe_latch)
     inst->exe_wait_cycles = 0;
 }
 
+/**
+ * Fast-forward over the next trace records without simulating them.
+ * 
+ * The records are read in bulk. The pipeline must be empty; that is, new or
+ * just flushed.
+ * 
+ * @param p the pipeline
+ * @param num_insts the number of trace records to skip
+ * @return the number of records skipped, which is less than num_insts only at
+ *         the end of the trace
+ */
+uint64_t pipe_skip_insts(Pipeline *p, uint64_t num_insts)
+{
+    TraceRec trace_recs[PIPE_SKIP_BATCH];
+    uint64_t skipped = 0;
+
+    while (skipped < num_insts)
+    {
+        uint64_t batch = std::min<uint64_t>(num_insts - skipped,
+                                            PIPE_SKIP_BATCH);
+        uint8_t *buf = (uint8_t *)trace_recs;
+        size_t bytes_left = batch * sizeof(TraceRec);
+        size_t bytes_read_total = 0;
+        while (bytes_left > 0)
+        {
+            ssize_t bytes_read_last = read(p->trace_fd, buf + bytes_read_total,
+                                           bytes_left);
+            if (bytes_read_last <= 0)
+            {
+                break;
+            }
+            bytes_read_total += bytes_read_last;
+            bytes_left -= bytes_read_last;
+        }
+
+        uint64_t num_read = bytes_read_total / sizeof(TraceRec);
+        skipped += num_read;
+        p->last_inst_num += num_read;
+        p->next_decode_inst_num = p->last_inst_num + 1;
+
+        if (bytes_left > 0)
+        {
+            // End of the trace
+            p->halt = true;
+            break;
+        }
+    }
+    return skipped;
+}
+
+/**
+ * Squash every instruction in flight, leaving the pipeline, ROB, RAT, and
+ * EXEQ empty. The squashed instructions are dropped from the simulation.
+ * 
+ * @param p the pipeline
+ */
+void pipe_flush(Pipeline *p)
+{
+    free(p->rat);
+    free(p->rob);
+    free(p->exeq);
+    p->rat = rat_init();
+    p->rob = rob_init();
+    p->exeq = exeq_init();
+    p->next_decode_inst_num = p->last_inst_num + 1;
+
+    for (unsigned int i = 0; i < MAX_PIPE_WIDTH; i++)
+    {
+        p->FE_latch[i].valid = false;
+        p->FE_latch[i].stall = false;
+        p->ID_latch[i].valid = false;
+        p->ID_latch[i].stall = false;
+        p->SC_latch[i].valid = false;
+        p->SC_latch[i].stall = false;
+    }
+    for (unsigned int i = 0; i < MAX_WRITEBACKS; i++)
+    {
+        p->EX_latch[i].valid = false;
+    }
+}
+
 /**
  * Allocate and initialize a new pipeline.
  * 
@@ -159,6 +243,7 @@ Pipeline *pipe_init(int trace_fd)
     p->rob = rob_init();
     p->exeq = exeq_init();
     p->trace_fd = trace_fd;
+    p->next_decode_inst_num = 1;
     p->halt_inst_num = (uint64_t)(-1) - 3;
 
     for (unsigned int i = 0; i < PIPE_WIDTH; i++)
@@ -339,7 +424,6 @@ void pipe_cycle_fetch(Pipeline *p)
  */
 void pipe_cycle_decode(Pipeline *p)
 {
-    static uint64_t next_inst_num = 1;
     for (unsigned int i = 0; i < PIPE_WIDTH; i++)
     {
         if (!p->ID_latch[i].stall && !p->ID_latch[i].valid)
@@ -349,11 +433,11 @@ void pipe_cycle_decode(Pipeline *p)
             for (unsigned int j = 0; j < PIPE_WIDTH; j++)
             {
                 if (p->FE_latch[j].valid &&
-                    p->FE_latch[j].inst.inst_num == next_inst_num)
+                    p->FE_latch[j].inst.inst_num == p->next_decode_inst_num)
                 {
                     p->ID_latch[i] = p->FE_latch[j];
                     p->FE_latch[j].valid = false;
-                    next_inst_num++;
+                    p->next_decode_inst_num++;
                     break;
                 }
             }
@@ -721,8 +805,13 @@ void pipe_cycle_writeback(Pipeline *p)
     // TODO: Invalidate the instruction in the previous latch.
     for (unsigned int j = 0; j < MAX_WRITEBACKS; ++j)
     {
-        // check if inst valid and writing to reg
-        if (p->EX_latch[j].valid && p->EX_latch[j].inst.dest_reg != -1)
+        if (!p->EX_latch[j].valid)
+        {
+            continue;
+        }
+
+        // check if inst writing to reg
+        if (p->EX_latch[j].inst.dest_reg != -1)
         {
             rob_wakeup(p->rob, p->EX_latch[j].inst.dr_tag);
         }
@@ -173,6 +173,8 @@ typedef struct Pipeline
     int trace_fd;
     /** [Internal] The last inst_num assigned. */
     uint64_t last_inst_num;
+    /** [Internal] The inst_num of the next instruction to decode. */
+    uint64_t next_decode_inst_num;
     /** [Internal] The inst_num of the last instruction in the trace. */
     uint64_t halt_inst_num;
     /** [Internal] Whether the pipeline is done. */
@@ -294,4 +296,25 @@ void pipe_commit_inst(Pipeline *p, InstInfo inst);
  */
 void pipe_print_state(Pipeline *p);
 
+/**
+ * Fast-forward over the next trace records without simulating them.
+ * 
+ * The records are read in bulk. The pipeline must be empty; that is, new or
+ * just flushed.
+ * 
+ * @param p the pipeline
+ * @param num_insts the number of trace records to skip
+ * @return the number of records skipped, which is less than num_insts only at
+ *         the end of the trace
+ */
+uint64_t pipe_skip_insts(Pipeline *p, uint64_t num_insts);
+
+/**
+ * Squash every instruction in flight, leaving the pipeline, ROB, RAT, and
+ * EXEQ empty. The squashed instructions are dropped from the simulation.
+ * 
+ * @param p the pipeline
+ */
+void pipe_flush(Pipeline *p);
+
 #endif
@@ -7,6 +7,7 @@
 // 4100/6100 & CS 4290/6290.
 
 #include "pipeline.h"
+#include "simpoint.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -67,6 +68,44 @@ uint32_t LOAD_EXE_CYCLES = 4;
  */
 SchedulingPolicy SCHED_POLICY = SCHED_OUT_OF_ORDER;
 
+/**
+ * The largest number of SimPoints to simulate, or 0 to simulate the whole
+ * trace.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint.
+ */
+uint32_t SIMPOINT_MAX_K = 0;
+
+/**
+ * The number of instructions in each SimPoint interval.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint_interval.
+ */
+uint64_t SIMPOINT_INTERVAL = 100000;
+
+/**
+ * The number of instructions before each SimPoint that are simulated to fill
+ * the ROB but left out of the statistics.
+ * 
+ * (The pipeline has no predictor or cache to warm up, so only a short warm-up
+ * is needed.)
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint_warmup.
+ */
+uint64_t SIMPOINT_WARMUP = 10000;
+
+/**
+ * A Boolean indicating whether the whole trace should also be simulated to
+ * measure the error of the SimPoint estimates.
+ * 
+ * You should not modify this value directly; it is set by the command-line
+ * argument -simpoint_validate.
+ */
+uint32_t SIMPOINT_VALIDATE = 0;
+
 #define HEARTBEAT_CYCLES 10000
 #define STAT_CYCLES (HEARTBEAT_CYCLES * 50)
 
@@ -74,6 +113,8 @@ Pipeline *pipeline;
 uint64_t last_hbeat_inst = 0;
 
 int parse_args(int argc, char *argv[], char **trace_filename);
+int simulate_trace(const char *trace_filename);
+int simulate_simpoints(const char *trace_filename);
 int open_gunzip_pipe(const char *filename, int *fd, pid_t *pid);
 int check_heartbeat();
 void print_stats();
@@ -91,6 +132,32 @@ int main(int argc, char *argv[])
         return status;
     }
 
+    if (SIMPOINT_MAX_K)
+    {
+        return simulate_simpoints(trace_filename);
+    }
+
+    status = simulate_trace(trace_filename);
+    if (status != 0)
+    {
+        return status;
+    }
+
+    // Print statistics.
+    print_stats();
+    return 0;
+}
+
+/**
+ * Simulate the whole trace, leaving the final state in the global pipeline.
+ * 
+ * @param trace_filename the trace file to simulate
+ * @return 0 on success, or the exit status on failure
+ */
+int simulate_trace(const char *trace_filename)
+{
+    int status;
+
     // Open the trace file using gunzip.
     int trace_fd;
     pid_t pid;
@@ -103,6 +170,7 @@ int main(int argc, char *argv[])
 
     // Simulate the pipeline.
     pipeline = pipe_init(trace_fd);
+    last_hbeat_inst = 0;
     status = 0;
     while (status == 0 && !pipeline->halt)
     {
@@ -123,9 +191,161 @@ int main(int argc, char *argv[])
     {
         return 1;
     }
+    return 0;
+}
 
-    // Print statistics.
+/**
+ * Read trace records in bulk.
+ * 
+ * @param trace_fd the file descriptor from which to read trace records
+ * @param trace_recs the buffer to fill
+ * @param max_recs the size of the buffer in trace records
+ * @return the number of whole records read, which is 0 at the end of the trace
+ */
+static size_t read_trace_recs(int trace_fd, TraceRec *trace_recs,
+                              size_t max_recs)
+{
+    uint8_t *buf = (uint8_t *)trace_recs;
+    size_t bytes_left = max_recs * sizeof(TraceRec);
+    size_t bytes_read_total = 0;
+    while (bytes_left > 0)
+    {
+        ssize_t bytes_read_last = read(trace_fd, buf + bytes_read_total,
+                                       bytes_left);
+        if (bytes_read_last <= 0)
+        {
+            break;
+        }
+        bytes_read_total += bytes_read_last;
+        bytes_left -= bytes_read_last;
+    }
+    return bytes_read_total / sizeof(TraceRec);
+}
+
+/**
+ * Pick SimPoints from the basic block vectors of the trace, simulate only
+ * those intervals (each after a short, unmeasured warm-up), and print the
+ * weighted CPI. With -simpoint_validate, also simulate the whole trace and
+ * print the error.
+ * 
+ * @param trace_filename the trace file to simulate
+ * @return 0 on success, or the exit status on failure
+ */
+int simulate_simpoints(const char *trace_filename)
+{
+    int status;
+    int trace_fd;
+    pid_t pid;
+
+    // Profile the basic block vectors of the whole trace.
+    printf("Profiling trace file with gunzip: %s\n", trace_filename);
+    status = open_gunzip_pipe(trace_filename, &trace_fd, &pid);
+    if (status != 0)
+    {
+        return status;
+    }
+    SimPointProfiler *sp = simpoint_profiler_new(SIMPOINT_INTERVAL);
+    static TraceRec trace_recs[4096];
+    size_t num_read;
+    while ((num_read = read_trace_recs(trace_fd, trace_recs, 4096)) > 0)
+    {
+        for (size_t i = 0; i < num_read; i++)
+        {
+            simpoint_profile_inst(sp, trace_recs[i].inst_addr,
+                                  trace_recs[i].op_type == OP_CBR);
+        }
+    }
+    close(trace_fd);
+    waitpid(pid, NULL, 0);
+
+    std::vector<SimPoint> points = simpoint_pick(sp, SIMPOINT_MAX_K);
+    if (points.empty())
+    {
+        fprintf(stderr, "Error: trace is shorter than one SimPoint interval\n");
+        return 1;
+    }
+
+    // Simulate each SimPoint, fast-forwarding over the rest of the trace.
+    printf("Opening trace file with gunzip: %s\n", trace_filename);
+    status = open_gunzip_pipe(trace_filename, &trace_fd, &pid);
+    if (status != 0)
+    {
+        return status;
+    }
+    pipeline = pipe_init(trace_fd);
+
+    std::vector<double> cpis;
+    uint64_t detailed_inst = 0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        uint64_t start = points[i].interval * SIMPOINT_INTERVAL;
+        if (start > pipeline->last_inst_num + SIMPOINT_WARMUP)
+        {
+            pipe_skip_insts(pipeline,
+                            start - SIMPOINT_WARMUP - pipeline->last_inst_num);
+        }
+
+        // Retire the warm-up instructions before measuring.
+        uint64_t warmup_end = pipeline->stat_retired_inst;
+        if (start > pipeline->last_inst_num)
+        {
+            warmup_end += start - pipeline->last_inst_num;
+        }
+        while (!pipeline->halt && pipeline->stat_retired_inst < warmup_end)
+        {
+            pipe_cycle(pipeline);
+        }
+
+        uint64_t start_cycle = pipeline->stat_num_cycle;
+        uint64_t start_inst = pipeline->stat_retired_inst;
+        while (!pipeline->halt &&
+               pipeline->stat_retired_inst - start_inst < SIMPOINT_INTERVAL)
+        {
+            pipe_cycle(pipeline);
+        }
+
+        uint64_t num_inst = pipeline->stat_retired_inst - start_inst;
+        uint64_t num_cycle = pipeline->stat_num_cycle - start_cycle;
+        detailed_inst += num_inst;
+        cpis.push_back(num_inst ? (double)num_cycle / (double)num_inst : 0.0);
+
+        // The instructions in flight past the interval are dropped.
+        pipe_flush(pipeline);
+    }
+    close(trace_fd);
+    waitpid(pid, NULL, 0);
+
+    double cpi = simpoint_weighted(points, cpis);
+
+    simpoint_print_points(sp, points);
+    printf("%8s %10s\n", "POINT", "CPI");
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        printf("%8lu %10.3f\n", (unsigned long)i, cpis[i]);
+    }
+    printf("\n");
+    printf("LAB3_SIMPOINT_DETAILED_INST \t : %10lu\n",
+           (unsigned long)detailed_inst);
+    printf("LAB3_SIMPOINT_CPI       \t : %10.3f\n", cpi);
+
+    if (!SIMPOINT_VALIDATE)
+    {
+        printf("\n");
+        return 0;
+    }
+
+    status = simulate_trace(trace_filename);
+    if (status != 0)
+    {
+        return status;
+    }
     print_stats();
+
+    double full_cpi = (double)pipeline->stat_num_cycle /
+                      (double)pipeline->stat_retired_inst;
+    printf("LAB3_SIMPOINT_CPI_ERR_PERC \t : %10.3f\n",
+           100.0 * (cpi - full_cpi) / full_cpi);
+    printf("\n");
     return 0;
 }
 
@@ -200,6 +420,52 @@ int parse_args(int argc, char *argv[], char **trace_filename)
 
                 SCHED_POLICY = (SchedulingPolicy)policy;
             }
+            else if (strcmp(argv[i], "-simpoint") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -simpoint\n");
+                    return 2;
+                }
+
+                int max_k = atoi(argv[i]);
+                if (max_k < 1)
+                {
+                    fprintf(stderr, "Error: invalid argument for -simpoint\n");
+                    return 2;
+                }
+
+                SIMPOINT_MAX_K = max_k;
+            }
+            else if (strcmp(argv[i], "-simpoint_interval") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -simpoint_interval\n");
+                    return 2;
+                }
+
+                SIMPOINT_INTERVAL = strtoull(argv[i], NULL, 10);
+                if (SIMPOINT_INTERVAL == 0)
+                {
+                    fprintf(stderr, "Error: invalid argument for -simpoint_interval\n");
+                    return 2;
+                }
+            }
+            else if (strcmp(argv[i], "-simpoint_warmup") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -simpoint_warmup\n");
+                    return 2;
+                }
+
+                SIMPOINT_WARMUP = strtoull(argv[i], NULL, 10);
+            }
+            else if (strcmp(argv[i], "-simpoint_validate") == 0)
+            {
+                SIMPOINT_VALIDATE = 1;
+            }
             else
             {
                 fprintf(stderr, "Error: unrecognized option: %s\n", argv[i]);
@@ -326,4 +592,11 @@ void print_usage(char *program_name)
     fprintf(stderr, "    -schedpolicy <num>  Set scheduling policy [0: in-order, 1: out-of-order]\n");
     fprintf(stderr, "                        (default: 1)\n");
     fprintf(stderr, "    -loadlatency <num>  Set number of cycles for LD to execute (default: 4)\n");
+    fprintf(stderr, "    -simpoint <num>     Simulate only up to <num> SimPoints and print weighted\n");
+    fprintf(stderr, "                        estimates (disabled by default)\n");
+    fprintf(stderr, "    -simpoint_interval <num>  Set instructions per SimPoint interval\n");
+    fprintf(stderr, "                        (default: 100000)\n");
+    fprintf(stderr, "    -simpoint_warmup <num>  Set instructions simulated unmeasured before\n");
+    fprintf(stderr, "                        each SimPoint (default: 10000)\n");
+    fprintf(stderr, "    -simpoint_validate  Also simulate the whole trace and print the error\n");
 }
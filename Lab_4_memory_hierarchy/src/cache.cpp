@@ -19,6 +19,13 @@
 #include <iostream>
 #include <algorithm>
 
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The extra latency of a hit to a compressed line, in cycles. */
+#define DELAY_DECOMPRESS 2
+
 ///////////////////////////////////////////////////////////////////////////////
 //                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
 ///////////////////////////////////////////////////////////////////////////////
@@ -84,10 +91,12 @@ Cache *cache_new(uint64_t size, uint64_t associativity, uint64_t line_size,
             cl.coreID = 0;
             cl.last_access_time = 0;
             cl.hits = 0;
+            cl.segments = 0;
             cs.cache_lines.push_back(cl);
         }
         // Init the miss counter for set
         cs.misses = 0;
+        cs.segments_used = 0;
         c->cache_sets.push_back(cs);
     }
 
@@ -104,9 +113,88 @@ Cache *cache_new(uint64_t size, uint64_t associativity, uint64_t line_size,
     c->stat_write_miss = 0;
     c->stat_dirty_evicts = 0;
 
+    // Uncompressed unless cache_enable_compression() is called
+    c->compressor = NULL;
+    c->segments_per_set = 0;
+    c->last_access_delay = 0;
+    c->stat_compressed_hits = 0;
+    c->stat_decompress_delay = 0;
+    c->num_valid_lines = 0;
+    c->stat_valid_line_sum = 0;
+    c->stat_installs = 0;
+
     return c;
 }
 
+/**
+ * Compress the data store of a cache: each set keeps twice as many tags as it
+ * has ways, and its lines share the data segments of num_ways uncompressed
+ * lines according to their compressed sizes. Must be called right after
+ * cache_new(), and only with LRU replacement.
+ *
+ * @param c The cache to compress.
+ * @param comp The model of the compressed size of each line.
+ */
+void cache_enable_compression(Cache *c, Compressor *comp)
+{
+    c->compressor = comp;
+    c->segments_per_set = c->num_ways * (comp->line_size /
+                                         COMPRESS_SEGMENT_SIZE);
+    for (CacheSet &set : c->cache_sets)
+    {
+        set.cache_lines.resize(2 * c->num_ways, set.cache_lines[0]);
+    }
+}
+
+/**
+ * Print the effective capacity, compressed hits and decompression latency of
+ * a compressed cache, and the change in miss rate from an uncompressed cache
+ * of the same geometry fed the same accesses.
+ *
+ * @param c The compressed cache.
+ * @param uncompressed The uncompressed shadow of the cache.
+ * @param header The header to prefix each statistic with.
+ */
+void cache_print_compression_stats(Cache *c, Cache *uncompressed,
+                                   const char *header)
+{
+    unsigned int line_size = c->compressor->line_size;
+    double physical_kb = (double)c->num_sets * c->num_ways * line_size / 1024;
+    double effective_kb = 0.0;
+    if (c->stat_installs)
+    {
+        effective_kb = (double)c->stat_valid_line_sum / c->stat_installs *
+                       line_size / 1024;
+    }
+
+    double miss_percent = 0.0;
+    double uncompressed_miss_percent = 0.0;
+    unsigned long long accesses = c->stat_read_access + c->stat_write_access;
+    if (accesses)
+    {
+        miss_percent = 100.0 * (c->stat_read_miss + c->stat_write_miss) /
+                       accesses;
+        uncompressed_miss_percent = 100.0 * (uncompressed->stat_read_miss +
+                                             uncompressed->stat_write_miss) /
+                                    accesses;
+    }
+
+    printf("\n");
+    printf("%s_EFFECTIVE_CAPACITY_KB \t : %10.3f\n", header, effective_kb);
+    printf("%s_COMPRESSION_RATIO \t : %10.3f\n", header,
+           effective_kb / physical_kb);
+    printf("%s_COMPRESSED_HITS \t\t : %10llu\n", header,
+           c->stat_compressed_hits);
+    printf("%s_DECOMPRESS_DELAY \t\t : %10llu\n", header,
+           (unsigned long long)c->stat_decompress_delay);
+    printf("%s_MISS_PERC       \t\t : %10.3f\n", header, miss_percent);
+    printf("%s_UNCOMPRESSED_MISS_PERC \t : %10.3f\n", header,
+           uncompressed_miss_percent);
+    printf("%s_MISS_PERC_CHANGE \t\t : %10.3f\n", header,
+           miss_percent - uncompressed_miss_percent);
+    compressor_print_stats(c->compressor, header);
+}
+
 /*
 * Function to get index and tag bits
  * @param c The cache to access.
@@ -125,6 +213,43 @@ std::pair<uint64_t, uint64_t> get_index_tag_bits(Cache* c, uint64_t line_addr)
     return std::make_pair(index, tag);
 }
 
+/**
+ * Split a block of cache line addresses into set indices and tags at once,
+ * and prefetch the metadata of every set they map to into the host caches so
+ * that probing the sets afterwards does not stall on host memory. Pass the
+ * lookups to cache_access_lookup() and cache_install_lookup() to skip
+ * splitting the addresses again.
+ * 
+ * @param c The cache the lines would be looked up in.
+ * @param line_addrs The addresses of the cache lines (in units of the cache
+ *                   line size, i.e., excluding the line offset bits).
+ * @param count The number of addresses.
+ * @param lookups Set to the index and tag of each address.
+ */
+void cache_lookup_batch(Cache *c, const uint64_t *line_addrs, size_t count,
+                        CacheLookup *lookups)
+{
+    // A branch-free loop over plain arrays, which the compiler can vectorize
+    uint64_t index_mask = (1ULL << c->num_index_bits) - 1;
+    unsigned int num_index_bits = c->num_index_bits;
+    for (size_t i = 0; i < count; ++i)
+    {
+        lookups[i].index = line_addrs[i] & index_mask;
+        lookups[i].tag = line_addrs[i] >> num_index_bits;
+    }
+
+    // Each set keeps its lines in a separate array, so first fetch the sets
+    // and then, once they have had time to arrive, the lines they point to
+    for (size_t i = 0; i < count; ++i)
+    {
+        __builtin_prefetch(&c->cache_sets[lookups[i].index]);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        __builtin_prefetch(c->cache_sets[lookups[i].index].cache_lines.data());
+    }
+}
+
 /**
  * Access the cache at the given address.
  * 
@@ -142,13 +267,27 @@ std::pair<uint64_t, uint64_t> get_index_tag_bits(Cache* c, uint64_t line_addr)
 CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
                          unsigned int core_id)
 {
-    // TODO: Return HIT if the access hits in the cache, and MISS otherwise.
-    // Get the index value
-    uint64_t index = 0;
-    uint64_t tag = 0;
     std::pair<uint64_t, uint64_t> indexTagPair = get_index_tag_bits(c, line_addr);
-    index = indexTagPair.first;
-    tag = indexTagPair.second;
+    CacheLookup lookup = {indexTagPair.first, indexTagPair.second};
+    return cache_access_lookup(c, &lookup, is_write, core_id);
+}
+
+/**
+ * Access the cache at a line whose set index and tag are already known, e.g.,
+ * from cache_lookup_batch(), exactly as cache_access() would.
+ * 
+ * @param c The cache to access.
+ * @param lookup The set index and tag of the line to access.
+ * @param is_write Whether this access is a write.
+ * @param core_id The CPU core ID that requested this access.
+ * @return Whether the cache access was a hit or a miss.
+ */
+CacheResult cache_access_lookup(Cache *c, const CacheLookup *lookup,
+                                bool is_write, unsigned int core_id)
+{
+    // TODO: Return HIT if the access hits in the cache, and MISS otherwise.
+    uint64_t index = lookup->index;
+    uint64_t tag = lookup->tag;
     // Check if tag in set
     int lineIndex = -1;
     // check if line has tag
@@ -162,6 +301,16 @@ CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
             break;
         }
     }
+    // A hit to a compressed line waits for it to be decompressed
+    c->last_access_delay = 0;
+    if (lineIndex != -1 && c->compressor &&
+        c->cache_sets[index].cache_lines[lineIndex].segments * COMPRESS_SEGMENT_SIZE <
+            c->compressor->line_size)
+    {
+        c->last_access_delay = DELAY_DECOMPRESS;
+        c->stat_compressed_hits++;
+        c->stat_decompress_delay += DELAY_DECOMPRESS;
+    }
     // TODO: If is_write is true, mark the resident line as dirty.
     if (lineIndex != -1)
     {
@@ -201,6 +350,86 @@ CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
     return HIT;
 }
 
+/*
+* Function to install a line into a compressed cache, evicting the least
+* recently used lines of the set until a tag entry is free and the compressed
+* line fits into the free data segments
+ * @param c The cache to install the line into.
+ * @param lookup The set index and tag of the line to install.
+ * @param is_write Whether this install is triggered by a write.
+ * @param core_id The CPU core ID that requested this access.
+*/
+static void cache_install_compressed(Cache *c, const CacheLookup *lookup,
+                                     bool is_write, unsigned int core_id)
+{
+    CacheSet &set = c->cache_sets[lookup->index];
+    uint64_t line_addr = (lookup->tag << c->num_index_bits) | lookup->index;
+    unsigned int segments = compressor_line_segments(c->compressor, line_addr);
+
+    c->last_evicted_line.valid = false;
+    c->extra_evicted_lines.clear();
+    int freeIndex = -1;
+    while (true)
+    {
+        freeIndex = -1;
+        int lruIndex = -1;
+        uint64_t lruTime = std::numeric_limits<uint64_t>::max();
+        for (unsigned int i = 0; i < set.cache_lines.size(); ++i)
+        {
+            if (set.cache_lines[i].valid == false)
+            {
+                if (freeIndex == -1)
+                {
+                    freeIndex = i;
+                }
+            }
+            else if (set.cache_lines[i].last_access_time < lruTime)
+            {
+                lruIndex = i;
+                lruTime = set.cache_lines[i].last_access_time;
+            }
+        }
+        if (freeIndex != -1 &&
+            set.segments_used + segments <= c->segments_per_set)
+        {
+            break;
+        }
+
+        // Evict the LRU line; the first victim is the usual last evicted line
+        CacheLine &victim = set.cache_lines[lruIndex];
+        if (c->last_evicted_line.valid == false)
+        {
+            c->last_evicted_line = victim;
+        }
+        else
+        {
+            c->extra_evicted_lines.push_back(victim);
+        }
+        if (victim.dirty == true)
+        {
+            c->stat_dirty_evicts++;
+        }
+        set.segments_used -= victim.segments;
+        victim.valid = false;
+        c->num_valid_lines--;
+    }
+
+    CacheLine toInstall;
+    toInstall.dirty = is_write;
+    toInstall.valid = true;
+    toInstall.last_access_time = current_cycle;
+    toInstall.tag = lookup->tag;
+    toInstall.coreID = core_id;
+    toInstall.hits = 0;
+    toInstall.segments = segments;
+    set.cache_lines[freeIndex] = toInstall;
+    set.segments_used += segments;
+
+    c->num_valid_lines++;
+    c->stat_valid_line_sum += c->num_valid_lines;
+    c->stat_installs++;
+}
+
 /**
  * Install the cache line with the given address.
  * 
@@ -217,12 +446,34 @@ CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
 void cache_install(Cache *c, uint64_t line_addr, bool is_write,
                    unsigned int core_id)
 {
-    // TODO: Use cache_find_victim() to determine the victim line to evict.
     std::pair<uint64_t, uint64_t> indexTagPair = get_index_tag_bits(c, line_addr);
-    unsigned int setIndex = cache_find_victim(c, indexTagPair.first, core_id);
+    CacheLookup lookup = {indexTagPair.first, indexTagPair.second};
+    cache_install_lookup(c, &lookup, is_write, core_id);
+}
+
+/**
+ * Install a line whose set index and tag are already known, e.g., from
+ * cache_lookup_batch(), exactly as cache_install() would.
+ * 
+ * @param c The cache to install the line into.
+ * @param lookup The set index and tag of the line to install.
+ * @param is_write Whether this install is triggered by a write.
+ * @param core_id The CPU core ID that requested this access.
+ */
+void cache_install_lookup(Cache *c, const CacheLookup *lookup, bool is_write,
+                          unsigned int core_id)
+{
+    if (c->compressor)
+    {
+        cache_install_compressed(c, lookup, is_write, core_id);
+        return;
+    }
+
+    // TODO: Use cache_find_victim() to determine the victim line to evict.
+    unsigned int setIndex = cache_find_victim(c, lookup->index, core_id);
     // TODO: Copy it into a last_evicted_line field in the cache in order to
     //       track writebacks.
-    c->last_evicted_line = c->cache_sets[indexTagPair.first].cache_lines[setIndex];
+    c->last_evicted_line = c->cache_sets[lookup->index].cache_lines[setIndex];
     // TODO: Update the appropriate cache statistics.
     // Update the dirty stat if the evicted line was dirty
     if (c->last_evicted_line.valid == true && c->last_evicted_line.dirty == true)
@@ -234,11 +485,12 @@ void cache_install(Cache *c, uint64_t line_addr, bool is_write,
     toInstall.dirty = is_write;
     toInstall.valid = true;
     toInstall.last_access_time = current_cycle;
-    toInstall.tag = indexTagPair.second;
+    toInstall.tag = lookup->tag;
     toInstall.coreID = core_id;
     toInstall.hits = 0;
+    toInstall.segments = 0;
 
-    c->cache_sets[indexTagPair.first].cache_lines[setIndex] = toInstall;
+    c->cache_sets[lookup->index].cache_lines[setIndex] = toInstall;
 }
 
 /*
@@ -10,11 +10,13 @@
 #define __CACHE_H__
 
 #include "types.h"
+#include "compress.h"
 // You may add any other #include directives you need here, but make sure they
 // compile on the reference machine!
 
 #include <vector>
 #include <utility>
+#include <stddef.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 //                                 CONSTANTS                                 //
@@ -96,6 +98,11 @@ typedef struct CacheLine
     */
     unsigned long hits;
 
+    /*
+    * Number of data segments the line occupies (compressed caches only)
+    */
+    unsigned int segments;
+
 } CacheLine;
 
 /*
@@ -113,8 +120,24 @@ typedef struct CacheSet
     */
     unsigned long misses;
 
+    /*
+    * Number of data segments used by the valid lines (compressed caches only,
+    * whose cache_lines are tag entries decoupled from the data segments)
+    */
+    unsigned int segments_used;
+
 } CacheSet;
 
+/** A cache line address split into the index of its set and its tag. */
+typedef struct CacheLookup
+{
+    /** The index of the set the line maps to. */
+    uint64_t index;
+
+    /** The tag of the line. */
+    uint64_t tag;
+} CacheLookup;
+
 /** A single cache module. */
 typedef struct Cache
 {
@@ -158,6 +181,42 @@ typedef struct Cache
     std::vector<CacheSet> cache_sets;
 
 
+    /*
+    * Model of the compressed size of each line, or NULL if the cache is not
+    * compressed
+    */
+    Compressor *compressor;
+
+    /*
+    * Number of data segments in each set of a compressed cache
+    */
+    unsigned int segments_per_set;
+
+    /*
+    * Lines evicted by the last install besides last_evicted_line, since a
+    * compressed install may have to evict several lines to make room
+    */
+    std::vector<CacheLine> extra_evicted_lines;
+
+    /*
+    * Extra latency of the last access, for decompressing the line it hit
+    */
+    uint64_t last_access_delay;
+
+    /*
+    * Number of hits to compressed lines and the total decompression latency
+    */
+    unsigned long long stat_compressed_hits;
+    uint64_t stat_decompress_delay;
+
+    /*
+    * Sum over the installs of the number of valid lines in the cache, and the
+    * number of installs, for the average effective capacity
+    */
+    unsigned long long num_valid_lines;
+    unsigned long long stat_valid_line_sum;
+    unsigned long long stat_installs;
+
     /**
      * The total number of times this cache was accessed for a read.
      * You should initialize this to 0 and update it for every read!
@@ -235,6 +294,19 @@ Cache *cache_new(uint64_t size, uint64_t associativity, uint64_t line_size,
 CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
                          unsigned int core_id);
 
+/**
+ * Access the cache at a line whose set index and tag are already known, e.g.,
+ * from cache_lookup_batch(), exactly as cache_access() would.
+ * 
+ * @param c The cache to access.
+ * @param lookup The set index and tag of the line to access.
+ * @param is_write Whether this access is a write.
+ * @param core_id The CPU core ID that requested this access.
+ * @return Whether the cache access was a hit or a miss.
+ */
+CacheResult cache_access_lookup(Cache *c, const CacheLookup *lookup,
+                                bool is_write, unsigned int core_id);
+
 /**
  * Install the cache line with the given address.
  * 
@@ -251,6 +323,18 @@ CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
 void cache_install(Cache *c, uint64_t line_addr, bool is_write,
                    unsigned int core_id);
 
+/**
+ * Install a line whose set index and tag are already known, e.g., from
+ * cache_lookup_batch(), exactly as cache_install() would.
+ * 
+ * @param c The cache to install the line into.
+ * @param lookup The set index and tag of the line to install.
+ * @param is_write Whether this install is triggered by a write.
+ * @param core_id The CPU core ID that requested this access.
+ */
+void cache_install_lookup(Cache *c, const CacheLookup *lookup, bool is_write,
+                          unsigned int core_id);
+
 /**
  * Find which way in a given cache set to replace when a new cache line needs
  * to be installed. This should be chosen according to the cache's replacement
@@ -290,4 +374,43 @@ void cache_print_stats(Cache *c, const char *label);
 */
 std::pair<uint64_t, uint64_t> get_index_tag_bits(Cache* c, uint64_t line_addr);
 
+/**
+ * Compress the data store of a cache: each set keeps twice as many tags as it
+ * has ways, and its lines share the data segments of num_ways uncompressed
+ * lines according to their compressed sizes. Must be called right after
+ * cache_new(), and only with LRU replacement.
+ *
+ * @param c The cache to compress.
+ * @param comp The model of the compressed size of each line.
+ */
+void cache_enable_compression(Cache *c, Compressor *comp);
+
+/**
+ * Print the effective capacity, compressed hits and decompression latency of
+ * a compressed cache, and the change in miss rate from an uncompressed cache
+ * of the same geometry fed the same accesses.
+ *
+ * @param c The compressed cache.
+ * @param uncompressed The uncompressed shadow of the cache.
+ * @param header The header to prefix each statistic with.
+ */
+void cache_print_compression_stats(Cache *c, Cache *uncompressed,
+                                   const char *header);
+
+/**
+ * Split a block of cache line addresses into set indices and tags at once,
+ * and prefetch the metadata of every set they map to into the host caches so
+ * that probing the sets afterwards does not stall on host memory. Pass the
+ * lookups to cache_access_lookup() and cache_install_lookup() to skip
+ * splitting the addresses again.
+ * 
+ * @param c The cache the lines would be looked up in.
+ * @param line_addrs The addresses of the cache lines (in units of the cache
+ *                   line size, i.e., excluding the line offset bits).
+ * @param count The number of addresses.
+ * @param lookups Set to the index and tag of each address.
+ */
+void cache_lookup_batch(Cache *c, const uint64_t *line_addrs, size_t count,
+                        CacheLookup *lookups);
+
 #endif // __CACHE_H__
@@ -0,0 +1,544 @@
+// checkpoint.cpp
+// Defines the functions used to save the state of a simulation to a binary
+// checkpoint file and to restore it.
+
+#include "checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+
+#include <sstream>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The bytes every checkpoint file starts with. */
+#define CHECKPOINT_MAGIC "LAB4CKPT"
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The current mode under which the simulation is running, corresponding to
+ * which part of the lab is being evaluated.
+ */
+extern Mode SIM_MODE;
+
+/** The number of bytes in a cache line. */
+extern uint64_t CACHE_LINESIZE;
+
+/** The current clock cycle number. */
+extern uint64_t current_cycle;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* An open checkpoint file. The same functions save and restore each part of
+* the simulator, so that the two can never disagree on the file layout.
+*/
+typedef struct Checkpoint
+{
+    /*
+    * The checkpoint file
+    */
+    FILE *file;
+
+    /*
+    * Whether the state is being saved (or restored)
+    */
+    bool saving;
+
+    /*
+    * Whether every read and write so far succeeded and matched
+    */
+    bool ok;
+
+    /*
+    * What went wrong first, if anything
+    */
+    const char *error;
+} Checkpoint;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* Function to record the first thing that went wrong
+*/
+static void ckpt_fail(Checkpoint *ck, const char *error)
+{
+    if (ck->ok)
+    {
+        ck->ok = false;
+        ck->error = error;
+    }
+}
+
+/*
+* Function to save or restore the raw bytes of a value
+*/
+static void ckpt_bytes(Checkpoint *ck, void *data, size_t size)
+{
+    if (!ck->ok || size == 0)
+    {
+        return;
+    }
+    size_t done = ck->saving ? fwrite(data, 1, size, ck->file)
+                             : fread(data, 1, size, ck->file);
+    if (done != size)
+    {
+        ckpt_fail(ck, ck->saving ? "write failed" : "file is truncated");
+    }
+}
+
+/*
+* Function to save or restore a plain value
+*/
+template <typename T>
+static void ckpt_value(Checkpoint *ck, T &value)
+{
+    ckpt_bytes(ck, &value, sizeof(T));
+}
+
+/*
+* Function to save a value that the restoring run must already agree with,
+* e.g., a cache geometry, and check it on restore
+*/
+static void ckpt_check(Checkpoint *ck, uint64_t value, const char *error)
+{
+    uint64_t saved = value;
+    ckpt_value(ck, saved);
+    if (saved != value)
+    {
+        ckpt_fail(ck, error);
+    }
+}
+
+/*
+* Function to save or restore a vector of plain values whose length may differ
+* between runs
+*/
+template <typename T>
+static void ckpt_vector(Checkpoint *ck, std::vector<T> &values)
+{
+    uint64_t size = values.size();
+    ckpt_value(ck, size);
+    if (!ck->ok)
+    {
+        return;
+    }
+    if (!ck->saving)
+    {
+        values.resize(size);
+    }
+    ckpt_bytes(ck, values.data(), size * sizeof(T));
+}
+
+/*
+* Function to save or restore whether an optional part of the simulator exists,
+* which must match on restore
+* Returns whether it exists and should be saved or restored
+*/
+static bool ckpt_present(Checkpoint *ck, const void *part)
+{
+    ckpt_check(ck, part != NULL, "the simulated components differ");
+    return ck->ok && part != NULL;
+}
+
+/*
+* Function to save or restore the progress of a core and, on restore, skip its
+* trace ahead to the saved position
+*/
+static void ckpt_core(Checkpoint *ck, Core *core)
+{
+    unsigned long long trace_rec_count = core->trace_rec_count;
+    ckpt_value(ck, trace_rec_count);
+    if (!ck->ok)
+    {
+        return;
+    }
+    while (!ck->saving && !core->done &&
+           core->trace_rec_count < trace_rec_count)
+    {
+        core_read_trace(core);
+    }
+    if (core->trace_rec_count != trace_rec_count)
+    {
+        ckpt_fail(ck, "a trace is shorter than the checkpointed one");
+        return;
+    }
+
+    ckpt_value(ck, core->done);
+    ckpt_value(ck, core->snooze_end_cycle);
+    ckpt_value(ck, core->start_cycle);
+    ckpt_value(ck, core->inst_count);
+    ckpt_value(ck, core->done_inst_count);
+    ckpt_value(ck, core->done_cycle_count);
+}
+
+/*
+* Function to save or restore the tag store, replacement state and statistics
+* of a cache
+*/
+static void ckpt_cache(Checkpoint *ck, Cache *c)
+{
+    if (!ckpt_present(ck, c))
+    {
+        return;
+    }
+    ckpt_check(ck, c->num_sets, "a cache has a different number of sets");
+    ckpt_check(ck, c->num_ways, "a cache has a different associativity");
+    ckpt_check(ck, c->compressor != NULL,
+               "a cache is compressed in only one of the runs");
+    if (!ck->ok)
+    {
+        return;
+    }
+
+    for (CacheSet &set : c->cache_sets)
+    {
+        ckpt_value(ck, set.misses);
+        ckpt_value(ck, set.segments_used);
+        ckpt_bytes(ck, set.cache_lines.data(),
+                   set.cache_lines.size() * sizeof(CacheLine));
+    }
+    ckpt_value(ck, c->last_evicted_line);
+    ckpt_value(ck, c->stat_read_access);
+    ckpt_value(ck, c->stat_read_miss);
+    ckpt_value(ck, c->stat_write_access);
+    ckpt_value(ck, c->stat_write_miss);
+    ckpt_value(ck, c->stat_dirty_evicts);
+
+    if (c->compressor)
+    {
+        ckpt_value(ck, c->num_valid_lines);
+        ckpt_value(ck, c->stat_compressed_hits);
+        ckpt_value(ck, c->stat_decompress_delay);
+        ckpt_value(ck, c->stat_valid_line_sum);
+        ckpt_value(ck, c->stat_installs);
+        ckpt_value(ck, c->compressor->stat_side_lines);
+        ckpt_value(ck, c->compressor->stat_synthetic_lines);
+        ckpt_value(ck, c->compressor->stat_class_lines);
+    }
+}
+
+/*
+* Function to save or restore the entries and statistics of a TLB
+*/
+static void ckpt_tlb(Checkpoint *ck, TLB *tlb)
+{
+    if (!ckpt_present(ck, tlb))
+    {
+        return;
+    }
+    ckpt_check(ck, tlb->num_sets, "a TLB has a different number of sets");
+    ckpt_check(ck, tlb->num_ways, "a TLB has a different associativity");
+    if (!ck->ok)
+    {
+        return;
+    }
+
+    for (TLBSet &set : tlb->tlb_sets)
+    {
+        ckpt_bytes(ck, set.entries.data(),
+                   set.entries.size() * sizeof(TLBEntry));
+    }
+    ckpt_value(ck, tlb->stat_access);
+    ckpt_value(ck, tlb->stat_miss);
+}
+
+/*
+* Function to save or restore the row buffers and statistics of the DRAM
+*/
+static void ckpt_dram(Checkpoint *ck, DRAM *dram)
+{
+    if (!ckpt_present(ck, dram))
+    {
+        return;
+    }
+    ckpt_check(ck, dram->row_buffer_array.size(),
+               "the DRAM has a different number of banks");
+    ckpt_bytes(ck, dram->row_buffer_array.data(),
+               dram->row_buffer_array.size() * sizeof(RowBuffer));
+    ckpt_value(ck, dram->stat_read_access);
+    ckpt_value(ck, dram->stat_read_delay);
+    ckpt_value(ck, dram->stat_write_access);
+    ckpt_value(ck, dram->stat_write_delay);
+    ckpt_value(ck, dram->stat_row_conflicts);
+    ckpt_vector(ck, dram->ranks);
+    ckpt_vector(ck, dram->cores);
+    ckpt_vector(ck, dram->bank_stats);
+    ckpt_value(ck, dram->stat_row_hits);
+    ckpt_value(ck, dram->stat_row_empty);
+    ckpt_value(ck, dram->stat_refresh_delay);
+    ckpt_value(ck, dram->stat_act_delay);
+    ckpt_value(ck, dram->stat_early_closes);
+    ckpt_value(ck, dram->stat_premature_closes);
+    ckpt_value(ck, dram->stat_start_cycle);
+}
+
+/*
+* Function to save or restore the counters of the sampled L2 sets
+*/
+static void ckpt_set_sampler(Checkpoint *ck, SetSampler *ss)
+{
+    if (!ckpt_present(ck, ss))
+    {
+        return;
+    }
+    ckpt_check(ck, ss->sampled_sets.size(),
+               "a different number of L2 sets is sampled");
+    ckpt_bytes(ck, ss->sampled_sets.data(),
+               ss->sampled_sets.size() * sizeof(SampledSet));
+    ckpt_value(ck, ss->sampled_reads);
+    ckpt_value(ck, ss->sampled_read_misses);
+    ckpt_value(ck, ss->miss_credit);
+    ckpt_value(ck, ss->stat_filtered_read);
+    ckpt_value(ck, ss->stat_filtered_write);
+}
+
+/*
+* Function to save or restore the page tables, free frames and random number
+* generator of the page allocator
+*/
+static void ckpt_page_alloc(Checkpoint *ck, PageAllocator *pa)
+{
+    if (!ckpt_present(ck, pa))
+    {
+        return;
+    }
+    ckpt_check(ck, pa->policy, "the page allocation policy differs");
+    ckpt_check(ck, pa->num_frames, "the physical memory size differs");
+    if (!ck->ok)
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> mappings(
+            pa->page_table[i].begin(), pa->page_table[i].end());
+        ckpt_vector(ck, mappings);
+        if (!ck->saving)
+        {
+            pa->page_table[i].clear();
+            pa->page_table[i].insert(mappings.begin(), mappings.end());
+        }
+        ckpt_value(ck, pa->stat_frames_allocated[i]);
+    }
+
+    // std::vector<bool> is packed, so save it one byte per frame
+    std::vector<uint8_t> frame_used(pa->frame_used.begin(),
+                                    pa->frame_used.end());
+    ckpt_vector(ck, frame_used);
+    pa->frame_used.assign(frame_used.begin(), frame_used.end());
+
+    uint64_t num_lists = pa->free_lists.size();
+    ckpt_value(ck, num_lists);
+    if (!ck->ok)
+    {
+        return;
+    }
+    pa->free_lists.resize(num_lists);
+    for (std::vector<uint64_t> &free_list : pa->free_lists)
+    {
+        ckpt_vector(ck, free_list);
+    }
+    ckpt_vector(ck, pa->color_next_frame);
+
+    std::ostringstream rng_out;
+    rng_out << pa->rng;
+    std::string rng_text = rng_out.str();
+    std::vector<char> rng_state(rng_text.begin(), rng_text.end());
+    ckpt_vector(ck, rng_state);
+    if (ck->ok && !ck->saving)
+    {
+        std::istringstream rng_in(std::string(rng_state.begin(),
+                                              rng_state.end()));
+        rng_in >> pa->rng;
+    }
+}
+
+/*
+* Function to save or restore the tracked keys of a Space-Saving sketch and,
+* on restore, rebuild its index
+*/
+static void ckpt_sketch(Checkpoint *ck, TopKSketch *sketch)
+{
+    ckpt_check(ck, sketch->capacity, "the profiler size differs");
+    ckpt_vector(ck, sketch->entries);
+    if (ck->ok && !ck->saving)
+    {
+        sketch->index.clear();
+        for (unsigned int i = 0; i < sketch->entries.size(); ++i)
+        {
+            sketch->index[sketch->entries[i].key] = i;
+        }
+    }
+}
+
+/*
+* Function to save or restore the sketches and totals of the hot-spot profiler
+*/
+static void ckpt_profiler(Checkpoint *ck, Profiler *prof)
+{
+    if (!ckpt_present(ck, prof))
+    {
+        return;
+    }
+    for (unsigned int type = 0; type < PROFILE_NUM_ACCESS_TYPES; ++type)
+    {
+        ckpt_sketch(ck, &prof->pc_sketch[type]);
+        ckpt_sketch(ck, &prof->page_sketch[type]);
+        ckpt_value(ck, prof->stat_type_accesses[type]);
+        ckpt_value(ck, prof->stat_type_events[type]);
+    }
+    ckpt_value(ck, prof->stat_accesses);
+    ckpt_value(ck, prof->stat_events);
+}
+
+/*
+* Function to save or restore the whole simulation
+*/
+static void ckpt_simulation(Checkpoint *ck, MemorySystem *sys, Core **cores,
+                            unsigned int num_cores)
+{
+    char magic[sizeof(CHECKPOINT_MAGIC)] = CHECKPOINT_MAGIC;
+    ckpt_bytes(ck, magic, sizeof(magic));
+    if (ck->ok && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0)
+    {
+        ckpt_fail(ck, "not a checkpoint file");
+    }
+    ckpt_check(ck, CHECKPOINT_VERSION, "unsupported checkpoint version");
+    ckpt_check(ck, SIM_MODE, "the simulation mode differs");
+    ckpt_check(ck, num_cores, "the number of cores differs");
+    ckpt_check(ck, CACHE_LINESIZE, "the cache line size differs");
+
+    ckpt_value(ck, current_cycle);
+    for (unsigned int i = 0; i < num_cores; i++)
+    {
+        ckpt_core(ck, cores[i]);
+    }
+
+    ckpt_cache(ck, sys->dcache);
+    ckpt_cache(ck, sys->icache);
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        ckpt_cache(ck, sys->dcache_coreid[i]);
+        ckpt_cache(ck, sys->icache_coreid[i]);
+        ckpt_tlb(ck, sys->itlb_coreid[i]);
+        ckpt_tlb(ck, sys->dtlb_coreid[i]);
+    }
+    ckpt_check(ck, sys->num_levels, "the number of cache levels differs");
+    for (unsigned int i = 0; i < sys->num_levels && ck->ok; i++)
+    {
+        ckpt_cache(ck, sys->levels[i].caches[0]);
+        ckpt_cache(ck, sys->levels[i].caches[1]);
+        ckpt_value(ck, sys->levels[i].stat_bank_delay);
+    }
+    ckpt_cache(ck, sys->l2shadow);
+    ckpt_tlb(ck, sys->l2tlb);
+    ckpt_dram(ck, sys->dram);
+    ckpt_set_sampler(ck, sys->l2sampler);
+    ckpt_page_alloc(ck, sys->page_alloc);
+    ckpt_profiler(ck, sys->profiler);
+
+    ckpt_value(ck, sys->stat_page_walks);
+    ckpt_value(ck, sys->stat_page_walk_delay);
+    ckpt_value(ck, sys->stat_translation_delay);
+    ckpt_value(ck, sys->stat_ifetch_access);
+    ckpt_value(ck, sys->stat_load_access);
+    ckpt_value(ck, sys->stat_store_access);
+    ckpt_value(ck, sys->stat_ifetch_delay);
+    ckpt_value(ck, sys->stat_load_delay);
+    ckpt_value(ck, sys->stat_store_delay);
+}
+
+/*
+* Function to open a checkpoint file, save or restore the simulation, and
+* report any error
+*/
+static bool ckpt_run(const char *filename, bool saving, MemorySystem *sys,
+                     Core **cores, unsigned int num_cores)
+{
+    Checkpoint ck;
+    ck.file = fopen(filename, saving ? "wb" : "rb");
+    ck.saving = saving;
+    ck.ok = true;
+    ck.error = NULL;
+    if (ck.file == NULL)
+    {
+        perror(filename);
+        return false;
+    }
+
+    ckpt_simulation(&ck, sys, cores, num_cores);
+    if (ck.ok && !saving && fgetc(ck.file) != EOF)
+    {
+        ckpt_fail(&ck, "file has trailing data");
+    }
+    if (fclose(ck.file) != 0)
+    {
+        ckpt_fail(&ck, "write failed");
+    }
+
+    if (!ck.ok)
+    {
+        fprintf(stderr, "Error: couldn't %s checkpoint %s: %s\n",
+                saving ? "save" : "restore", filename, ck.error);
+    }
+    return ck.ok;
+}
+
+/**
+ * Save the state of the simulation to a checkpoint file: the current cycle,
+ * the trace position and progress of each core, the tag stores and
+ * replacement state of every cache and TLB, the DRAM row buffers, the page
+ * allocator, and all statistics.
+ *
+ * The hot-spot profiler is saved when profiling is enabled, so a restored
+ * run must profile with the same -profile size.
+ *
+ * No state of the C library rand() stream is saved, since the simulator
+ * draws no numbers from it: sim.cpp reseeds it with srand(42) at the start of
+ * every run, restored or not. Any random choice whose outcome must survive
+ * a restore has to come from a generator saved in the checkpoint, as the
+ * page allocator's is.
+ *
+ * @param filename The checkpoint file to write.
+ * @param sys The memory system to save.
+ * @param cores The cores to save.
+ * @param num_cores The number of cores.
+ * @return Whether the checkpoint was saved.
+ */
+bool checkpoint_save(const char *filename, MemorySystem *sys, Core **cores,
+                     unsigned int num_cores)
+{
+    return ckpt_run(filename, true, sys, cores, num_cores);
+}
+
+/**
+ * Restore the state of the simulation from a checkpoint file into a newly
+ * allocated memory system and newly opened cores, fast-forwarding each trace
+ * to where it was.
+ *
+ * The checkpoint must come from the same mode, traces, and cache and TLB
+ * geometries. Parameters that only affect what happens next, such as the
+ * replacement and DRAM page policies, may differ.
+ *
+ * @param filename The checkpoint file to read.
+ * @param sys The memory system to restore into.
+ * @param cores The cores to restore into.
+ * @param num_cores The number of cores.
+ * @return Whether the checkpoint was restored.
+ */
+bool checkpoint_restore(const char *filename, MemorySystem *sys, Core **cores,
+                        unsigned int num_cores)
+{
+    return ckpt_run(filename, false, sys, cores, num_cores);
+}
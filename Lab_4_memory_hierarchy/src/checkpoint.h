@@ -0,0 +1,65 @@
+// checkpoint.h
+// Contains declarations of functions used to save the state of a simulation
+// to a binary checkpoint file and to restore it.
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "types.h"
+#include "memsys.h"
+#include "core.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The version of the checkpoint file format. */
+#define CHECKPOINT_VERSION 9
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Save the state of the simulation to a checkpoint file: the current cycle,
+ * the trace position and progress of each core, the tag stores and
+ * replacement state of every cache and TLB, the DRAM row buffers, the page
+ * allocator, the hot-spot profiler, and all statistics.
+ *
+ * The hot-spot profiler is saved when profiling is enabled, so a restored
+ * run must profile with the same -profile size.
+ *
+ * No state of the C library rand() stream is saved, since the simulator
+ * draws no numbers from it: sim.cpp reseeds it with srand(42) at the start of
+ * every run, restored or not. Any random choice whose outcome must survive
+ * a restore has to come from a generator saved in the checkpoint, as the
+ * page allocator's is.
+ *
+ * @param filename The checkpoint file to write.
+ * @param sys The memory system to save.
+ * @param cores The cores to save.
+ * @param num_cores The number of cores.
+ * @return Whether the checkpoint was saved.
+ */
+bool checkpoint_save(const char *filename, MemorySystem *sys, Core **cores,
+                     unsigned int num_cores);
+
+/**
+ * Restore the state of the simulation from a checkpoint file into a newly
+ * allocated memory system and newly opened cores, fast-forwarding each trace
+ * to where it was.
+ *
+ * The checkpoint must come from the same mode, traces, and cache and TLB
+ * geometries. Parameters that only affect what happens next, such as the
+ * replacement and DRAM page policies, may differ.
+ *
+ * @param filename The checkpoint file to read.
+ * @param sys The memory system to restore into.
+ * @param cores The cores to restore into.
+ * @param num_cores The number of cores.
+ * @return Whether the checkpoint was restored.
+ */
+bool checkpoint_restore(const char *filename, MemorySystem *sys, Core **cores,
+                        unsigned int num_cores);
+
+#endif // __CHECKPOINT_H__
@@ -0,0 +1,191 @@
+// compress.cpp
+// Defines the functions used to model how well each cache line compresses,
+// for the compressed L2 cache.
+
+#include "compress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The share in percent of each class in the synthetic model, roughly the mix
+ * Base-Delta-Immediate compression finds across SPEC CPU2006.
+ */
+static const unsigned int COMPRESS_CLASS_PERCENT[NUM_COMPRESS_CLASSES] = {
+    10, 5, 15, 15, 15, 40};
+
+/** The names of the classes, as printed in the statistics. */
+static const char *COMPRESS_CLASS_NAMES[NUM_COMPRESS_CLASSES] = {
+    "ZERO", "REPEATED", "BASE8_DELTA1", "BASE8_DELTA2", "BASE8_DELTA4",
+    "NONE"};
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a compressibility model.
+ *
+ * Lines are sized by a synthetic model that draws the class of each line from
+ * a fixed mix with a hash of its address, so that a line always compresses the
+ * same way. An optional side file, e.g. produced by a data-value tracer, gives
+ * the compressed size of specific lines instead: one line per cache line with
+ * its byte address in hex and its compressed size in bytes.
+ *
+ * @param line_size The size of a cache line in bytes.
+ * @param side_filename The side file, or NULL to only use the synthetic model.
+ * @return A pointer to the model, or NULL if the side file cannot be read.
+ */
+Compressor *compressor_new(unsigned int line_size, const char *side_filename)
+{
+    Compressor *comp = new Compressor;
+    comp->line_size = line_size;
+    comp->stat_side_lines = 0;
+    comp->stat_synthetic_lines = 0;
+    for (int i = 0; i < NUM_COMPRESS_CLASSES; i++)
+    {
+        comp->stat_class_lines[i] = 0;
+    }
+
+    if (side_filename == NULL)
+    {
+        return comp;
+    }
+
+    FILE *file = fopen(side_filename, "r");
+    if (file == NULL)
+    {
+        perror(side_filename);
+        delete comp;
+        return NULL;
+    }
+    uint64_t addr;
+    unsigned int size;
+    while (fscanf(file, "%" SCNx64 " %u", &addr, &size) == 2)
+    {
+        unsigned int segments = (size + COMPRESS_SEGMENT_SIZE - 1) /
+                                COMPRESS_SEGMENT_SIZE;
+        comp->side_segments[addr / line_size] = segments;
+    }
+    if (!feof(file))
+    {
+        fprintf(stderr, "Error: %s is not a list of addresses and sizes\n",
+                side_filename);
+        fclose(file);
+        delete comp;
+        return NULL;
+    }
+    fclose(file);
+    return comp;
+}
+
+/*
+* Function to get the compressed size in bytes of a line of the given class
+*/
+static unsigned int compress_class_bytes(CompressClass cls,
+                                         unsigned int line_size)
+{
+    unsigned int values = line_size / 8;
+    switch (cls)
+    {
+    case COMPRESS_ZERO:
+        return 1;
+    case COMPRESS_REPEATED:
+        return 8;
+    case COMPRESS_BASE8_DELTA1:
+        return 8 + (values - 1) * 1;
+    case COMPRESS_BASE8_DELTA2:
+        return 8 + (values - 1) * 2;
+    case COMPRESS_BASE8_DELTA4:
+        return 8 + (values - 1) * 4;
+    default:
+        return line_size;
+    }
+}
+
+/*
+* Function to draw the class of a line from the synthetic mix, by a SplitMix64
+* hash of its address
+*/
+static CompressClass compress_synthetic_class(uint64_t line_addr)
+{
+    uint64_t z = line_addr + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+
+    unsigned int percent = z % 100;
+    for (int i = 0; i < NUM_COMPRESS_CLASSES; i++)
+    {
+        if (percent < COMPRESS_CLASS_PERCENT[i])
+        {
+            return (CompressClass)i;
+        }
+        percent -= COMPRESS_CLASS_PERCENT[i];
+    }
+    return COMPRESS_NONE;
+}
+
+/**
+ * Get the number of data segments a cache line occupies once compressed.
+ *
+ * @param comp The compressibility model.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return The number of COMPRESS_SEGMENT_SIZE segments, at least 1 and at
+ *         most a whole line.
+ */
+unsigned int compressor_line_segments(Compressor *comp, uint64_t line_addr)
+{
+    unsigned int max_segments = comp->line_size / COMPRESS_SEGMENT_SIZE;
+    unsigned int segments;
+
+    auto side = comp->side_segments.find(line_addr);
+    if (side != comp->side_segments.end())
+    {
+        comp->stat_side_lines++;
+        segments = side->second;
+    }
+    else
+    {
+        CompressClass cls = compress_synthetic_class(line_addr);
+        comp->stat_synthetic_lines++;
+        comp->stat_class_lines[cls]++;
+        unsigned int bytes = compress_class_bytes(cls, comp->line_size);
+        segments = (bytes + COMPRESS_SEGMENT_SIZE - 1) / COMPRESS_SEGMENT_SIZE;
+    }
+
+    if (segments < 1)
+    {
+        segments = 1;
+    }
+    if (segments > max_segments)
+    {
+        segments = max_segments;
+    }
+    return segments;
+}
+
+/**
+ * Print how the lines were sized: by the side file, or by the synthetic model
+ * in each class.
+ *
+ * @param comp The compressibility model.
+ * @param header The header to prefix each statistic with.
+ */
+void compressor_print_stats(Compressor *comp, const char *header)
+{
+    printf("%s_SIDE_FILE_LINES \t\t : %10llu\n", header,
+           comp->stat_side_lines);
+    printf("%s_SYNTHETIC_LINES \t\t : %10llu\n", header,
+           comp->stat_synthetic_lines);
+    for (int i = 0; i < NUM_COMPRESS_CLASSES; i++)
+    {
+        printf("%s_CLASS_%-12s \t : %10llu\n", header, COMPRESS_CLASS_NAMES[i],
+               comp->stat_class_lines[i]);
+    }
+}
@@ -0,0 +1,103 @@
+// compress.h
+// Contains declarations of data structures and functions used to model how
+// well each cache line compresses, for the compressed L2 cache.
+
+#ifndef __COMPRESS_H__
+#define __COMPRESS_H__
+
+#include "types.h"
+
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The size in bytes of the data segments compressed lines are stored in. */
+#define COMPRESS_SEGMENT_SIZE 8
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* Compressibility classes of the synthetic model, after the encodings of
+* Base-Delta-Immediate compression
+*/
+typedef enum CompressClassEnum
+{
+    COMPRESS_ZERO = 0,          // All bytes are zero.
+    COMPRESS_REPEATED = 1,      // One 8-byte value repeated.
+    COMPRESS_BASE8_DELTA1 = 2,  // An 8-byte base and 1-byte deltas.
+    COMPRESS_BASE8_DELTA2 = 3,  // An 8-byte base and 2-byte deltas.
+    COMPRESS_BASE8_DELTA4 = 4,  // An 8-byte base and 4-byte deltas.
+    COMPRESS_NONE = 5,          // Incompressible.
+    NUM_COMPRESS_CLASSES = 6,
+} CompressClass;
+
+/** A model of the compressed size of each cache line. */
+typedef struct Compressor
+{
+    /*
+    * Number of bytes in a cache line
+    */
+    unsigned int line_size;
+
+    /*
+    * Compressed size in segments of the lines listed in the side file, by
+    * cache line address
+    */
+    std::unordered_map<uint64_t, unsigned int> side_segments;
+
+    /*
+    * Number of lines sized by the side file and by the synthetic model
+    */
+    unsigned long long stat_side_lines;
+    unsigned long long stat_synthetic_lines;
+
+    /*
+    * Number of lines sized by the synthetic model in each class
+    */
+    unsigned long long stat_class_lines[NUM_COMPRESS_CLASSES];
+} Compressor;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a compressibility model.
+ *
+ * Lines are sized by a synthetic model that draws the class of each line from
+ * a fixed mix with a hash of its address, so that a line always compresses the
+ * same way. An optional side file, e.g. produced by a data-value tracer, gives
+ * the compressed size of specific lines instead: one line per cache line with
+ * its byte address in hex and its compressed size in bytes.
+ *
+ * @param line_size The size of a cache line in bytes.
+ * @param side_filename The side file, or NULL to only use the synthetic model.
+ * @return A pointer to the model, or NULL if the side file cannot be read.
+ */
+Compressor *compressor_new(unsigned int line_size, const char *side_filename);
+
+/**
+ * Get the number of data segments a cache line occupies once compressed.
+ *
+ * @param comp The compressibility model.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return The number of COMPRESS_SEGMENT_SIZE segments, at least 1 and at
+ *         most a whole line.
+ */
+unsigned int compressor_line_segments(Compressor *comp, uint64_t line_addr);
+
+/**
+ * Print how the lines were sized: by the side file, or by the synthetic model
+ * in each class.
+ *
+ * @param comp The compressibility model.
+ * @param header The header to prefix each statistic with.
+ */
+void compressor_print_stats(Compressor *comp, const char *header);
+
+#endif // __COMPRESS_H__
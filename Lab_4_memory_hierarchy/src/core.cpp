@@ -12,6 +12,8 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <iostream>
+#include <algorithm>
+#include <vector>
 
 extern uint64_t current_cycle;
 
@@ -59,6 +61,9 @@ void core_cycle(Core *core)
     uint64_t ld_delay = 0;
     uint64_t bubble_cycles = 0;
 
+    // Let the memory system attribute this instruction's accesses to its PC.
+    core->memsys->profile_inst_addr = core->trace_inst_addr;
+
     ifetch_delay = memsys_access(core->memsys, core->trace_inst_addr,
                                  ACCESS_TYPE_IFETCH, core->core_id);
     if (ifetch_delay > 1)
@@ -91,6 +96,116 @@ void core_cycle(Core *core)
     core_read_trace(core);
 }
 
+// Make the memory accesses of the current instruction to warm up the caches
+// and DRAM row buffers, without timing, stalling or counting the instruction,
+// and move on to the next one. Used to fast-forward before timing starts.
+void core_warm_inst(Core *core)
+{
+    if (core->done)
+    {
+        return;
+    }
+
+    memsys_warm_access(core->memsys, core->trace_inst_addr,
+                       ACCESS_TYPE_IFETCH, core->core_id, NULL);
+    if (core->trace_inst_type == INST_TYPE_LOAD)
+    {
+        memsys_warm_access(core->memsys, core->trace_ldst_addr,
+                           ACCESS_TYPE_LOAD, core->core_id, NULL);
+    }
+    if (core->trace_inst_type == INST_TYPE_STORE)
+    {
+        memsys_warm_access(core->memsys, core->trace_ldst_addr,
+                           ACCESS_TYPE_STORE, core->core_id, NULL);
+    }
+
+    core_read_trace(core);
+}
+
+// Warm up with the next num_insts instructions of every core, one instruction
+// per core per cycle, exactly as calling core_warm_inst() on each core and
+// then advancing the cycle would. The instructions are read ahead in batches
+// so that their cache lookups are made at once, and the cache sets they touch
+// prefetched into the host caches, before they are accessed. Returns the number of cycles warmed, which is
+// less than num_insts if every trace ended.
+uint64_t core_warm_insts(Core **cores, unsigned int num_cores,
+                         uint64_t num_insts)
+{
+    // Up to two accesses per instruction: the fetch and a load or store
+    std::vector<uint64_t> addrs(num_cores * 2 * CORE_WARM_BATCH);
+    std::vector<AccessType> types(num_cores * 2 * CORE_WARM_BATCH);
+    std::vector<MemsysLookup> lookups(num_cores * 2 * CORE_WARM_BATCH);
+    std::vector<size_t> inst_end(num_cores * CORE_WARM_BATCH);
+    std::vector<uint64_t> num_read(num_cores);
+
+    uint64_t num_cycles = 0;
+    while (num_cycles < num_insts)
+    {
+        uint64_t batch = std::min<uint64_t>(num_insts - num_cycles,
+                                            CORE_WARM_BATCH);
+        uint64_t batch_cycles = 0;
+        for (unsigned int c = 0; c < num_cores; c++)
+        {
+            Core *core = cores[c];
+            uint64_t *core_addrs = &addrs[c * 2 * CORE_WARM_BATCH];
+            AccessType *core_types = &types[c * 2 * CORE_WARM_BATCH];
+            size_t *core_inst_end = &inst_end[c * CORE_WARM_BATCH];
+            size_t n = 0;
+            uint64_t j = 0;
+            for (; j < batch && !core->done; j++)
+            {
+                core_addrs[n] = core->trace_inst_addr;
+                core_types[n++] = ACCESS_TYPE_IFETCH;
+                if (core->trace_inst_type == INST_TYPE_LOAD)
+                {
+                    core_addrs[n] = core->trace_ldst_addr;
+                    core_types[n++] = ACCESS_TYPE_LOAD;
+                }
+                if (core->trace_inst_type == INST_TYPE_STORE)
+                {
+                    core_addrs[n] = core->trace_ldst_addr;
+                    core_types[n++] = ACCESS_TYPE_STORE;
+                }
+                core_inst_end[j] = n;
+                core_read_trace(core);
+            }
+            num_read[c] = j;
+            batch_cycles = std::max(batch_cycles, j);
+            memsys_lookup_batch(core->memsys, core_addrs, core_types, n,
+                                core->core_id,
+                                &lookups[c * 2 * CORE_WARM_BATCH]);
+        }
+
+        // Replay the accesses in the same order as without the read-ahead
+        for (uint64_t j = 0; j < batch_cycles; j++)
+        {
+            for (unsigned int c = 0; c < num_cores; c++)
+            {
+                if (j >= num_read[c])
+                {
+                    continue;
+                }
+                size_t *core_inst_end = &inst_end[c * CORE_WARM_BATCH];
+                size_t k = j == 0 ? 0 : core_inst_end[j - 1];
+                for (; k < core_inst_end[j]; k++)
+                {
+                    size_t a = c * 2 * CORE_WARM_BATCH + k;
+                    memsys_warm_access(cores[c]->memsys, addrs[a], types[a],
+                                       cores[c]->core_id, &lookups[a]);
+                }
+            }
+            current_cycle++;
+        }
+        num_cycles += batch_cycles;
+
+        if (batch_cycles < batch)
+        {
+            break;
+        }
+    }
+    return num_cycles;
+}
+
 void core_read_trace(Core *core)
 {
     uint32_t inst_addr;
@@ -106,7 +221,11 @@ void core_read_trace(Core *core)
     {
         core->done = true;
         core->done_inst_count = core->inst_count;
-        core->done_cycle_count = current_cycle;
+        core->done_cycle_count = current_cycle - core->start_cycle;
+    }
+    else
+    {
+        core->trace_rec_count++;
     }
 
     core->trace_inst_addr = inst_addr;
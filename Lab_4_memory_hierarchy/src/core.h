@@ -12,6 +12,9 @@
 #include "memsys.h"
 #include <sys/types.h>
 
+// Number of instructions per core read ahead by core_warm_insts().
+#define CORE_WARM_BATCH 64
+
 typedef struct Core
 {
     unsigned int core_id;
@@ -26,6 +29,10 @@ typedef struct Core
 
     bool done;
 
+    // Number of trace records read, to find the same trace position again
+    // when a checkpoint is restored.
+    unsigned long long trace_rec_count;
+
     uint64_t trace_inst_addr;
     uint64_t trace_inst_type;
     uint64_t trace_ldst_addr;
@@ -33,6 +40,9 @@ typedef struct Core
     // Used to stall when waiting for data to return from memory.
     uint64_t snooze_end_cycle;
 
+    // The cycle at which timing started, after any warm-up.
+    uint64_t start_cycle;
+
     unsigned long long inst_count;
     unsigned long long done_inst_count;
     unsigned long long done_cycle_count;
@@ -41,6 +51,9 @@ typedef struct Core
 Core *core_new(MemorySystem *memsys, const char *trace_filename,
                unsigned int core_id);
 void core_cycle(Core *core);
+void core_warm_inst(Core *core);
+uint64_t core_warm_insts(Core **cores, unsigned int num_cores,
+                         uint64_t num_insts);
 void core_print_stats(Core *core);
 void core_read_trace(Core *core);
 
@@ -14,6 +14,7 @@
 #include <math.h>
 #include <limits>
 #include <iostream>
+#include <algorithm>
 
 ///////////////////////////////////////////////////////////////////////////////
 //                                 CONSTANTS                                 //
@@ -46,6 +47,54 @@
 /** The number of banks in the DRAM module. */
 #define NUM_BANKS 16
 
+/** The number of lines a core under a bandwidth cap may transfer in a burst. */
+#define DRAM_TOKEN_BURST 16
+
+/**
+ * The number of accesses to a bank after which the hybrid page policy decides
+ * again whether the bank leaves rows open.
+ */
+#define DRAM_HYBRID_EPOCH 64
+
+/** The number of ranks the banks are split between, consecutive banks first. */
+#define NUM_RANKS 2
+
+/** The number of cycles per nanosecond, to convert the DDR timings below. */
+#define DRAM_CYCLES_PER_NS 3
+
+/** The average interval between refreshes of a rank (tREFI, 7.8 us). */
+#define DRAM_REFI 23400
+
+/** The time a rank is blocked by a refresh (tRFC, 160 ns), in cycles. */
+#define DELAY_RFC 480
+
+/** The minimum time between activations in a rank (tRRD, 6 ns), in cycles. */
+#define DELAY_RRD 18
+
+/** The window in which a rank allows at most four activations (tFAW, 30 ns). */
+#define DELAY_FAW 90
+
+/*
+* Energy model: DDR3-1600 2 Gb x8 device currents (mA) and supply voltage (V)
+* from a vendor datasheet, with eight devices per rank. Current times time
+* times voltage gives the energy of each command in pJ.
+*/
+#define DRAM_VDD 1.5
+#define DRAM_IDD0 55.0
+#define DRAM_IDD2N 32.0
+#define DRAM_IDD3N 38.0
+#define DRAM_IDD4R 157.0
+#define DRAM_IDD4W 128.0
+#define DRAM_IDD5 155.0
+#define DRAM_DEVICES_PER_RANK 8
+
+/** The row cycle and row active times (tRC, tRAS) of the energy model, in ns. */
+#define DRAM_TRC_NS 48.75
+#define DRAM_TRAS_NS 35.0
+
+/** The time a burst of one cache line occupies the data bus, in ns. */
+#define DRAM_TBURST_NS 5.0
+
 ///////////////////////////////////////////////////////////////////////////////
 //                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
 ///////////////////////////////////////////////////////////////////////////////
@@ -62,6 +111,18 @@ extern uint64_t CACHE_LINESIZE;
 /** Which page policy the DRAM should use. */
 extern DRAMPolicy DRAM_PAGE_POLICY;
 
+/** Whether DRAM accesses wait for refreshes and the tRRD and tFAW limits. */
+extern bool DRAM_TIMING;
+
+/** The idle cycles after which the timeout page policy closes a row. */
+extern uint64_t DRAM_ROW_TIMEOUT;
+
+/** The DRAM bandwidth cap of each core in GB/s, or 0 if uncapped. */
+extern double DRAM_CORE_BW_CAP[2];
+
+/** The current cycle of the simulation. */
+extern uint64_t current_cycle;
+
 ///////////////////////////////////////////////////////////////////////////////
 //                           FUNCTION DEFINITIONS                            //
 ///////////////////////////////////////////////////////////////////////////////
@@ -90,14 +151,38 @@ DRAM *dram_new()
     dram->stat_read_delay = 0;
     dram->stat_write_access = 0;
     dram->stat_write_delay = 0;
+    dram->stat_row_conflicts = 0;
+    dram->stat_row_hits = 0;
+    dram->stat_row_empty = 0;
+    dram->stat_refresh_delay = 0;
+    dram->stat_act_delay = 0;
+    dram->stat_early_closes = 0;
+    dram->stat_premature_closes = 0;
+    dram->stat_start_cycle = current_cycle;
 
     // init the row buffer array
     // NOTE: Recitation slide mentions always use 16 banks
-    dram->row_buffer_array.reserve(NUM_BANKS);
+    dram->row_buffer_array.resize(NUM_BANKS);
 
     for (unsigned int i = 0; i < NUM_BANKS; ++i)
     {
         dram->row_buffer_array[i].valid = false;
+        dram->row_buffer_array[i].last_access_cycle = 0;
+        dram->row_buffer_array[i].closed_early = false;
+        dram->row_buffer_array[i].hit_counter = 2;
+        dram->row_buffer_array[i].keep_open = true;
+        dram->row_buffer_array[i].epoch_accesses = 0;
+        dram->row_buffer_array[i].epoch_row_hits = 0;
+    }
+    dram->bank_stats.assign(NUM_BANKS, DRAMBankStats());
+    dram->ranks.assign(NUM_RANKS, DRAMRank());
+
+    // Up to two cores, each starting with a full token bucket
+    dram->cores.assign(2, DRAMCore());
+    for (DRAMCore &dram_core : dram->cores)
+    {
+        dram_core.tokens = DRAM_TOKEN_BURST;
+        dram_core.bucket_cycle = current_cycle;
     }
 
     dram->num_bank_bits = log2(NUM_BANKS);
@@ -106,6 +191,174 @@ DRAM *dram_new()
     return dram;
 }
 
+/*
+* Function to convert a cache line address to the address of its row buffer
+* sized chunk, whose low bits select the bank
+*/
+static uint64_t dram_row_addr(uint64_t line_addr)
+{
+    // Convert the line address to complete address
+    // Get the bits for block offset and shift address by that amount
+    line_addr = line_addr << (int)log2(CACHE_LINESIZE);
+    // To remove the column and byte in bus bits
+    return line_addr >> (int)log2(ROW_BUFFER_SIZE);
+}
+
+/*
+* Function to count a read or write burst to a bank
+*/
+static void dram_count_column_access(DRAM *dram, uint64_t bank,
+                                     bool is_dram_write)
+{
+    if (is_dram_write)
+    {
+        dram->bank_stats[bank].writes++;
+    }
+    else
+    {
+        dram->bank_stats[bank].reads++;
+    }
+}
+
+/*
+* Function to take a token from the bandwidth cap of a core, which refills at
+* the capped rate up to DRAM_TOKEN_BURST lines
+ * @param dram_core The core to throttle.
+ * @param cap_gbps The bandwidth cap of the core in GB/s, or 0 if uncapped.
+ * @return the number of cycles the access waits for a token
+*/
+static uint64_t dram_throttle(DRAMCore *dram_core, double cap_gbps)
+{
+    if (cap_gbps <= 0)
+    {
+        return 0;
+    }
+
+    // Lines per cycle: GB/s are bytes per ns
+    double rate = cap_gbps / CACHE_LINESIZE / DRAM_CYCLES_PER_NS;
+    if (current_cycle > dram_core->bucket_cycle)
+    {
+        dram_core->tokens = std::min((double)DRAM_TOKEN_BURST,
+                                     dram_core->tokens +
+                                     (current_cycle - dram_core->bucket_cycle) *
+                                     rate);
+        dram_core->bucket_cycle = current_cycle;
+    }
+
+    // Waits queue up behind the previous throttled access
+    uint64_t wait = 0;
+    if (dram_core->tokens < 1)
+    {
+        wait = (uint64_t)ceil((1 - dram_core->tokens) / rate);
+        dram_core->tokens += wait * rate;
+    }
+    dram_core->tokens -= 1;
+    dram_core->bucket_cycle += wait;
+    return dram_core->bucket_cycle - current_cycle;
+}
+
+/*
+* Function to precharge the open row of a bank before a conflicting access
+* arrives, as decided by an adaptive page policy
+*/
+static void dram_close_row(DRAM *dram, uint64_t bank)
+{
+    dram->row_buffer_array[bank].valid = false;
+    dram->row_buffer_array[bank].closed_early = true;
+    dram->bank_stats[bank].precharges++;
+    dram->stat_early_closes++;
+}
+
+/*
+* Function to train the predicted or hybrid page policy of a bank with whether
+* the last access went to the same row as the one before, and decide whether
+* to leave the row open for the next access
+*/
+static bool dram_keep_row_open(RowBuffer *row_buffer, bool same_row)
+{
+    if (DRAM_PAGE_POLICY == PREDICTED_PAGE)
+    {
+        if (same_row && row_buffer->hit_counter < 3)
+        {
+            row_buffer->hit_counter++;
+        }
+        if (!same_row && row_buffer->hit_counter > 0)
+        {
+            row_buffer->hit_counter--;
+        }
+        return row_buffer->hit_counter >= 2;
+    }
+
+    // Leaving rows open pays off when more than half of the accesses hit,
+    // since a conflict costs an extra precharge as long as an activation
+    row_buffer->epoch_accesses++;
+    row_buffer->epoch_row_hits += same_row;
+    if (row_buffer->epoch_accesses == DRAM_HYBRID_EPOCH)
+    {
+        row_buffer->keep_open = 2 * row_buffer->epoch_row_hits >
+                                row_buffer->epoch_accesses;
+        row_buffer->epoch_accesses = 0;
+        row_buffer->epoch_row_hits = 0;
+    }
+    return row_buffer->keep_open;
+}
+
+/*
+* Function to get the number of refreshes a rank has started by a cycle.
+* Refreshes of different ranks are staggered evenly over DRAM_REFI
+*/
+static uint64_t dram_refreshes_started(uint64_t rank, uint64_t cycle)
+{
+    uint64_t first = (rank + 1) * DRAM_REFI / NUM_RANKS;
+    if (cycle < first)
+    {
+        return 0;
+    }
+    return (cycle - first) / DRAM_REFI + 1;
+}
+
+/*
+* Function to get how long an access arriving at a rank at the given cycle
+* waits for a refresh in progress to finish
+*/
+static uint64_t dram_refresh_wait(uint64_t rank, uint64_t cycle)
+{
+    uint64_t first = (rank + 1) * DRAM_REFI / NUM_RANKS;
+    if (cycle < first)
+    {
+        return 0;
+    }
+    uint64_t since_refresh = (cycle - first) % DRAM_REFI;
+    return since_refresh < DELAY_RFC ? DELAY_RFC - since_refresh : 0;
+}
+
+/*
+* Function to delay an activation of a rank, ready at the given cycle, until
+* tRRD after the previous activation and tFAW after the fourth previous one,
+* and record it
+ * @return the number of cycles the activation was delayed
+*/
+static uint64_t dram_activate(DRAMRank *rank, uint64_t ready_cycle)
+{
+    uint64_t act_cycle = ready_cycle;
+    if (rank->num_acts > 0)
+    {
+        act_cycle = std::max(act_cycle,
+                             rank->act_cycles[rank->num_acts - 1] + DELAY_RRD);
+    }
+    if (rank->num_acts == 4)
+    {
+        act_cycle = std::max(act_cycle, rank->act_cycles[0] + DELAY_FAW);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            rank->act_cycles[i] = rank->act_cycles[i + 1];
+        }
+        rank->num_acts--;
+    }
+    rank->act_cycles[rank->num_acts++] = act_cycle;
+    return act_cycle - ready_cycle;
+}
+
 /**
  * Access the DRAM at the given cache line address.
  * 
@@ -121,11 +374,22 @@ DRAM *dram_new()
  * @param line_addr The address of the cache line to access (in units of the
  *                  cache line size).
  * @param is_dram_write Whether this access writes to DRAM.
+ * @param core_id The CPU core the access is made for: the requesting core for
+ *                reads and the core owning the evicted line for writes.
+ * @param upstream_delay The cycles the access spent in the caches above since
+ *                       the current cycle, so that it reaches DRAM at
+ *                       current_cycle + upstream_delay.
  * @return The delay in cycles incurred by this DRAM access.
  */
-uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write)
+uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write,
+                     unsigned int core_id, uint64_t upstream_delay)
 {
-    uint64_t delay = 0;
+    // A core over its bandwidth cap waits for a token before being served;
+    // the tokens are handed out in the order the cores issue their accesses
+    DRAMCore *dram_core = &dram->cores[core_id];
+    uint64_t delay = dram_throttle(dram_core, DRAM_CORE_BW_CAP[core_id]);
+    dram_core->throttle_delay += delay;
+
     if (SIM_MODE == SIM_MODE_B)
     {
         // TODO: Update the appropriate DRAM statistics.
@@ -140,11 +404,23 @@ uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write)
             dram->stat_read_delay += 100;
         }
         delay += 100;
+
+        // The fixed latency has no row buffer, so count every access as an
+        // activate, a column access and a precharge for the energy model
+        uint64_t bank = get_row_bank_bits(dram, dram_row_addr(line_addr)).second;
+        dram->stat_row_empty++;
+        dram->bank_stats[bank].row_empty++;
+        dram->bank_stats[bank].activates++;
+        dram->bank_stats[bank].precharges++;
+        dram_count_column_access(dram, bank, is_dram_write);
     }
     // TODO: Call the dram_access_mode_CDEF() function as needed.
     else
     {
-        uint64_t current_delay = dram_access_mode_CDEF(dram, line_addr, is_dram_write);
+        uint64_t current_delay = dram_access_mode_CDEF(dram, line_addr,
+                                                       is_dram_write,
+                                                       current_cycle +
+                                                       upstream_delay + delay);
         if (is_dram_write)
         {
             dram->stat_write_access++;
@@ -157,6 +433,16 @@ uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write)
         }
         delay += current_delay;
     }
+
+    if (is_dram_write)
+    {
+        dram_core->writes++;
+    }
+    else
+    {
+        dram_core->reads++;
+        dram_core->read_delay += delay;
+    }
     // TODO: Return the delay in cycles incurred by this DRAM access.
     return delay;
 }
@@ -176,24 +462,62 @@ uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write)
  * @param line_addr The address of the cache line to access (in units of the
  *                  cache line size).
  * @param is_dram_write Whether this access writes to DRAM.
+ * @param arrival_cycle The cycle the access reaches the DRAM.
  * @return The delay in cycles incurred by this DRAM access.
  */
 uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
-                               bool is_dram_write)
+                               bool is_dram_write, uint64_t arrival_cycle)
 {
     uint64_t delay = 0;
     // Assume a mapping with consecutive lines in the same row and consecutive
     // row buffers in consecutive rows.
-    
-    // Convert the line address to complete address
-    // Get the bits for block offset and shift address by that amount
-    line_addr = line_addr << (int)log2(CACHE_LINESIZE);
-    // To remove the column and byte in bus bits
-    line_addr = line_addr >> (int)log2(ROW_BUFFER_SIZE);
-
-    std::pair<uint64_t, uint64_t> rowBankPair = get_row_bank_bits(dram, line_addr);
+    std::pair<uint64_t, uint64_t> rowBankPair =
+        get_row_bank_bits(dram, dram_row_addr(line_addr));
     uint64_t row = rowBankPair.first;
     uint64_t bank = rowBankPair.second;
+    uint64_t rank = bank / (NUM_BANKS / NUM_RANKS);
+    RowBuffer *row_buffer = &dram->row_buffer_array[bank];
+    DRAMBankStats *bank_stats = &dram->bank_stats[bank];
+
+    // With DRAM timing, an access during a refresh waits for it to end, and a
+    // refresh precharges every bank of the rank, closing any open row
+    if (DRAM_TIMING)
+    {
+        uint64_t refresh_delay = dram_refresh_wait(rank, arrival_cycle);
+        dram->stat_refresh_delay += refresh_delay;
+        delay += refresh_delay;
+        arrival_cycle += refresh_delay;
+
+        if (dram_refreshes_started(rank, arrival_cycle) >
+            dram_refreshes_started(rank, row_buffer->last_access_cycle))
+        {
+            row_buffer->valid = false;
+            row_buffer->closed_early = false;
+        }
+    }
+
+    // With the timeout policy, a row left idle for too long has been
+    // precharged in the background. Accesses do not arrive in order (a
+    // writeback leaves after its fill), so one arriving before the last
+    // access to the bank found the row busy, not idle.
+    if (DRAM_PAGE_POLICY == TIMEOUT_PAGE && row_buffer->valid &&
+        arrival_cycle > row_buffer->last_access_cycle + DRAM_ROW_TIMEOUT)
+    {
+        dram_close_row(dram, bank);
+    }
+    row_buffer->last_access_cycle =
+        std::max(row_buffer->last_access_cycle, arrival_cycle);
+
+    // Whether this access goes to the same row as the last one to the bank,
+    // i.e., whether leaving the row open would have paid off
+    bool same_row = row_buffer->row_id == row;
+    if (!row_buffer->valid && row_buffer->closed_early && same_row)
+    {
+        dram->stat_premature_closes++;
+    }
+
+    bool needs_activate = true;
+    uint64_t precharge_delay = 0;
 
     // Check the access latency
     if (DRAM_PAGE_POLICY == CLOSE_PAGE)
@@ -204,47 +528,85 @@ uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
 
         // Not adding the data transaction of updating row buffer,
         // as it is done each time anyways
+        dram->stat_row_empty++;
+        bank_stats->row_empty++;
+        bank_stats->precharges++;
     }
     else
     {
-        // OPEN PAGE
+        // OPEN PAGE, also used by the adaptive policies, which close rows
+        // early below
         // Check row buffer
-        if (dram->row_buffer_array[bank].valid == false)
+        if (row_buffer->valid == false)
         {
             // row buffer empty
             delay += DELAY_ACT;
             delay += DELAY_CAS;
             delay += DELAY_BUS;
+            dram->stat_row_empty++;
+            bank_stats->row_empty++;
 
             // Update row buffer
-            dram->row_buffer_array[bank].row_id = row;
-            dram->row_buffer_array[bank].valid = true;
+            row_buffer->row_id = row;
+            row_buffer->valid = true;
+            row_buffer->closed_early = false;
         }
         else
         {
             // row buffer not empty
-            if (dram->row_buffer_array[bank].row_id == row)
+            if (row_buffer->row_id == row)
             {
                 // row buffer hit
                 delay += DELAY_CAS;
                 delay += DELAY_BUS;
+                dram->stat_row_hits++;
+                bank_stats->row_hits++;
+                needs_activate = false;
             }
             else
             {
                 // row buffer miss
+                dram->stat_row_conflicts++;
+                bank_stats->row_conflicts++;
                 delay += DELAY_PRE;
                 delay += DELAY_ACT;
                 delay += DELAY_CAS;
                 delay += DELAY_BUS;
+                bank_stats->precharges++;
+                precharge_delay = DELAY_PRE;
 
                 // Update row buffer
-                dram->row_buffer_array[bank].row_id = row;
-                dram->row_buffer_array[bank].valid = true;
+                row_buffer->row_id = row;
+                row_buffer->valid = true;
             }
 
         }
     }
 
+    if (needs_activate)
+    {
+        bank_stats->activates++;
+        if (DRAM_TIMING)
+        {
+            // The activation follows the precharge of a row conflict
+            uint64_t act_delay = dram_activate(&dram->ranks[rank],
+                                               arrival_cycle + precharge_delay);
+            dram->stat_act_delay += act_delay;
+            delay += act_delay;
+        }
+    }
+    dram_count_column_access(dram, bank, is_dram_write);
+
+    // The predicted and hybrid policies decide after each access whether to
+    // precharge the row right away
+    if (DRAM_PAGE_POLICY == PREDICTED_PAGE || DRAM_PAGE_POLICY == HYBRID_PAGE)
+    {
+        if (!dram_keep_row_open(row_buffer, same_row))
+        {
+            dram_close_row(dram, bank);
+        }
+    }
+
     // TODO: Use this function to track open rows.
     // TODO: Compute the delay based on row buffer hit/miss/empty.
 
@@ -282,6 +644,213 @@ void dram_print_stats(DRAM *dram)
     printf("DRAM_WRITE_DELAY_AVG \t\t : %10.3f\n", avg_write_delay);
 }
 
+/*
+* Function to reset the statistics of the DRAM module, starting the bandwidth
+* and energy accounting from the current cycle
+ * @param dram The DRAM module to reset the statistics of.
+*/
+void dram_clear_stats(DRAM *dram)
+{
+    dram->stat_read_access = 0;
+    dram->stat_read_delay = 0;
+    dram->stat_write_access = 0;
+    dram->stat_write_delay = 0;
+    dram->stat_row_conflicts = 0;
+    dram->stat_row_hits = 0;
+    dram->stat_row_empty = 0;
+    dram->stat_refresh_delay = 0;
+    dram->stat_act_delay = 0;
+    dram->stat_early_closes = 0;
+    dram->stat_premature_closes = 0;
+    dram->stat_start_cycle = current_cycle;
+    dram->bank_stats.assign(NUM_BANKS, DRAMBankStats());
+    for (DRAMCore &dram_core : dram->cores)
+    {
+        dram_core.reads = 0;
+        dram_core.writes = 0;
+        dram_core.read_delay = 0;
+        dram_core.throttle_delay = 0;
+    }
+}
+
+/*
+* Function to print the bandwidth, row buffer locality, refresh and activation
+* stalls, and the per-command and per-bank energy of the DRAM module
+ * @param dram The DRAM module to print the statistics of.
+*/
+void dram_print_power_stats(DRAM *dram)
+{
+    uint64_t cycles = current_cycle - dram->stat_start_cycle;
+    double time_ns = (double)cycles / DRAM_CYCLES_PER_NS;
+    unsigned long long accesses = dram->stat_read_access +
+                                  dram->stat_write_access;
+
+    // Energy of each command per rank, in pJ
+    double devices = DRAM_DEVICES_PER_RANK;
+    double act_pre_energy = (DRAM_IDD0 * DRAM_TRC_NS -
+                             (DRAM_IDD3N * DRAM_TRAS_NS +
+                              DRAM_IDD2N * (DRAM_TRC_NS - DRAM_TRAS_NS))) *
+                            DRAM_VDD * devices;
+    double act_energy = act_pre_energy / 2;
+    double pre_energy = act_pre_energy / 2;
+    double read_energy = (DRAM_IDD4R - DRAM_IDD3N) * DRAM_VDD *
+                         DRAM_TBURST_NS * devices;
+    double write_energy = (DRAM_IDD4W - DRAM_IDD3N) * DRAM_VDD *
+                          DRAM_TBURST_NS * devices;
+    double refresh_energy = (DRAM_IDD5 - DRAM_IDD3N) * DRAM_VDD *
+                            ((double)DELAY_RFC / DRAM_CYCLES_PER_NS) * devices;
+
+    // Rows stay open in standby under the open-page policy only
+    double standby_current = DRAM_PAGE_POLICY == OPEN_PAGE ? DRAM_IDD3N
+                                                           : DRAM_IDD2N;
+    double background_energy = standby_current * DRAM_VDD * time_ns *
+                               devices * NUM_RANKS;
+
+    unsigned long long refreshes = 0;
+    for (uint64_t rank = 0; rank < NUM_RANKS; ++rank)
+    {
+        refreshes += dram_refreshes_started(rank, current_cycle) -
+                     dram_refreshes_started(rank, dram->stat_start_cycle);
+    }
+
+    DRAMBankStats total = DRAMBankStats();
+    for (const DRAMBankStats &bank : dram->bank_stats)
+    {
+        total.activates += bank.activates;
+        total.precharges += bank.precharges;
+        total.reads += bank.reads;
+        total.writes += bank.writes;
+    }
+
+    double total_energy = total.activates * act_energy +
+                          total.precharges * pre_energy +
+                          total.reads * read_energy +
+                          total.writes * write_energy +
+                          refreshes * refresh_energy + background_energy;
+
+    double bandwidth = 0.0;
+    double power = 0.0;
+    if (cycles)
+    {
+        // Bytes per ns are GB/s, pJ per ns are mW
+        bandwidth = (double)accesses * CACHE_LINESIZE / time_ns;
+        power = total_energy / time_ns;
+    }
+    double row_hit_perc = 0.0;
+    double energy_per_access = 0.0;
+    if (accesses)
+    {
+        row_hit_perc = 100.0 * dram->stat_row_hits / accesses;
+        energy_per_access = total_energy / 1000.0 / accesses;
+    }
+
+    printf("\n");
+    printf("DRAM_BANDWIDTH_GBPS  \t\t : %10.3f\n", bandwidth);
+    printf("DRAM_ROW_HITS        \t\t : %10llu\n", dram->stat_row_hits);
+    printf("DRAM_ROW_EMPTY       \t\t : %10llu\n", dram->stat_row_empty);
+    printf("DRAM_ROW_CONFLICTS   \t\t : %10llu\n",
+           dram->stat_row_conflicts);
+    printf("DRAM_ROW_HIT_PERC    \t\t : %10.3f\n", row_hit_perc);
+    printf("DRAM_REFRESHES       \t\t : %10llu\n", refreshes);
+    printf("DRAM_REFRESH_DELAY   \t\t : %10llu\n",
+           (unsigned long long)dram->stat_refresh_delay);
+    printf("DRAM_ACT_LIMIT_DELAY \t\t : %10llu\n",
+           (unsigned long long)dram->stat_act_delay);
+    printf("DRAM_ENERGY_ACT_NJ   \t\t : %10.3f\n",
+           total.activates * act_energy / 1000.0);
+    printf("DRAM_ENERGY_PRE_NJ   \t\t : %10.3f\n",
+           total.precharges * pre_energy / 1000.0);
+    printf("DRAM_ENERGY_RD_NJ    \t\t : %10.3f\n",
+           total.reads * read_energy / 1000.0);
+    printf("DRAM_ENERGY_WR_NJ    \t\t : %10.3f\n",
+           total.writes * write_energy / 1000.0);
+    printf("DRAM_ENERGY_REF_NJ   \t\t : %10.3f\n",
+           refreshes * refresh_energy / 1000.0);
+    printf("DRAM_ENERGY_BG_NJ    \t\t : %10.3f\n",
+           background_energy / 1000.0);
+    printf("DRAM_ENERGY_TOTAL_NJ \t\t : %10.3f\n", total_energy / 1000.0);
+    printf("DRAM_ENERGY_PER_ACCESS_NJ \t : %10.3f\n", energy_per_access);
+    printf("DRAM_AVG_POWER_MW    \t\t : %10.3f\n", power);
+
+    // Refresh and background energy are shared evenly by the banks of a rank
+    double bank_share = (refreshes * refresh_energy + background_energy) /
+                        NUM_BANKS;
+    for (unsigned int i = 0; i < dram->bank_stats.size(); ++i)
+    {
+        const DRAMBankStats &bank = dram->bank_stats[i];
+        double bank_energy = bank.activates * act_energy +
+                             bank.precharges * pre_energy +
+                             bank.reads * read_energy +
+                             bank.writes * write_energy + bank_share;
+        printf("DRAM_BANK_%02u_ENERGY_NJ \t : %10.3f  (ACT %llu, RD %llu, "
+               "WR %llu)\n", i, bank_energy / 1000.0, bank.activates,
+               bank.reads, bank.writes);
+    }
+}
+
+/*
+* Function to print the row buffer hits, empty accesses and conflicts of each
+* bank, and how often the page policy closed rows early
+ * @param dram The DRAM module to print the statistics of.
+*/
+void dram_print_bank_stats(DRAM *dram)
+{
+    printf("\n");
+    printf("DRAM_EARLY_CLOSES    \t\t : %10llu\n", dram->stat_early_closes);
+    printf("DRAM_PREMATURE_CLOSES \t\t : %10llu\n",
+           dram->stat_premature_closes);
+    for (unsigned int i = 0; i < dram->bank_stats.size(); ++i)
+    {
+        const DRAMBankStats &bank = dram->bank_stats[i];
+        unsigned long long accesses = bank.row_hits + bank.row_empty +
+                                      bank.row_conflicts;
+        double row_hit_perc = 0.0;
+        if (accesses)
+        {
+            row_hit_perc = 100.0 * bank.row_hits / accesses;
+        }
+        printf("DRAM_BANK_%02u_ROW_HIT_PERC \t : %10.3f  (HIT %llu, EMPTY "
+               "%llu, CONFLICT %llu)\n", i, row_hit_perc, bank.row_hits,
+               bank.row_empty, bank.row_conflicts);
+    }
+}
+
+/*
+* Function to print the DRAM reads, writes, average read delay and bandwidth
+* throttling of each core
+ * @param dram The DRAM module to print the statistics of.
+ * @param num_cores The number of cores simulated.
+*/
+void dram_print_core_stats(DRAM *dram, unsigned int num_cores)
+{
+    uint64_t cycles = current_cycle - dram->stat_start_cycle;
+    printf("\n");
+    for (unsigned int i = 0; i < num_cores; ++i)
+    {
+        const DRAMCore &dram_core = dram->cores[i];
+        double avg_read_delay = 0.0;
+        double bandwidth = 0.0;
+        if (dram_core.reads)
+        {
+            avg_read_delay = (double)dram_core.read_delay / dram_core.reads;
+        }
+        if (cycles)
+        {
+            bandwidth = (double)(dram_core.reads + dram_core.writes) *
+                        CACHE_LINESIZE * DRAM_CYCLES_PER_NS / cycles;
+        }
+        printf("DRAM_CORE_%01u_READ_ACCESS \t : %10llu\n", i,
+               dram_core.reads);
+        printf("DRAM_CORE_%01u_WRITE_ACCESS \t : %10llu\n", i,
+               dram_core.writes);
+        printf("DRAM_CORE_%01u_READ_DELAY_AVG \t : %10.3f\n", i,
+               avg_read_delay);
+        printf("DRAM_CORE_%01u_BANDWIDTH_GBPS \t : %10.3f\n", i, bandwidth);
+        printf("DRAM_CORE_%01u_THROTTLE_DELAY \t : %10llu\n", i,
+               (unsigned long long)dram_core.throttle_delay);
+    }
+}
+
 /*
 * Function to get bank and row id bits
  * @param dram The dram to access.
@@ -298,3 +867,20 @@ std::pair<uint64_t, uint64_t> get_row_bank_bits(DRAM* dram, uint64_t line_addr)
     row = line_addr >> dram->num_bank_bits;
     return std::make_pair(row, bank);
 }
+
+/*
+* Function to get the number of page colors that map to disjoint DRAM banks,
+* i.e., how many consecutive pages it takes to touch every bank once
+ * @param page_size The page size in bytes.
+ * @return number of bank colors (at least 1)
+*/
+unsigned int dram_get_page_colors(uint64_t page_size)
+{
+    // Consecutive row buffer sized chunks map to consecutive banks
+    uint64_t colors = ((uint64_t)NUM_BANKS * ROW_BUFFER_SIZE) / page_size;
+    if (colors < 1)
+    {
+        colors = 1;
+    }
+    return colors;
+}
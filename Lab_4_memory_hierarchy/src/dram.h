@@ -37,8 +37,93 @@ typedef struct RowBuffer
     */
     uint64_t row_id;
 
+    /*
+    * Latest arrival cycle of an access to the bank, to find out whether a
+    * refresh has closed the row since
+    */
+    uint64_t last_access_cycle;
+
+    /*
+    * Whether the row was closed by the page policy before the next access
+    * rather than by a conflicting access (row_id still holds the old row)
+    */
+    bool closed_early;
+
+    /*
+    * Saturating 2-bit counter predicting whether the next access to the bank
+    * hits the same row (predicted page policy)
+    */
+    unsigned int hit_counter;
+
+    /*
+    * Whether the bank currently leaves rows open (hybrid page policy)
+    */
+    bool keep_open;
+
+    /*
+    * Accesses and same-row accesses in the current epoch (hybrid page policy)
+    */
+    unsigned int epoch_accesses;
+    unsigned int epoch_row_hits;
+
 } RowBuffer;
 
+/*
+* Per-bank counts of DRAM commands, used for the energy model
+*/
+typedef struct DRAMBankStats
+{
+    unsigned long long activates;
+    unsigned long long precharges;
+    unsigned long long reads;
+    unsigned long long writes;
+    unsigned long long row_hits;
+    unsigned long long row_empty;
+    unsigned long long row_conflicts;
+} DRAMBankStats;
+
+/*
+* Per-core request accounting and bandwidth throttling at the DRAM interface
+*/
+typedef struct DRAMCore
+{
+    unsigned long long reads;
+    unsigned long long writes;
+
+    /*
+    * Cycles the core's reads spent at the DRAM, including throttling
+    */
+    uint64_t read_delay;
+
+    /*
+    * Cycles the core's accesses waited for a bandwidth token
+    */
+    uint64_t throttle_delay;
+
+    /*
+    * Token bucket of the bandwidth cap: the tokens available at bucket_cycle,
+    * one per cache line transferred
+    */
+    double tokens;
+    uint64_t bucket_cycle;
+} DRAMCore;
+
+/*
+* Per-rank activation history, used to enforce tRRD and tFAW
+*/
+typedef struct DRAMRank
+{
+    /*
+    * Cycles of the last four activations, oldest first
+    */
+    uint64_t act_cycles[4];
+
+    /*
+    * Number of activations recorded so far, capped at the history size
+    */
+    unsigned int num_acts;
+} DRAMRank;
+
 /** A DRAM module. */
 typedef struct DRAM
 {
@@ -85,13 +170,76 @@ typedef struct DRAM
      * You should initialize this to 0 and update it for every DRAM write!
      */
     uint64_t stat_write_delay;
+
+    /*
+    * The total number of accesses that found a different row open in the
+    * row buffer (open-page policy only)
+    */
+    unsigned long long stat_row_conflicts;
+
+    /*
+    * Per-rank activation history (used with DRAM_TIMING only)
+    */
+    std::vector<DRAMRank> ranks;
+
+    /*
+    * Per-core request accounting and bandwidth caps
+    */
+    std::vector<DRAMCore> cores;
+
+    /*
+    * Per-bank command counts for the energy model
+    */
+    std::vector<DRAMBankStats> bank_stats;
+
+    /*
+    * The total number of accesses that found their row open in the row buffer
+    */
+    unsigned long long stat_row_hits;
+
+    /*
+    * The total number of accesses that found the row buffer closed
+    */
+    unsigned long long stat_row_empty;
+
+    /*
+    * The total number of cycles accesses waited for a refresh to finish
+    */
+    uint64_t stat_refresh_delay;
+
+    /*
+    * The total number of cycles activations waited for tRRD and tFAW
+    */
+    uint64_t stat_act_delay;
+
+    /*
+    * The total number of rows closed by the page policy before a conflicting
+    * access (timeout, predicted and hybrid page policies)
+    */
+    unsigned long long stat_early_closes;
+
+    /*
+    * The total number of accesses whose row had been closed early although
+    * they would have hit it
+    */
+    unsigned long long stat_premature_closes;
+
+    /*
+    * The cycle at which the statistics were last cleared, to compute the
+    * bandwidth and the refresh and background energy
+    */
+    uint64_t stat_start_cycle;
 } DRAM;
 
 /** Possible page policies for DRAM. */
 typedef enum DRAMPolicyEnum
 {
-    OPEN_PAGE = 0,  // The DRAM uses an open-page policy.
-    CLOSE_PAGE = 1, // The DRAM uses a close-page policy.
+    OPEN_PAGE = 0,      // The DRAM uses an open-page policy.
+    CLOSE_PAGE = 1,     // The DRAM uses a close-page policy.
+    TIMEOUT_PAGE = 2,   // Rows close after DRAM_ROW_TIMEOUT idle cycles.
+    PREDICTED_PAGE = 3, // A per-bank row-hit predictor closes rows early.
+    HYBRID_PAGE = 4,    // Each bank switches between open and close page by
+                        // the row locality of its last epoch of accesses.
 } DRAMPolicy;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -133,9 +281,15 @@ DRAM *dram_new();
  * @param line_addr The address of the cache line to access (in units of the
  *                  cache line size).
  * @param is_dram_write Whether this access writes to DRAM.
+ * @param core_id The CPU core the access is made for: the requesting core for
+ *                reads and the core owning the evicted line for writes.
+ * @param upstream_delay The cycles the access spent in the caches above since
+ *                       the current cycle, so that it reaches DRAM at
+ *                       current_cycle + upstream_delay.
  * @return The delay in cycles incurred by this DRAM access.
  */
-uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write);
+uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write,
+                     unsigned int core_id, uint64_t upstream_delay);
 
 /**
  * For parts C through F, access the DRAM at the given cache line address.
@@ -152,10 +306,11 @@ uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write);
  * @param line_addr The address of the cache line to access (in units of the
  *                  cache line size).
  * @param is_dram_write Whether this access writes to DRAM.
+ * @param arrival_cycle The cycle the access reaches the DRAM.
  * @return The delay in cycles incurred by this DRAM access.
  */
 uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
-                               bool is_dram_write);
+                               bool is_dram_write, uint64_t arrival_cycle);
 
 /**
  * Print the statistics of the DRAM module.
@@ -166,6 +321,43 @@ uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
  */
 void dram_print_stats(DRAM *dram);
 
+/*
+* Function to reset the statistics of the DRAM module, starting the bandwidth
+* and energy accounting from the current cycle
+ * @param dram The DRAM module to reset the statistics of.
+*/
+void dram_clear_stats(DRAM *dram);
+
+/*
+* Function to print the bandwidth, row buffer locality, refresh and activation
+* stalls, and the per-command and per-bank energy of the DRAM module
+ * @param dram The DRAM module to print the statistics of.
+*/
+void dram_print_power_stats(DRAM *dram);
+
+/*
+* Function to print the row buffer hits, empty accesses and conflicts of each
+* bank, and how often the page policy closed rows early
+ * @param dram The DRAM module to print the statistics of.
+*/
+void dram_print_bank_stats(DRAM *dram);
+
+/*
+* Function to print the DRAM reads, writes, average read delay and bandwidth
+* throttling of each core
+ * @param dram The DRAM module to print the statistics of.
+ * @param num_cores The number of cores simulated.
+*/
+void dram_print_core_stats(DRAM *dram, unsigned int num_cores);
+
+/*
+* Function to get the number of page colors that map to disjoint DRAM banks,
+* i.e., how many consecutive pages it takes to touch every bank once
+ * @param page_size The page size in bytes.
+ * @return number of bank colors (at least 1)
+*/
+unsigned int dram_get_page_colors(uint64_t page_size);
+
 /*
 * Function to get bank and row id bits
  * @param dram The dram to access.
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <math.h>
+#include <algorithm>
 // You may add any other #include directives you need here, but make sure they
 // compile on the reference machine!
 
@@ -26,17 +27,35 @@
 //                                 CONSTANTS                                 //
 ///////////////////////////////////////////////////////////////////////////////
 
-/** The number of bytes in a page. */
-#define PAGE_SIZE 4096
-
 /** The hit time of the data cache in cycles. */
 #define DCACHE_HIT_LATENCY 1
 
 /** The hit time of the instruction cache in cycles. */
 #define ICACHE_HIT_LATENCY 1
 
-/** The hit time of the L2 cache in cycles. */
-#define L2CACHE_HIT_LATENCY 10
+/**
+ * The hit time of the L2 TLB in cycles. (L1 TLB hits are overlapped with the
+ * L1 cache access and incur no extra delay.)
+ */
+#define L2TLB_HIT_LATENCY 7
+
+/** The number of bytes in a huge page. */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/** The number of levels in the radix page table for 4 KB pages. */
+#define PAGE_TABLE_LEVELS 4
+
+/** The number of virtual page number bits resolved by each page table level. */
+#define PAGE_TABLE_LEVEL_BITS 9
+
+/** The number of bytes in a page table entry. */
+#define PAGE_TABLE_ENTRY_SIZE 8
+
+/**
+ * The physical address at which the page tables are placed, well above any
+ * frame returned by memsys_convert_vpn_to_pfn().
+ */
+#define PAGE_TABLE_BASE (1ULL << 40)
 
 ///////////////////////////////////////////////////////////////////////////////
 //                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
@@ -75,9 +94,96 @@ extern uint64_t L2CACHE_ASSOC;
 /** The replacement policy to use for the L2 cache. */
 extern ReplacementPolicy L2CACHE_REPL;
 
+/** The hit time of the L2 cache in cycles. */
+extern uint64_t L2CACHE_LATENCY;
+
+/** Whether each core has a private L2 cache in parts D, E, and F. */
+extern bool L2_PRIVATE;
+
+/** The size of the shared L3 cache in bytes, or 0 for no L3 cache. */
+extern uint64_t L3CACHE_SIZE;
+
+/** The associativity of the L3 cache. */
+extern uint64_t L3CACHE_ASSOC;
+
+/** The replacement policy to use for the L3 cache. */
+extern ReplacementPolicy L3CACHE_REPL;
+
+/** The hit time of the L3 cache in cycles, from the nearest bank. */
+extern uint64_t L3CACHE_LATENCY;
+
+/** The number of NUCA banks of the L3 cache. */
+extern unsigned int L3_NUM_BANKS;
+
+/** The extra cycles per bank crossed to reach an L3 bank. */
+extern uint64_t L3_BANK_HOP_LATENCY;
+
+/**
+ * One in this many L2 sets is simulated, and the L2 miss rates are
+ * extrapolated from them. 1 simulates every set.
+ */
+extern unsigned int L2_SAMPLE_RATIO;
+
+/** Whether the L2 cache is compressed. */
+extern bool L2_COMPRESSION;
+
+/**
+ * The file giving the compressed size of specific lines, or NULL to size every
+ * line with the synthetic model.
+ */
+extern const char *L2_COMPRESS_SIZES_FILE;
+
 /** The number of cores being simulated. */
 extern unsigned int NUM_CORES;
 
+/** Which page policy the DRAM should use. */
+extern DRAMPolicy DRAM_PAGE_POLICY;
+
+/** Whether to print the DRAM bandwidth, locality and energy statistics. */
+extern bool DRAM_POWER_STATS;
+
+/** The DRAM bandwidth cap of each core in GB/s, or 0 if uncapped. */
+extern double DRAM_CORE_BW_CAP[2];
+
+/** Whether address translation is simulated with TLBs in parts D, E, and F. */
+extern bool ENABLE_TLB;
+
+/** Whether the TLBs and page tables use 2 MB huge pages. */
+extern bool ENABLE_HUGE_PAGES;
+
+/** The number of entries in each L1 instruction and data TLB. */
+extern uint64_t L1TLB_ENTRIES;
+
+/** The associativity of the L1 instruction and data TLBs. */
+extern uint64_t L1TLB_ASSOC;
+
+/** The number of entries in the shared L2 TLB. */
+extern uint64_t L2TLB_ENTRIES;
+
+/** The associativity of the shared L2 TLB. */
+extern uint64_t L2TLB_ASSOC;
+
+/**
+ * The number of instruction addresses and pages tracked by the hot-spot
+ * profiler, or 0 if profiling is disabled.
+ */
+extern unsigned int PROFILE_TOPK;
+
+/** The number of rows printed per hot-spot profiler table. */
+extern unsigned int PROFILE_REPORT_ROWS;
+
+/** How physical frames are allocated to virtual pages in parts D, E, and F. */
+extern PageAllocPolicy PAGE_ALLOC_POLICY;
+
+/** The size of physical memory in bytes, used by the page allocator. */
+extern uint64_t PHYS_MEM_SIZE;
+
+/**
+ * For the page coloring policies, the number of colors given to core 0, or 0
+ * to split the colors evenly between the cores.
+ */
+extern unsigned int COLOR_CORE0_COLORS;
+
 /**
  * The current clock cycle number.
  * 
@@ -89,6 +195,40 @@ extern uint64_t current_cycle;
 //                           FUNCTION DEFINITIONS                            //
 ///////////////////////////////////////////////////////////////////////////////
 
+/*
+* Function to add a cache level below the existing ones, with a cache per core
+* if it is private or else one shared cache
+*/
+static void memsys_add_level(MemorySystem *sys, const char *name,
+                             uint64_t size, uint64_t assoc,
+                             ReplacementPolicy repl, uint64_t latency,
+                             bool is_private, unsigned int num_banks,
+                             uint64_t bank_hop_latency)
+{
+    assert(sys->num_levels < MEMSYS_MAX_LEVELS);
+    CacheLevel *level = &sys->levels[sys->num_levels++];
+    level->name = name;
+    level->is_private = is_private;
+    level->caches[0] = cache_new(size, assoc, CACHE_LINESIZE, repl);
+    level->caches[1] = NULL;
+    if (is_private)
+    {
+        level->caches[1] = cache_new(size, assoc, CACHE_LINESIZE, repl);
+    }
+    level->hit_latency = latency;
+    level->num_banks = num_banks;
+    level->bank_hop_latency = bank_hop_latency;
+    level->stat_bank_delay = 0;
+}
+
+/*
+* Function to get the cache of a level that serves the given core
+*/
+static Cache *memsys_level_cache(CacheLevel *level, unsigned int core_id)
+{
+    return level->is_private ? level->caches[core_id] : level->caches[0];
+}
+
 /**
  * Allocate and initialize the memory system.
  * 
@@ -112,15 +252,15 @@ MemorySystem *memsys_new()
                                 REPL_POLICY);
         sys->icache = cache_new(ICACHE_SIZE, ICACHE_ASSOC, CACHE_LINESIZE,
                                 REPL_POLICY);
-        sys->l2cache = cache_new(L2CACHE_SIZE, L2CACHE_ASSOC, CACHE_LINESIZE,
-                                 REPL_POLICY);
+        memsys_add_level(sys, "L2CACHE", L2CACHE_SIZE, L2CACHE_ASSOC,
+                         REPL_POLICY, L2CACHE_LATENCY, false, 1, 0);
         sys->dram = dram_new();
     }
 
     if (SIM_MODE == SIM_MODE_DEF)
     {
-        sys->l2cache = cache_new(L2CACHE_SIZE, L2CACHE_ASSOC, CACHE_LINESIZE,
-                                 L2CACHE_REPL);
+        memsys_add_level(sys, "L2CACHE", L2CACHE_SIZE, L2CACHE_ASSOC,
+                         L2CACHE_REPL, L2CACHE_LATENCY, L2_PRIVATE, 1, 0);
         sys->dram = dram_new();
         for (unsigned int i = 0; i < NUM_CORES; i++)
         {
@@ -129,6 +269,69 @@ MemorySystem *memsys_new()
             sys->icache_coreid[i] = cache_new(ICACHE_SIZE, ICACHE_ASSOC,
                                               CACHE_LINESIZE, REPL_POLICY);
         }
+
+        if (PAGE_ALLOC_POLICY != PAGE_ALLOC_FIXED)
+        {
+            unsigned int num_colors = memsys_page_colors();
+
+            // Huge pages are backed by naturally aligned 2 MB blocks
+            unsigned int alloc_order = 0;
+            if (ENABLE_TLB && ENABLE_HUGE_PAGES)
+            {
+                alloc_order = (int)log2(HUGE_PAGE_SIZE / PAGE_SIZE);
+            }
+
+            sys->page_alloc = page_alloc_new(PAGE_ALLOC_POLICY,
+                                             PHYS_MEM_SIZE / PAGE_SIZE,
+                                             num_colors, COLOR_CORE0_COLORS,
+                                             alloc_order);
+        }
+
+        if (ENABLE_TLB)
+        {
+            sys->l2tlb = tlb_new(L2TLB_ENTRIES, L2TLB_ASSOC);
+            for (unsigned int i = 0; i < NUM_CORES; i++)
+            {
+                sys->itlb_coreid[i] = tlb_new(L1TLB_ENTRIES, L1TLB_ASSOC);
+                sys->dtlb_coreid[i] = tlb_new(L1TLB_ENTRIES, L1TLB_ASSOC);
+            }
+        }
+    }
+
+    if (sys->num_levels && L3CACHE_SIZE)
+    {
+        memsys_add_level(sys, "L3CACHE", L3CACHE_SIZE, L3CACHE_ASSOC,
+                         L3CACHE_REPL, L3CACHE_LATENCY, false, L3_NUM_BANKS,
+                         L3_BANK_HOP_LATENCY);
+    }
+    if (sys->num_levels && !sys->levels[0].is_private)
+    {
+        sys->l2cache = sys->levels[0].caches[0];
+    }
+
+    if (sys->l2cache && L2_COMPRESSION)
+    {
+        Compressor *comp = compressor_new(CACHE_LINESIZE,
+                                          L2_COMPRESS_SIZES_FILE);
+        if (comp == NULL)
+        {
+            exit(1);
+        }
+        sys->l2shadow = cache_new(L2CACHE_SIZE, L2CACHE_ASSOC, CACHE_LINESIZE,
+                                  sys->l2cache->replacement_policy);
+        cache_enable_compression(sys->l2cache, comp);
+    }
+
+    if (sys->l2cache && L2_SAMPLE_RATIO > 1)
+    {
+        sys->l2sampler = set_sampler_new(sys->l2cache->num_sets,
+                                         L2_SAMPLE_RATIO);
+    }
+
+    if (PROFILE_TOPK)
+    {
+        // Mode A does not simulate timing, so rank its hot spots by misses
+        sys->profiler = profiler_new(PROFILE_TOPK, SIM_MODE != SIM_MODE_A);
     }
 
     return sys;
@@ -157,19 +360,25 @@ uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
     // byte address to a cache line address.
     uint64_t line_addr = addr / CACHE_LINESIZE;
 
+    ProfileSample counters_before;
+    if (sys->profiler)
+    {
+        memsys_profile_counters(sys, core_id, &counters_before);
+    }
+
     if (SIM_MODE == SIM_MODE_A)
     {
-        delay = memsys_access_modeA(sys, line_addr, type, core_id);
+        delay = memsys_access_modeA(sys, line_addr, type, core_id, NULL);
     }
 
     if (SIM_MODE == SIM_MODE_B || SIM_MODE == SIM_MODE_C)
     {
-        delay = memsys_access_modeBC(sys, line_addr, type, core_id);
+        delay = memsys_access_modeBC(sys, line_addr, type, core_id, NULL);
     }
 
     if (SIM_MODE == SIM_MODE_DEF)
     {
-        delay = memsys_access_modeDEF(sys, line_addr, type, core_id);
+        delay = memsys_access_modeDEF(sys, line_addr, type, core_id, NULL);
     }
 
     // Update the statistics.
@@ -191,9 +400,332 @@ uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
         sys->stat_store_delay += delay;
     }
 
+    if (sys->profiler)
+    {
+        ProfileSample counters_after;
+        memsys_profile_counters(sys, core_id, &counters_after);
+
+        ProfileSample sample;
+        // The core only stalls on instruction fetches and loads
+        sample.stall_cycles = 0;
+        if (type != ACCESS_TYPE_STORE && delay > 1)
+        {
+            sample.stall_cycles = delay - 1;
+        }
+        sample.l1_misses = counters_after.l1_misses -
+                           counters_before.l1_misses;
+        sample.l2_misses = counters_after.l2_misses -
+                           counters_before.l2_misses;
+        sample.row_conflicts = counters_after.row_conflicts -
+                               counters_before.row_conflicts;
+        profiler_record(sys->profiler, type, sys->profile_inst_addr,
+                        addr / PAGE_SIZE, sample);
+    }
+
     return delay;
 }
 
+/**
+ * Access the given memory address only to warm up the memory system: the tag
+ * stores, replacement state, TLBs and DRAM row buffers are updated as by
+ * memsys_access(), but the delay is discarded and neither the memory system
+ * statistics nor the profiler are updated.
+ * 
+ * The caches still count the accesses, so clear the statistics with
+ * memsys_clear_stats() once the warm-up is over.
+ * 
+ * @param sys The memory system to use for the access.
+ * @param addr The address to access (in bytes).
+ * @param type The type of memory access.
+ * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL
+ *               to look the line up during the access.
+ */
+void memsys_warm_access(MemorySystem *sys, uint64_t addr, AccessType type,
+                        unsigned int core_id, const MemsysLookup *lookup)
+{
+    uint64_t line_addr = addr / CACHE_LINESIZE;
+    if (lookup && !lookup->valid)
+    {
+        lookup = NULL;
+    }
+
+    if (SIM_MODE == SIM_MODE_A)
+    {
+        memsys_access_modeA(sys, line_addr, type, core_id, lookup);
+    }
+
+    if (SIM_MODE == SIM_MODE_B || SIM_MODE == SIM_MODE_C)
+    {
+        memsys_access_modeBC(sys, line_addr, type, core_id, lookup);
+    }
+
+    if (SIM_MODE == SIM_MODE_DEF)
+    {
+        memsys_access_modeDEF(sys, line_addr, type, core_id, lookup);
+    }
+}
+
+/*
+* Function to get the physical cache line an access to the given address will
+* go to, without changing the state of the memory system
+* Returns false if that is not known yet because the page is not mapped
+*/
+static bool memsys_peek_line(MemorySystem *sys, uint64_t addr,
+                             unsigned int core_id, uint64_t *line_addr)
+{
+    if (SIM_MODE != SIM_MODE_DEF)
+    {
+        *line_addr = addr / CACHE_LINESIZE;
+        return true;
+    }
+
+    // The fixed mapping is a pure function of the VPN, while the page
+    // allocator maps a page on its first touch
+    uint64_t vpn = addr / PAGE_SIZE;
+    uint64_t pfn = 0;
+    if (PAGE_ALLOC_POLICY == PAGE_ALLOC_FIXED)
+    {
+        pfn = memsys_convert_vpn_to_pfn(sys, vpn, core_id);
+    }
+    else if (!page_alloc_lookup(sys->page_alloc, vpn, core_id, &pfn))
+    {
+        return false;
+    }
+    *line_addr = (pfn * PAGE_SIZE + addr % PAGE_SIZE) / CACHE_LINESIZE;
+    return true;
+}
+
+/**
+ * Look up a block of upcoming memory accesses of a core in its L1 and L2
+ * caches at once, and prefetch the cache sets they map to into the host
+ * caches, so that making the accesses afterwards with memsys_warm_access()
+ * neither splits the addresses again nor stalls on host memory when the
+ * simulated caches are large. The state of the memory system is not changed.
+ * 
+ * In mode D, E, or F each address is first translated through the page
+ * table, without touching the TLBs; an access to a page that is not mapped
+ * yet is left invalid and looked up when it is made.
+ * 
+ * Only the functional warm-up reads the trace far enough ahead to use this.
+ * 
+ * @param sys The memory system the accesses will be made to.
+ * @param addrs The addresses that will be accessed (in bytes).
+ * @param types The type of each memory access.
+ * @param count The number of accesses.
+ * @param core_id The CPU core ID that will make the accesses.
+ * @param lookups Set to the lookups of each access.
+ */
+void memsys_lookup_batch(MemorySystem *sys, const uint64_t *addrs,
+                         const AccessType *types, size_t count,
+                         unsigned int core_id, MemsysLookup *lookups)
+{
+    Cache *l1caches[2] = {sys->icache, sys->dcache};
+    if (SIM_MODE == SIM_MODE_DEF)
+    {
+        l1caches[0] = sys->icache_coreid[core_id];
+        l1caches[1] = sys->dcache_coreid[core_id];
+    }
+    // Mode A has no instruction cache and no L2
+    Cache *l2cache = NULL;
+    if (sys->num_levels)
+    {
+        l2cache = memsys_level_cache(&sys->levels[0], core_id);
+    }
+
+    // The fetches and the loads and stores, split per L1 cache
+    uint64_t lines[2][MEMSYS_LOOKUP_BATCH];
+    size_t positions[2][MEMSYS_LOOKUP_BATCH];
+    CacheLookup found[MEMSYS_LOOKUP_BATCH];
+
+    for (size_t start = 0; start < count; start += MEMSYS_LOOKUP_BATCH)
+    {
+        size_t end = std::min(count, start + MEMSYS_LOOKUP_BATCH);
+        size_t num[2] = {0, 0};
+        for (size_t i = start; i < end; i++)
+        {
+            unsigned int l1 = types[i] == ACCESS_TYPE_IFETCH ? 0 : 1;
+            lookups[i].valid = l1caches[l1] != NULL &&
+                               memsys_peek_line(sys, addrs[i], core_id,
+                                                &lookups[i].line_addr);
+            if (lookups[i].valid)
+            {
+                lines[l1][num[l1]] = lookups[i].line_addr;
+                positions[l1][num[l1]++] = i;
+            }
+        }
+
+        for (unsigned int l1 = 0; l1 < 2; l1++)
+        {
+            if (num[l1] == 0)
+            {
+                continue;
+            }
+            cache_lookup_batch(l1caches[l1], lines[l1], num[l1], found);
+            for (size_t j = 0; j < num[l1]; j++)
+            {
+                lookups[positions[l1][j]].l1 = found[j];
+            }
+            if (l2cache == NULL)
+            {
+                continue;
+            }
+            cache_lookup_batch(l2cache, lines[l1], num[l1], found);
+            for (size_t j = 0; j < num[l1]; j++)
+            {
+                lookups[positions[l1][j]].l2 = found[j];
+            }
+        }
+    }
+}
+
+/*
+* Function to reset the statistics of a cache, if it exists
+*/
+static void memsys_clear_cache_stats(Cache *c)
+{
+    if (c == NULL)
+    {
+        return;
+    }
+    c->stat_read_access = 0;
+    c->stat_read_miss = 0;
+    c->stat_write_access = 0;
+    c->stat_write_miss = 0;
+    c->stat_dirty_evicts = 0;
+    c->stat_compressed_hits = 0;
+    c->stat_decompress_delay = 0;
+    c->stat_valid_line_sum = 0;
+    c->stat_installs = 0;
+}
+
+/*
+* Function to reset the statistics of a TLB, if it exists
+*/
+static void memsys_clear_tlb_stats(TLB *tlb)
+{
+    if (tlb == NULL)
+    {
+        return;
+    }
+    tlb->stat_access = 0;
+    tlb->stat_miss = 0;
+}
+
+/**
+ * Reset every statistic of the memory system, its caches, TLBs, DRAM and L2
+ * set sampler to zero, keeping their contents and replacement state. The
+ * frames held by the page allocator stay allocated.
+ * 
+ * @param sys The memory system whose statistics to clear.
+ */
+void memsys_clear_stats(MemorySystem *sys)
+{
+    memsys_clear_cache_stats(sys->dcache);
+    memsys_clear_cache_stats(sys->icache);
+    for (unsigned int i = 0; i < sys->num_levels; i++)
+    {
+        memsys_clear_cache_stats(sys->levels[i].caches[0]);
+        memsys_clear_cache_stats(sys->levels[i].caches[1]);
+        sys->levels[i].stat_bank_delay = 0;
+    }
+    memsys_clear_cache_stats(sys->l2shadow);
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        memsys_clear_cache_stats(sys->dcache_coreid[i]);
+        memsys_clear_cache_stats(sys->icache_coreid[i]);
+        memsys_clear_tlb_stats(sys->itlb_coreid[i]);
+        memsys_clear_tlb_stats(sys->dtlb_coreid[i]);
+    }
+    memsys_clear_tlb_stats(sys->l2tlb);
+
+    if (sys->dram)
+    {
+        dram_clear_stats(sys->dram);
+    }
+
+    if (sys->l2sampler)
+    {
+        for (SampledSet &set : sys->l2sampler->sampled_sets)
+        {
+            set = SampledSet();
+        }
+        sys->l2sampler->stat_filtered_read = 0;
+        sys->l2sampler->stat_filtered_write = 0;
+    }
+
+    sys->stat_page_walks = 0;
+    sys->stat_page_walk_delay = 0;
+    sys->stat_translation_delay = 0;
+    sys->stat_ifetch_access = 0;
+    sys->stat_load_access = 0;
+    sys->stat_store_access = 0;
+    sys->stat_ifetch_delay = 0;
+    sys->stat_load_delay = 0;
+    sys->stat_store_delay = 0;
+}
+
+/**
+ * Read the event counters that the profiler attributes to accesses from the
+ * given core: its L1 misses, the L2 misses and the DRAM row conflicts.
+ * 
+ * @param sys The memory system to read the counters of.
+ * @param core_id The CPU core ID whose L1 caches are read.
+ * @param counters Set to the current counter values.
+ */
+void memsys_profile_counters(MemorySystem *sys, unsigned int core_id,
+                             ProfileSample *counters)
+{
+    Cache *l1caches[2] = {sys->dcache, sys->icache};
+    if (SIM_MODE == SIM_MODE_DEF)
+    {
+        l1caches[0] = sys->dcache_coreid[core_id];
+        l1caches[1] = sys->icache_coreid[core_id];
+    }
+
+    counters->stall_cycles = 0;
+    counters->l1_misses = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        if (l1caches[i])
+        {
+            counters->l1_misses += l1caches[i]->stat_read_miss +
+                                   l1caches[i]->stat_write_miss;
+        }
+    }
+
+    counters->l2_misses = 0;
+    if (sys->num_levels)
+    {
+        Cache *l2cache = memsys_level_cache(&sys->levels[0], core_id);
+        counters->l2_misses = l2cache->stat_read_miss +
+                              l2cache->stat_write_miss;
+    }
+
+    counters->row_conflicts = 0;
+    if (sys->dram)
+    {
+        counters->row_conflicts = sys->dram->stat_row_conflicts;
+    }
+}
+
+/*
+* Function to get the set index and tag of a line in an L1 cache, reusing the
+* lookup made by memsys_lookup_batch() if there is one
+*/
+static CacheLookup memsys_l1_lookup(Cache *c, uint64_t line_addr,
+                                    const MemsysLookup *lookup)
+{
+    if (lookup)
+    {
+        return lookup->l1;
+    }
+    std::pair<uint64_t, uint64_t> indexTagPair = get_index_tag_bits(c,
+                                                                    line_addr);
+    CacheLookup l1_lookup = {indexTagPair.first, indexTagPair.second};
+    return l1_lookup;
+}
+
 /**
  * In mode A, access the given memory address from a load or store.
  * 
@@ -207,10 +739,12 @@ uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
  *                  cache line size, i.e., excluding the line offset bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL.
  * @return Always 0 in this mode.
  */
 uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
-                             AccessType type, unsigned int core_id)
+                             AccessType type, unsigned int core_id,
+                             const MemsysLookup *lookup)
 {
     bool needs_dcache_access = false;
     bool is_write = false;
@@ -235,11 +769,13 @@ uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
 
     if (needs_dcache_access)
     {
-        CacheResult outcome = cache_access(sys->dcache, line_addr, is_write,
-                                           core_id);
+        CacheLookup l1_lookup = memsys_l1_lookup(sys->dcache, line_addr,
+                                                 lookup);
+        CacheResult outcome = cache_access_lookup(sys->dcache, &l1_lookup,
+                                                  is_write, core_id);
         if (outcome == MISS)
         {
-            cache_install(sys->dcache, line_addr, is_write, core_id);
+            cache_install_lookup(sys->dcache, &l1_lookup, is_write, core_id);
         }
     }
 
@@ -262,10 +798,12 @@ uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
  *                  cache line size, i.e., excluding the line offset bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
-                              AccessType type, unsigned int core_id)
+                              AccessType type, unsigned int core_id,
+                              const MemsysLookup *lookup)
 {
     uint64_t delay = 0;
 
@@ -292,17 +830,21 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
         is_write = true;
     }
 
+    Cache *l1cache = needs_dcache_access ? sys->dcache : sys->icache;
+    CacheLookup l1_lookup = memsys_l1_lookup(l1cache, line_addr, lookup);
+    const CacheLookup *l2_lookup = lookup ? &lookup->l2 : NULL;
+
     CacheResult dcache_outcome, icache_outcome;
     if (needs_dcache_access)
     {
-        dcache_outcome = cache_access(sys->dcache, line_addr, is_write,
+        dcache_outcome = cache_access_lookup(sys->dcache, &l1_lookup, is_write,
             core_id);
         delay += DCACHE_HIT_LATENCY;
         if (dcache_outcome == HIT) return delay;
     }
     else if (needs_icache_access)
     {
-        icache_outcome = cache_access(sys->icache, line_addr, is_write,
+        icache_outcome = cache_access_lookup(sys->icache, &l1_lookup, is_write,
             core_id);
         delay += ICACHE_HIT_LATENCY;
         if (icache_outcome == HIT) return delay;
@@ -312,7 +854,8 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
     if (dcache_outcome == MISS || icache_outcome == MISS)
     {
         // read from l2
-        delay += memsys_l2_access(sys, line_addr, false, core_id);
+        delay += memsys_l2_access(sys, line_addr, false, core_id, l2_lookup,
+                                  delay);
     }
 
     bool is_last_evicted_line_dirty = false, is_last_evicted_line_valid = false;
@@ -323,9 +866,9 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
         dcache_outcome == MISS)
     {
         // install into l1 dcache
-        cache_install(sys->dcache, line_addr, is_write, core_id);
+        cache_install_lookup(sys->dcache, &l1_lookup, is_write, core_id);
         is_last_evicted_line_dirty = sys->dcache->last_evicted_line.dirty;
-        uint64_t index = get_index_tag_bits(sys->dcache, line_addr).first;
+        uint64_t index = l1_lookup.index;
         uint64_t tag = sys->dcache->last_evicted_line.tag;
         last_evicted_line_address = (tag << sys->dcache->num_index_bits) | index;
         is_last_evicted_line_valid = sys->dcache->last_evicted_line.valid;
@@ -333,9 +876,9 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
     else if (needs_icache_access == true &&
         icache_outcome == MISS)
     {
-        cache_install(sys->icache, line_addr, is_write, core_id);
+        cache_install_lookup(sys->icache, &l1_lookup, is_write, core_id);
         is_last_evicted_line_dirty = sys->icache->last_evicted_line.dirty;
-        uint64_t index = get_index_tag_bits(sys->icache, line_addr).first;
+        uint64_t index = l1_lookup.index;
         uint64_t tag = sys->icache->last_evicted_line.tag;
         last_evicted_line_address = (tag << sys->icache->num_index_bits) | index;
         is_last_evicted_line_valid = sys->icache->last_evicted_line.valid;
@@ -345,15 +888,134 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
     if (is_last_evicted_line_dirty && is_last_evicted_line_valid)
     {
         // check the is_write flag use here
-        memsys_l2_access(sys, last_evicted_line_address, true, core_id);
+        memsys_l2_access(sys, last_evicted_line_address, true, core_id,
+                         NULL, delay);
+    }
+    return delay;
+}
+
+/*
+* Function to get the cycles spent crossing the banks of a NUCA level between
+* the requesting core and the bank holding the line
+*/
+static uint64_t memsys_bank_delay(CacheLevel *level, uint64_t line_addr,
+                                  unsigned int core_id)
+{
+    if (level->num_banks <= 1)
+    {
+        return 0;
+    }
+    // Each core sits in the middle of its share of the row of banks
+    unsigned int bank = line_addr % level->num_banks;
+    unsigned int home = (2 * core_id + 1) * level->num_banks / (2 * NUM_CORES);
+    unsigned int hops = bank > home ? bank - home : home - bank;
+    uint64_t delay = hops * level->bank_hop_latency;
+    level->stat_bank_delay += delay;
+    return delay;
+}
+
+static uint64_t memsys_level_access(MemorySystem *sys, unsigned int level,
+                                    uint64_t line_addr,
+                                    const CacheLookup *lookup,
+                                    bool is_writeback, unsigned int core_id,
+                                    uint64_t upstream_delay, bool *hit);
+
+/*
+* Function to access the level below the given one, or DRAM below the last
+* level, once the access has spent upstream_delay cycles in the levels above
+*/
+static uint64_t memsys_next_level_access(MemorySystem *sys, unsigned int level,
+                                         uint64_t line_addr, bool is_write,
+                                         unsigned int core_id,
+                                         uint64_t upstream_delay)
+{
+    if (level + 1 < sys->num_levels)
+    {
+        bool hit;
+        return memsys_level_access(sys, level + 1, line_addr, NULL, is_write,
+                                   core_id, upstream_delay, &hit);
+    }
+    return dram_access(sys->dram, line_addr, is_write, core_id,
+                       upstream_delay);
+}
+
+/*
+* Function to access a cache level, filling a miss from the level below and
+* writing its dirty victims back to the level below, off the critical path
+ * @param sys The memory system to use for the access.
+ * @param level The index of the level in sys->levels.
+ * @param line_addr The (physical) address of the cache line to access.
+ * @param lookup The set index and tag of the line at this level, or NULL to
+ *               split line_addr.
+ * @param is_writeback Whether this access is a writeback from the level above.
+ * @param core_id The CPU core ID that requested this access.
+ * @param upstream_delay The cycles the access spent above this level.
+ * @param hit Set to whether the access hit at this level.
+ * @return The delay in cycles incurred by this access.
+*/
+static uint64_t memsys_level_access(MemorySystem *sys, unsigned int level,
+                                    uint64_t line_addr,
+                                    const CacheLookup *lookup,
+                                    bool is_writeback, unsigned int core_id,
+                                    uint64_t upstream_delay, bool *hit)
+{
+    CacheLevel *lvl = &sys->levels[level];
+    Cache *c = memsys_level_cache(lvl, core_id);
+    uint64_t delay = lvl->hit_latency + memsys_bank_delay(lvl, line_addr,
+                                                          core_id);
+
+    CacheLookup split;
+    if (lookup == NULL)
+    {
+        std::pair<uint64_t, uint64_t> indexTagPair = get_index_tag_bits(
+            c, line_addr);
+        split.index = indexTagPair.first;
+        split.tag = indexTagPair.second;
+        lookup = &split;
+    }
+
+    *hit = cache_access_lookup(c, lookup, is_writeback, core_id) == HIT;
+    if (*hit)
+    {
+        // A hit to a compressed line also waits for its decompression
+        return delay + c->last_access_delay;
+    }
+    delay += memsys_next_level_access(sys, level, line_addr, false, core_id,
+                                      upstream_delay + delay);
+
+    // Load line into this level
+    cache_install_lookup(c, lookup, is_writeback, core_id);
+
+    // write the dirty victims back, on behalf of the cores that owned them;
+    // a compressed install may have made room by evicting several lines
+    uint64_t index = lookup->index;
+    if (c->last_evicted_line.dirty == true &&
+        c->last_evicted_line.valid == true)
+    {
+        uint64_t tag = c->last_evicted_line.tag;
+        uint64_t last_evicted_line_address = (tag << c->num_index_bits) | index;
+        memsys_next_level_access(sys, level, last_evicted_line_address, true,
+                                 c->last_evicted_line.coreID,
+                                 upstream_delay + delay);
+    }
+    for (const CacheLine &line : c->extra_evicted_lines)
+    {
+        if (line.dirty && line.valid)
+        {
+            uint64_t evicted_address = (line.tag << c->num_index_bits) | index;
+            memsys_next_level_access(sys, level, evicted_address, true,
+                                     line.coreID, upstream_delay + delay);
+        }
     }
     return delay;
 }
 
 /**
- * Access the given address through the shared L2 cache.
+ * Access the given address through the L2 cache of the requesting core, and
+ * on a miss through the levels below it.
  * 
- * Return the delay in cycles incurred by the L2 (and possibly DRAM) access.
+ * Return the delay in cycles incurred by the L2 (and possibly L3 and DRAM)
+ * access.
  * 
  * This is intended to be implemented in part B and used in parts B through F
  * for icache misses, dcache misses, and dcache writebacks.
@@ -364,38 +1026,60 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
  *                  offset bits).
  * @param is_writeback Whether this access is a writeback from an L1 cache.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The set index and tag of the line in the L2 cache, or NULL to
+ *               split line_addr.
+ * @param upstream_delay The cycles the access already spent above the L2,
+ *                       e.g., in the L1 cache and address translation, which
+ *                       delay its arrival at the levels below.
  * @return The delay in cycles incurred by this access.
  */
 uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
-                          bool is_writeback, unsigned int core_id)
+                          bool is_writeback, unsigned int core_id,
+                          const CacheLookup *lookup, uint64_t upstream_delay)
 {
-    uint64_t delay = L2CACHE_HIT_LATENCY;
-    // TODO: Perform the L2 cache access.
-    CacheResult l2outcome = cache_access(sys->l2cache, line_addr, is_writeback, core_id);
-    if (l2outcome == HIT)
+    uint64_t delay = sys->levels[0].hit_latency;
+    CacheLookup split;
+    if (lookup == NULL)
     {
-        return delay;
+        std::pair<uint64_t, uint64_t> indexTagPair = get_index_tag_bits(
+            memsys_level_cache(&sys->levels[0], core_id), line_addr);
+        split.index = indexTagPair.first;
+        split.tag = indexTagPair.second;
+        lookup = &split;
     }
-    // TODO: Use the dram_access() function to get the delay of an L2 miss.
-    delay += dram_access(sys->dram, line_addr, false);
 
-    // Load line into l2
-    cache_install(sys->l2cache, line_addr, is_writeback, core_id);
+    if (sys->l2sampler)
+    {
+        // Accesses to sets outside the sample never reach the cache, but
+        // some go on below as misses so that the traffic and row locality
+        // seen by DRAM, and thus the timing of the cores, stay realistic
+        if (!set_sampler_is_sampled(sys->l2sampler, lookup->index))
+        {
+            if (set_sampler_filter(sys->l2sampler, is_writeback, core_id))
+            {
+                delay += memsys_next_level_access(sys, 0, line_addr, false,
+                                                  core_id,
+                                                  upstream_delay + delay);
+            }
+            return delay;
+        }
+    }
 
-    // check last evicted line
-    if (sys->l2cache->last_evicted_line.dirty == true &&
-        sys->l2cache->last_evicted_line.valid == true)
+    // The uncompressed shadow of a compressed L2 sees the same accesses
+    if (sys->l2shadow &&
+        cache_access(sys->l2shadow, line_addr, is_writeback, core_id) == MISS)
     {
-        uint64_t index = get_index_tag_bits(sys->l2cache, line_addr).first;
-        uint64_t tag = sys->l2cache->last_evicted_line.tag;
-        uint64_t last_evicted_line_address = (tag << sys->l2cache->num_index_bits) | index;
-        // write to dram
-        dram_access(sys->dram, last_evicted_line_address, true);
+        cache_install(sys->l2shadow, line_addr, is_writeback, core_id);
     }
 
-    // TODO: Use the dram_access() function to perform writebacks to memory.
-    //       Note that writebacks are done off the critical path.
-    // This will help us track your memory reads and memory writes.
+    bool hit;
+    delay = memsys_level_access(sys, 0, line_addr, lookup, is_writeback,
+                                core_id, upstream_delay, &hit);
+    if (sys->l2sampler)
+    {
+        set_sampler_record(sys->l2sampler, lookup->index, is_writeback, hit,
+                           core_id);
+    }
     return delay;
 }
 
@@ -418,10 +1102,12 @@ uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
  *                    bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
-                               AccessType type, unsigned int core_id)
+                               AccessType type, unsigned int core_id,
+                               const MemsysLookup *lookup)
 {
     uint64_t delay = 0;
     uint64_t p_line_addr = 0;
@@ -433,12 +1119,27 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
     uint64_t mask = ~(vpn_addr << (int)log2(PAGE_SIZE)); // this will create mask {(not vpn), 1111..1}
     uint64_t page_offset = v_line_addr & mask;
 
-    uint64_t ppn_addr = memsys_convert_vpn_to_pfn(sys, vpn_addr, core_id);
+    uint64_t ppn_addr;
+    if (ENABLE_TLB)
+    {
+        ppn_addr = memsys_translate(sys, vpn_addr, type, core_id, &delay);
+    }
+    else
+    {
+        ppn_addr = memsys_convert_vpn_to_pfn(sys, vpn_addr, core_id);
+    }
     p_line_addr = (ppn_addr << (int)log2(PAGE_SIZE)) | page_offset;
 
     // Now to remove the line offset bits
     p_line_addr = p_line_addr >> (int)log2(CACHE_LINESIZE);
 
+    // A lookup made ahead of time only holds if the page was already mapped
+    // to the frame it is translated to now
+    if (lookup && lookup->line_addr != p_line_addr)
+    {
+        lookup = NULL;
+    }
+
 
     // TODO: First convert lineaddr from virtual (v) to physical (p) using the
     //       function memsys_convert_vpn_to_pfn(). Page size is defined to be
@@ -469,17 +1170,21 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
         is_write = true;
     }
 
+    Cache *l1cache = needs_dcache_access ? sys->dcache_coreid[core_id] : sys->icache_coreid[core_id];
+    CacheLookup l1_lookup = memsys_l1_lookup(l1cache, p_line_addr, lookup);
+    const CacheLookup *l2_lookup = lookup ? &lookup->l2 : NULL;
+
     CacheResult dcache_outcome, icache_outcome;
     if (needs_dcache_access)
     {
-        dcache_outcome = cache_access(sys->dcache_coreid[core_id], p_line_addr, is_write,
+        dcache_outcome = cache_access_lookup(sys->dcache_coreid[core_id], &l1_lookup, is_write,
             core_id);
         delay += DCACHE_HIT_LATENCY;
         if (dcache_outcome == HIT) return delay;
     }
     else if (needs_icache_access)
     {
-        icache_outcome = cache_access(sys->icache_coreid[core_id], p_line_addr, is_write,
+        icache_outcome = cache_access_lookup(sys->icache_coreid[core_id], &l1_lookup, is_write,
             core_id);
         delay += ICACHE_HIT_LATENCY;
         if (icache_outcome == HIT) return delay;
@@ -489,7 +1194,8 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
     if (dcache_outcome == MISS || icache_outcome == MISS)
     {
         // read from l2
-        delay += memsys_l2_access(sys, p_line_addr, false, core_id);
+        delay += memsys_l2_access(sys, p_line_addr, false, core_id,
+                                  l2_lookup, delay);
     }
 
     bool is_last_evicted_line_dirty = false, is_last_evicted_line_valid = false;
@@ -500,9 +1206,9 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
         dcache_outcome == MISS)
     {
         // install into l1 dcache
-        cache_install(sys->dcache_coreid[core_id], p_line_addr, is_write, core_id);
+        cache_install_lookup(sys->dcache_coreid[core_id], &l1_lookup, is_write, core_id);
         is_last_evicted_line_dirty = sys->dcache_coreid[core_id]->last_evicted_line.dirty;
-        uint64_t index = get_index_tag_bits(sys->dcache_coreid[core_id], p_line_addr).first;
+        uint64_t index = l1_lookup.index;
         uint64_t tag = sys->dcache_coreid[core_id]->last_evicted_line.tag;
         last_evicted_line_address = (tag << sys->dcache_coreid[core_id]->num_index_bits) | index;
         is_last_evicted_line_valid = sys->dcache_coreid[core_id]->last_evicted_line.valid;
@@ -510,9 +1216,9 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
     else if (needs_icache_access == true &&
         icache_outcome == MISS)
     {
-        cache_install(sys->icache_coreid[core_id], p_line_addr, is_write, core_id);
+        cache_install_lookup(sys->icache_coreid[core_id], &l1_lookup, is_write, core_id);
         is_last_evicted_line_dirty = sys->icache_coreid[core_id]->last_evicted_line.dirty;
-        uint64_t index = get_index_tag_bits(sys->icache_coreid[core_id], p_line_addr).first;
+        uint64_t index = l1_lookup.index;
         uint64_t tag = sys->icache_coreid[core_id]->last_evicted_line.tag;
         last_evicted_line_address = (tag << sys->icache_coreid[core_id]->num_index_bits) | index;
         is_last_evicted_line_valid = sys->icache_coreid[core_id]->last_evicted_line.valid;
@@ -522,16 +1228,141 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
     if (is_last_evicted_line_dirty && is_last_evicted_line_valid)
     {
         // check the is_write flag use here
-        memsys_l2_access(sys, last_evicted_line_address, true, core_id);
+        memsys_l2_access(sys, last_evicted_line_address, true, core_id,
+                         NULL, delay);
     }
     return delay;
 }
 
+/**
+ * Translate the given virtual page number through the per-core L1 TLB of the
+ * given access type, the shared L2 TLB and, on an L2 TLB miss, a page table
+ * walk.
+ * 
+ * With huge pages enabled, the TLBs hold 2 MB translations and the walk skips
+ * the last level of the page table.
+ * 
+ * @param sys The memory system being used.
+ * @param vpn The (4 KB) virtual page number to translate.
+ * @param type The type of memory access that needs the translation.
+ * @param core_id The CPU core ID that requested this access.
+ * @param delay Incremented by the cycles spent on the translation.
+ * @return The (4 KB) physical frame number corresponding to the given VPN.
+ */
+uint64_t memsys_translate(MemorySystem *sys, uint64_t vpn, AccessType type,
+                          unsigned int core_id, uint64_t *delay)
+{
+    // With huge pages, the TLBs are tagged with the 2 MB page number and the
+    // low VPN bits pass through untranslated.
+    unsigned int page_shift = 0;
+    if (ENABLE_HUGE_PAGES)
+    {
+        page_shift = (int)log2(HUGE_PAGE_SIZE / PAGE_SIZE);
+    }
+    uint64_t page_mask = (1ULL << page_shift) - 1;
+    uint64_t tlb_vpn = vpn >> page_shift;
+    uint64_t tlb_pfn = 0;
+
+    TLB *l1tlb = (type == ACCESS_TYPE_IFETCH) ? sys->itlb_coreid[core_id]
+                                              : sys->dtlb_coreid[core_id];
+    if (tlb_lookup(l1tlb, tlb_vpn, core_id, &tlb_pfn) == HIT)
+    {
+        return (tlb_pfn << page_shift) | (vpn & page_mask);
+    }
+
+    uint64_t translation_delay = L2TLB_HIT_LATENCY;
+    if (tlb_lookup(sys->l2tlb, tlb_vpn, core_id, &tlb_pfn) == MISS)
+    {
+        uint64_t walk_delay = memsys_page_walk(sys, vpn, core_id);
+        sys->stat_page_walks++;
+        sys->stat_page_walk_delay += walk_delay;
+        translation_delay += walk_delay;
+
+        // Both the fixed mapping and the page allocator keep 2 MB aligned
+        // regions contiguous, so the frame of a huge page is the frame of its
+        // first 4 KB page.
+        tlb_pfn = memsys_convert_vpn_to_pfn(sys, vpn & ~page_mask, core_id)
+                  >> page_shift;
+        tlb_install(sys->l2tlb, tlb_vpn, tlb_pfn, core_id);
+    }
+    tlb_install(l1tlb, tlb_vpn, tlb_pfn, core_id);
+
+    sys->stat_translation_delay += translation_delay;
+    *delay += translation_delay;
+    return (tlb_pfn << page_shift) | (vpn & page_mask);
+}
+
+/**
+ * Walk the radix page table of the given core to find the translation of the
+ * given virtual page number.
+ * 
+ * Each level of the walk reads one page table entry through the shared L2
+ * cache (and DRAM on an L2 miss), one level after the other.
+ * 
+ * @param sys The memory system being used.
+ * @param vpn The (4 KB) virtual page number to translate.
+ * @param core_id The CPU core ID that requested this access.
+ * @return The delay in cycles incurred by the page table walk.
+ */
+uint64_t memsys_page_walk(MemorySystem *sys, uint64_t vpn,
+                          unsigned int core_id)
+{
+    uint64_t delay = 0;
+
+    // A huge page is mapped directly by the second to last level.
+    unsigned int levels = PAGE_TABLE_LEVELS;
+    if (ENABLE_HUGE_PAGES)
+    {
+        levels--;
+    }
+
+    for (unsigned int level = 0; level < levels; level++)
+    {
+        // Lay each level of each core's page table out as one flat array of
+        // entries, indexed by the VPN bits resolved so far.
+        uint64_t entry_index = vpn >> (PAGE_TABLE_LEVEL_BITS *
+                                       (PAGE_TABLE_LEVELS - 1 - level));
+        uint64_t pte_addr = PAGE_TABLE_BASE +
+                            ((uint64_t)core_id << 36) +
+                            ((uint64_t)level << 32) +
+                            entry_index * PAGE_TABLE_ENTRY_SIZE;
+        // The walk starts once the L2 TLB has missed, and each level waits
+        // for the one before it
+        delay += memsys_l2_access(sys, pte_addr / CACHE_LINESIZE, false,
+                                  core_id, NULL, L2TLB_HIT_LATENCY + delay);
+    }
+
+    return delay;
+}
+
+/**
+ * Get the number of page colors the page coloring policy partitions between
+ * the cores, or 1 if the page allocation policy does not color pages.
+ * 
+ * @return The number of page colors.
+ */
+unsigned int memsys_page_colors()
+{
+    if (PAGE_ALLOC_POLICY == PAGE_ALLOC_COLOR_L2)
+    {
+        // Pages of different colors map to disjoint L2 sets
+        unsigned int colors = L2CACHE_SIZE / (L2CACHE_ASSOC * PAGE_SIZE);
+        return colors > 0 ? colors : 1;
+    }
+    if (PAGE_ALLOC_POLICY == PAGE_ALLOC_COLOR_BANK)
+    {
+        return dram_get_page_colors(PAGE_SIZE);
+    }
+    return 1;
+}
+
 /**
  * Convert the given virtual page number (VPN) to its corresponding physical
  * frame number (PFN; also known as physical page number, or PPN).
  * 
- * This is implemented for you and shouldn't need to be modified.
+ * With the fixed page allocation policy, this uses the arithmetic mapping of
+ * part D. Otherwise the core's page table is looked up, and a frame is
+ * allocated on the first touch of the page.
  * 
  * Note that you will need additional operations to obtain the VPN from the
  * v_line_addr and to get the physical line_addr using the PFN.
@@ -544,6 +1375,11 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
 uint64_t memsys_convert_vpn_to_pfn(MemorySystem *sys, uint64_t vpn,
                                    unsigned int core_id)
 {
+    if (PAGE_ALLOC_POLICY != PAGE_ALLOC_FIXED)
+    {
+        return page_alloc_translate(sys->page_alloc, vpn, core_id);
+    }
+
     assert(NUM_CORES == 2);
     uint64_t tail = vpn & 0x000fffff;
     uint64_t head = vpn >> 20;
@@ -551,6 +1387,72 @@ uint64_t memsys_convert_vpn_to_pfn(MemorySystem *sys, uint64_t vpn,
     return pfn;
 }
 
+/*
+* Function to print the DRAM statistics, followed by the per-bank row buffer
+* statistics for the adaptive page policies, the energy report if enabled,
+* and, with bandwidth caps or in multi-core energy reports, the per-core
+* accounting
+*/
+static void memsys_print_dram_stats(DRAM *dram)
+{
+    dram_print_stats(dram);
+    if (DRAM_PAGE_POLICY >= TIMEOUT_PAGE || DRAM_POWER_STATS)
+    {
+        dram_print_bank_stats(dram);
+    }
+    if (DRAM_POWER_STATS)
+    {
+        dram_print_power_stats(dram);
+    }
+    if (DRAM_CORE_BW_CAP[0] > 0 || DRAM_CORE_BW_CAP[1] > 0 ||
+        (DRAM_POWER_STATS && NUM_CORES > 1))
+    {
+        dram_print_core_stats(dram, NUM_CORES);
+    }
+}
+
+/*
+* Function to print the statistics of each cache level below the L1 caches,
+* with those of the L2 set sampler and compression after the L2 cache
+*/
+static void memsys_print_level_stats(MemorySystem *sys)
+{
+    for (unsigned int i = 0; i < sys->num_levels; i++)
+    {
+        CacheLevel *level = &sys->levels[i];
+        if (level->is_private)
+        {
+            for (unsigned int j = 0; j < 2; j++)
+            {
+                char label[32];
+                snprintf(label, sizeof(label), "%s_%u", level->name, j);
+                cache_print_stats(level->caches[j], label);
+            }
+        }
+        else
+        {
+            cache_print_stats(level->caches[0], level->name);
+        }
+
+        if (level->caches[0] == sys->l2cache && sys->l2shadow)
+        {
+            cache_print_compression_stats(sys->l2cache, sys->l2shadow,
+                                          level->name);
+        }
+        if (level->caches[0] == sys->l2cache && sys->l2sampler)
+        {
+            set_sampler_print_stats(sys->l2sampler, level->name);
+        }
+        if (level->num_banks > 1)
+        {
+            printf("%s_NUCA_BANKS       \t\t : %10u\n", level->name,
+                   level->num_banks);
+            printf("%s_NUCA_BANK_DELAY  \t\t : %10llu\n", level->name,
+                   (unsigned long long)level->stat_bank_delay);
+        }
+    }
+}
+
 /**
  * Print the statistics of the memory system.
  * 
@@ -596,8 +1498,8 @@ void memsys_print_stats(MemorySystem *sys)
     {
         cache_print_stats(sys->icache, "ICACHE");
         cache_print_stats(sys->dcache, "DCACHE");
-        cache_print_stats(sys->l2cache, "L2CACHE");
-        dram_print_stats(sys->dram);
+        memsys_print_level_stats(sys);
+        memsys_print_dram_stats(sys->dram);
     }
 
     if (SIM_MODE == SIM_MODE_DEF)
@@ -607,7 +1509,41 @@ void memsys_print_stats(MemorySystem *sys)
         cache_print_stats(sys->dcache_coreid[0], "DCACHE_0");
         cache_print_stats(sys->icache_coreid[1], "ICACHE_1");
         cache_print_stats(sys->dcache_coreid[1], "DCACHE_1");
-        cache_print_stats(sys->l2cache, "L2CACHE");
-        dram_print_stats(sys->dram);
+        memsys_print_level_stats(sys);
+        memsys_print_dram_stats(sys->dram);
+
+        if (PAGE_ALLOC_POLICY != PAGE_ALLOC_FIXED)
+        {
+            page_alloc_print_stats(sys->page_alloc);
+        }
+
+        if (ENABLE_TLB)
+        {
+            double page_walk_delay_avg = 0;
+            if (sys->stat_page_walks)
+            {
+                page_walk_delay_avg = (double)(sys->stat_page_walk_delay) /
+                                      (double)(sys->stat_page_walks);
+            }
+
+            tlb_print_stats(sys->itlb_coreid[0], "ITLB_0");
+            tlb_print_stats(sys->dtlb_coreid[0], "DTLB_0");
+            tlb_print_stats(sys->itlb_coreid[1], "ITLB_1");
+            tlb_print_stats(sys->dtlb_coreid[1], "DTLB_1");
+            tlb_print_stats(sys->l2tlb, "L2TLB");
+
+            printf("\n");
+            printf("MEMSYS_PAGE_WALKS      \t\t : %10llu\n",
+                   sys->stat_page_walks);
+            printf("MEMSYS_PAGE_WALK_AVGDELAY \t : %10.3f\n",
+                   page_walk_delay_avg);
+            printf("MEMSYS_TRANSLATION_DELAY \t : %10llu\n",
+                   (unsigned long long)sys->stat_translation_delay);
+        }
+    }
+
+    if (sys->profiler)
+    {
+        profiler_print_report(sys->profiler, PROFILE_REPORT_ROWS);
     }
 }
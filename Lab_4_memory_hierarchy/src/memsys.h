@@ -11,11 +11,80 @@
 #include "types.h"
 #include "cache.h"
 #include "dram.h"
+#include "tlb.h"
+#include "pagealloc.h"
+#include "profile.h"
+#include "setsample.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of bytes in a page. */
+#define PAGE_SIZE 4096
+
+/**
+ * The number of memory accesses whose cache sets memsys_lookup_batch() looks
+ * up at once.
+ */
+#define MEMSYS_LOOKUP_BATCH 128
+
+/** The maximum number of cache levels below the L1 caches. */
+#define MEMSYS_MAX_LEVELS 2
 
 ///////////////////////////////////////////////////////////////////////////////
 //                              DATA STRUCTURES                              //
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * The (physical) cache line of an upcoming memory access, split ahead of time
+ * into its set index and tag in the L1 cache and the L2 cache it will go to.
+ */
+typedef struct MemsysLookup
+{
+    /**
+     * Whether the line is known; in mode D, E, or F it is not until the page
+     * has been mapped.
+     */
+    bool valid;
+    /** The physical address of the cache line. */
+    uint64_t line_addr;
+    /** The lookup in the L1 instruction or data cache. */
+    CacheLookup l1;
+    /** The lookup in the L2 cache, if there is one. */
+    CacheLookup l2;
+} MemsysLookup;
+
+/**
+ * A level of the cache hierarchy below the L1 caches: either one cache shared
+ * by every core, or a private cache per core. A shared level may be split into
+ * banks with non-uniform access latencies (NUCA).
+ */
+typedef struct CacheLevel
+{
+    /** The name of the level, which prefixes its statistics. */
+    const char *name;
+    /** Whether each core has its own cache at this level. */
+    bool is_private;
+    /**
+     * The cache of each core if the level is private, or else the shared
+     * cache in caches[0] and NULL in caches[1].
+     */
+    Cache *caches[2];
+    /** The hit time of the level in cycles, from the nearest bank. */
+    uint64_t hit_latency;
+
+    /**
+     * The number of banks, which are interleaved by line address and laid out
+     * in a row with the cores spread evenly along it. 1 for a uniform cache.
+     */
+    unsigned int num_banks;
+    /** The extra cycles per bank between a core and the bank it accesses. */
+    uint64_t bank_hop_latency;
+    /** The total number of cycles spent crossing banks. */
+    uint64_t stat_bank_delay;
+} CacheLevel;
+
 typedef struct MemorySystem
 {
     /** A cache for data accesses. Used in parts A, B, and C. */
@@ -34,10 +103,76 @@ typedef struct MemorySystem
      */
     Cache *icache_coreid[2];
 
-    /** The shared L2 cache. Used in parts B, C, D, E, and F. */
+    /**
+     * The cache levels below the L1 caches, from the L2 down to the level in
+     * front of DRAM. Used in parts B, C, D, E, and F.
+     */
+    CacheLevel levels[MEMSYS_MAX_LEVELS];
+    /** The number of cache levels below the L1 caches. */
+    unsigned int num_levels;
+
+    /**
+     * The shared L2 cache, i.e., the cache of levels[0] unless the L2 caches
+     * are private, in which case this is NULL. Used in parts B, C, D, E, and
+     * F.
+     */
     Cache *l2cache;
     /** The DRAM module. Used in parts B, C, D, E, and F. */
     DRAM *dram;
+    /**
+     * The sampler choosing which L2 sets are simulated, which is only
+     * allocated when L2 set sampling is enabled.
+     */
+    SetSampler *l2sampler;
+    /**
+     * An uncompressed copy of the L2 cache fed the same accesses, to measure
+     * how compression changes the miss rate. Only allocated when the L2 cache
+     * is compressed.
+     */
+    Cache *l2shadow;
+
+    /**
+     * The instruction TLBs for each core. Used in parts D, E, and F when
+     * address translation is simulated.
+     */
+    TLB *itlb_coreid[2];
+    /**
+     * The data TLBs for each core. Used in parts D, E, and F when address
+     * translation is simulated.
+     */
+    TLB *dtlb_coreid[2];
+    /**
+     * The second-level TLB shared by both cores. Used in parts D, E, and F
+     * when address translation is simulated.
+     */
+    TLB *l2tlb;
+
+    /**
+     * The physical page allocator. Used in parts D, E, and F unless the fixed
+     * VPN to PFN mapping is selected.
+     */
+    PageAllocator *page_alloc;
+
+    /**
+     * The hot-spot profiler, which is only allocated when profiling is
+     * enabled.
+     */
+    Profiler *profiler;
+    /**
+     * The address of the instruction whose accesses are being made, set by
+     * the core so that the profiler can attribute them.
+     */
+    uint64_t profile_inst_addr;
+
+    /** The total number of page table walks caused by L2 TLB misses. */
+    unsigned long long stat_page_walks;
+    /** The total number of cycles spent on page table walks. */
+    uint64_t stat_page_walk_delay;
+    /**
+     * The total number of cycles spent on address translation, including L2
+     * TLB hits and page table walks.
+     */
+    uint64_t stat_translation_delay;
 
     /**
      * The total number of times the memory system was accessed for an
@@ -101,6 +236,69 @@ MemorySystem *memsys_new();
 uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
                        unsigned int core_id);
 
+/**
+ * Access the given memory address only to warm up the memory system: the tag
+ * stores, replacement state, TLBs and DRAM row buffers are updated as by
+ * memsys_access(), but the delay is discarded and neither the memory system
+ * statistics nor the profiler are updated.
+ * 
+ * The caches still count the accesses, so clear the statistics with
+ * memsys_clear_stats() once the warm-up is over.
+ * 
+ * @param sys The memory system to use for the access.
+ * @param addr The address to access (in bytes).
+ * @param type The type of memory access.
+ * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL
+ *               to look the line up during the access.
+ */
+void memsys_warm_access(MemorySystem *sys, uint64_t addr, AccessType type,
+                        unsigned int core_id, const MemsysLookup *lookup);
+
+/**
+ * Look up a block of upcoming memory accesses of a core in its L1 and L2
+ * caches at once, and prefetch the cache sets they map to into the host
+ * caches, so that making the accesses afterwards with memsys_warm_access()
+ * neither splits the addresses again nor stalls on host memory when the
+ * simulated caches are large. The state of the memory system is not changed.
+ * 
+ * In mode D, E, or F each address is first translated through the page
+ * table, without touching the TLBs; an access to a page that is not mapped
+ * yet is left invalid and looked up when it is made.
+ * 
+ * Only the functional warm-up reads the trace far enough ahead to use this.
+ * 
+ * @param sys The memory system the accesses will be made to.
+ * @param addrs The addresses that will be accessed (in bytes).
+ * @param types The type of each memory access.
+ * @param count The number of accesses.
+ * @param core_id The CPU core ID that will make the accesses.
+ * @param lookups Set to the lookups of each access.
+ */
+void memsys_lookup_batch(MemorySystem *sys, const uint64_t *addrs,
+                         const AccessType *types, size_t count,
+                         unsigned int core_id, MemsysLookup *lookups);
+
+/**
+ * Reset every statistic of the memory system, its caches, TLBs, DRAM and L2
+ * set sampler to zero, keeping their contents and replacement state. The
+ * frames held by the page allocator stay allocated.
+ * 
+ * @param sys The memory system whose statistics to clear.
+ */
+void memsys_clear_stats(MemorySystem *sys);
+
+/**
+ * Read the event counters that the profiler attributes to accesses from the
+ * given core: its L1 misses, the L2 misses and the DRAM row conflicts.
+ * 
+ * @param sys The memory system to read the counters of.
+ * @param core_id The CPU core ID whose L1 caches are read.
+ * @param counters Set to the current counter values.
+ */
+void memsys_profile_counters(MemorySystem *sys, unsigned int core_id,
+                             ProfileSample *counters);
+
 /**
  * In mode A, access the given memory address from a load or store.
  * 
@@ -114,10 +312,12 @@ uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
  *                  cache line size, i.e., excluding the line offset bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL.
  * @return Always 0 in this mode.
  */
 uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
-                             AccessType type, unsigned int core_id);
+                             AccessType type, unsigned int core_id,
+                             const MemsysLookup *lookup);
 
 /**
  * In mode B or C, access the given memory address from an instruction fetch or
@@ -134,15 +334,19 @@ uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
  *                  cache line size, i.e., excluding the line offset bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
-                              AccessType type, unsigned int core_id);
+                              AccessType type, unsigned int core_id,
+                              const MemsysLookup *lookup);
 
 /**
- * Access the given address through the shared L2 cache.
+ * Access the given address through the L2 cache of the requesting core, and
+ * on a miss through the levels below it.
  * 
- * Return the delay in cycles incurred by the L2 (and possibly DRAM) access.
+ * Return the delay in cycles incurred by the L2 (and possibly L3 and DRAM)
+ * access.
  * 
  * This is intended to be implemented in part B and used in parts B through F
  * for icache misses, dcache misses, and dcache writebacks.
@@ -153,10 +357,16 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
  *                  offset bits).
  * @param is_writeback Whether this access is a writeback from an L1 cache.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The set index and tag of the line in the L2 cache, or NULL to
+ *               split line_addr.
+ * @param upstream_delay The cycles the access already spent above the L2,
+ *                       e.g., in the L1 cache and address translation, which
+ *                       delay its arrival at the levels below.
  * @return The delay in cycles incurred by this access.
  */
 uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
-                          bool is_writeback, unsigned int core_id);
+                          bool is_writeback, unsigned int core_id,
+                          const CacheLookup *lookup, uint64_t upstream_delay);
 
 /**
  * In mode D, E, or F, access the given virtual address from an instruction
@@ -177,16 +387,61 @@ uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
  *                    bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param lookup The lookups of the access from memsys_lookup_batch(), or NULL.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
-                               AccessType type, unsigned int core_id);
+                               AccessType type, unsigned int core_id,
+                               const MemsysLookup *lookup);
+
+/**
+ * Translate the given virtual page number through the per-core L1 TLB of the
+ * given access type, the shared L2 TLB and, on an L2 TLB miss, a page table
+ * walk.
+ * 
+ * With huge pages enabled, the TLBs hold 2 MB translations and the walk skips
+ * the last level of the page table.
+ * 
+ * @param sys The memory system being used.
+ * @param vpn The (4 KB) virtual page number to translate.
+ * @param type The type of memory access that needs the translation.
+ * @param core_id The CPU core ID that requested this access.
+ * @param delay Incremented by the cycles spent on the translation.
+ * @return The (4 KB) physical frame number corresponding to the given VPN.
+ */
+uint64_t memsys_translate(MemorySystem *sys, uint64_t vpn, AccessType type,
+                          unsigned int core_id, uint64_t *delay);
+
+/**
+ * Walk the radix page table of the given core to find the translation of the
+ * given virtual page number.
+ * 
+ * Each level of the walk reads one page table entry through the shared L2
+ * cache (and DRAM on an L2 miss), one level after the other.
+ * 
+ * @param sys The memory system being used.
+ * @param vpn The (4 KB) virtual page number to translate.
+ * @param core_id The CPU core ID that requested this access.
+ * @return The delay in cycles incurred by the page table walk.
+ */
+uint64_t memsys_page_walk(MemorySystem *sys, uint64_t vpn,
+                          unsigned int core_id);
+
+/**
+ * Get the number of page colors the page coloring policy partitions between
+ * the cores, or 1 if the page allocation policy does not color pages.
+ * 
+ * @return The number of page colors.
+ */
+unsigned int memsys_page_colors();
 
 /**
  * Convert the given virtual page number (VPN) to its corresponding physical
  * frame number (PFN; also known as physical page number, or PPN).
  * 
- * This is implemented for you and shouldn't need to be modified.
+ * With the fixed page allocation policy, this uses the arithmetic mapping of
+ * part D. Otherwise the core's page table is looked up, and a frame is
+ * allocated on the first touch of the page.
  * 
  * Note that you will need additional operations to obtain the VPN from the
  * v_line_addr and to get the physical line_addr using the PFN.
@@ -0,0 +1,254 @@
+// pagealloc.cpp
+// Defines the functions used to implement the physical page allocator.
+
+#include "pagealloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a page allocator.
+ *
+ * @param policy The frame allocation policy.
+ * @param num_frames The number of physical frames in memory.
+ * @param num_colors The number of page colors, used by the coloring policies.
+ * @param core0_colors The number of colors given to core 0 by the coloring
+ *                     policies, less than num_colors, or 0 to split the
+ *                     colors evenly.
+ * @param alloc_order The log2 of the number of frames allocated at a time.
+ * @return A pointer to the page allocator.
+ */
+PageAllocator *page_alloc_new(PageAllocPolicy policy, uint64_t num_frames,
+                              unsigned int num_colors,
+                              unsigned int core0_colors,
+                              unsigned int alloc_order)
+{
+    PageAllocator *pa = new PageAllocator;
+    pa->policy = policy;
+    pa->num_frames = num_frames;
+    pa->alloc_order = alloc_order;
+    pa->rng.seed(42);
+    pa->stat_frames_allocated[0] = 0;
+    pa->stat_frames_allocated[1] = 0;
+
+    if (policy == PAGE_ALLOC_RANDOM)
+    {
+        pa->frame_used.assign(num_frames, false);
+    }
+
+    if (policy == PAGE_ALLOC_BUDDY)
+    {
+        // Start with all of memory split into blocks of the largest order,
+        // pushed in reverse so that low frames are handed out first.
+        pa->free_lists.resize(PAGE_ALLOC_MAX_ORDER + 1);
+        uint64_t block_frames = 1ULL << PAGE_ALLOC_MAX_ORDER;
+        for (uint64_t frame = num_frames; frame >= block_frames;
+             frame -= block_frames)
+        {
+            pa->free_lists[PAGE_ALLOC_MAX_ORDER].push_back(frame -
+                                                           block_frames);
+        }
+    }
+
+    pa->num_colors = num_colors;
+    if (num_colors < 2)
+    {
+        // Nothing to partition: both cores share the only color.
+        pa->num_colors = 1;
+        pa->color_lo[0] = pa->color_lo[1] = 0;
+        pa->color_hi[0] = pa->color_hi[1] = 1;
+    }
+    else
+    {
+        // An out-of-range core0_colors is rejected when parsing -color_core0
+        if (core0_colors == 0)
+        {
+            core0_colors = num_colors / 2;
+        }
+        pa->color_lo[0] = 0;
+        pa->color_hi[0] = core0_colors;
+        pa->color_lo[1] = core0_colors;
+        pa->color_hi[1] = num_colors;
+    }
+    pa->color_next_frame.assign(pa->num_colors, 0);
+
+    return pa;
+}
+
+/*
+* Function to abort the simulation once physical memory is exhausted
+*/
+static void page_alloc_out_of_memory()
+{
+    fprintf(stderr, "Error: out of physical memory, increase -physmemMB\n");
+    exit(1);
+}
+
+/*
+* Function to get a random free block of the allocation order
+ * @param pa The page allocator.
+ * @return The first frame of the block.
+*/
+static uint64_t page_alloc_random(PageAllocator *pa)
+{
+    uint64_t num_blocks = pa->num_frames >> pa->alloc_order;
+    uint64_t allocated = pa->stat_frames_allocated[0] +
+                         pa->stat_frames_allocated[1];
+    if (allocated >= pa->num_frames)
+    {
+        page_alloc_out_of_memory();
+    }
+    std::uniform_int_distribution<uint64_t> distribution(0, num_blocks - 1);
+    uint64_t frame;
+    do
+    {
+        frame = distribution(pa->rng) << pa->alloc_order;
+    } while (pa->frame_used[frame]);
+    pa->frame_used[frame] = true;
+    return frame;
+}
+
+/*
+* Function to get a free block of the allocation order from the buddy system,
+* splitting a larger block if needed
+ * @param pa The page allocator.
+ * @return The first frame of the block.
+*/
+static uint64_t page_alloc_buddy(PageAllocator *pa)
+{
+    unsigned int order = pa->alloc_order;
+    while (order <= PAGE_ALLOC_MAX_ORDER && pa->free_lists[order].empty())
+    {
+        order++;
+    }
+    if (order > PAGE_ALLOC_MAX_ORDER)
+    {
+        page_alloc_out_of_memory();
+    }
+
+    uint64_t frame = pa->free_lists[order].back();
+    pa->free_lists[order].pop_back();
+    // Keep the lower half and free the upper buddy at each split
+    while (order > pa->alloc_order)
+    {
+        order--;
+        pa->free_lists[order].push_back(frame + (1ULL << order));
+    }
+    return frame;
+}
+
+/*
+* Function to get the next free frame of a color in the core's partition
+ * @param pa The page allocator.
+ * @param vpn The virtual page number, which picks the color.
+ * @param core_id The CPU core ID that owns the page.
+ * @return The allocated frame.
+*/
+static uint64_t page_alloc_color(PageAllocator *pa, uint64_t vpn,
+                                 unsigned int core_id)
+{
+    unsigned int lo = pa->color_lo[core_id];
+    unsigned int span = pa->color_hi[core_id] - lo;
+    // Follow the virtual color so contiguous pages spread over the partition,
+    // falling back to the other colors of the partition when one runs out.
+    for (unsigned int i = 0; i < span; i++)
+    {
+        unsigned int color = lo + (vpn + i) % span;
+        uint64_t frame = color + pa->color_next_frame[color] * pa->num_colors;
+        if (frame < pa->num_frames)
+        {
+            pa->color_next_frame[color]++;
+            return frame;
+        }
+    }
+    page_alloc_out_of_memory();
+    return 0;
+}
+
+/**
+ * Look up the frame of the given virtual page in the core's page table,
+ * allocating a frame on the first touch of the page.
+ *
+ * @param pa The page allocator.
+ * @param vpn The virtual page number to translate.
+ * @param core_id The CPU core ID that owns the page.
+ * @return The physical frame number of the page.
+ */
+uint64_t page_alloc_translate(PageAllocator *pa, uint64_t vpn,
+                              unsigned int core_id)
+{
+    std::unordered_map<uint64_t, uint64_t> &page_table =
+        pa->page_table[core_id];
+    std::unordered_map<uint64_t, uint64_t>::iterator it = page_table.find(vpn);
+    if (it != page_table.end())
+    {
+        return it->second;
+    }
+
+    uint64_t frame = 0;
+    if (pa->policy == PAGE_ALLOC_RANDOM)
+    {
+        frame = page_alloc_random(pa);
+    }
+    else if (pa->policy == PAGE_ALLOC_BUDDY)
+    {
+        frame = page_alloc_buddy(pa);
+    }
+    else
+    {
+        frame = page_alloc_color(pa, vpn, core_id);
+    }
+
+    // Map every page of the (possibly huge) block on its first touch
+    uint64_t block_pages = 1ULL << pa->alloc_order;
+    uint64_t first_vpn = vpn & ~(block_pages - 1);
+    for (uint64_t i = 0; i < block_pages; i++)
+    {
+        page_table[first_vpn + i] = frame + i;
+    }
+    pa->stat_frames_allocated[core_id] += block_pages;
+
+    return frame + (vpn - first_vpn);
+}
+
+/**
+ * Look up the frame of the given virtual page in the core's page table
+ * without allocating one, e.g., to find where an upcoming access will go
+ * without changing the state of the allocator.
+ *
+ * @param pa The page allocator.
+ * @param vpn The virtual page number to translate.
+ * @param core_id The CPU core ID that owns the page.
+ * @param frame Set to the physical frame number of the page, if it is mapped.
+ * @return Whether the page is mapped.
+ */
+bool page_alloc_lookup(PageAllocator *pa, uint64_t vpn, unsigned int core_id,
+                       uint64_t *frame)
+{
+    std::unordered_map<uint64_t, uint64_t>::const_iterator it =
+        pa->page_table[core_id].find(vpn);
+    if (it == pa->page_table[core_id].end())
+    {
+        return false;
+    }
+    *frame = it->second;
+    return true;
+}
+
+/**
+ * Print the statistics of the page allocator.
+ *
+ * @param pa The page allocator to print the statistics of.
+ */
+void page_alloc_print_stats(PageAllocator *pa)
+{
+    printf("\n");
+    printf("PAGE_ALLOC_FRAMES_0    \t\t : %10llu\n",
+           pa->stat_frames_allocated[0]);
+    printf("PAGE_ALLOC_FRAMES_1    \t\t : %10llu\n",
+           pa->stat_frames_allocated[1]);
+    printf("PAGE_ALLOC_COLORS      \t\t : %10u\n", pa->num_colors);
+}
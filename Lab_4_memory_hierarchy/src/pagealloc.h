@@ -0,0 +1,150 @@
+// pagealloc.h
+// Contains declarations of data structures and functions used to implement a
+// first-touch physical page allocator.
+
+#ifndef __PAGEALLOC_H__
+#define __PAGEALLOC_H__
+
+#include "types.h"
+
+#include <vector>
+#include <random>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest block order (in frames, as a power of two) of the buddy
+ *  allocator. */
+#define PAGE_ALLOC_MAX_ORDER 10
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible policies for picking the physical frame of a new page. */
+typedef enum PageAllocPolicyEnum
+{
+    PAGE_ALLOC_FIXED = 0,      // Use the fixed VPN to PFN function of part D.
+    PAGE_ALLOC_RANDOM = 1,     // Pick a random free frame.
+    PAGE_ALLOC_BUDDY = 2,      // Allocate frames from a binary buddy system.
+    PAGE_ALLOC_COLOR_L2 = 3,   // Color frames to partition the L2 sets.
+    PAGE_ALLOC_COLOR_BANK = 4, // Color frames to partition the DRAM banks.
+} PageAllocPolicy;
+
+/** A physical page allocator shared by all cores. */
+typedef struct PageAllocator
+{
+    /*
+    * Policy used to pick frames
+    */
+    PageAllocPolicy policy;
+
+    /*
+    * Number of physical frames in memory
+    */
+    uint64_t num_frames;
+
+    /*
+    * Order (log2 of the number of frames) of every allocation, which is
+    * non-zero for huge pages
+    */
+    unsigned int alloc_order;
+
+    /*
+    * Per-core hash page tables, mapping a VPN to its PFN
+    */
+    std::unordered_map<uint64_t, uint64_t> page_table[2];
+
+    /*
+    * For the random policy, whether each frame is in use
+    */
+    std::vector<bool> frame_used;
+
+    /*
+    * For the buddy policy, the first frame of each free block of each order
+    */
+    std::vector<std::vector<uint64_t>> free_lists;
+
+    /*
+    * For the coloring policies, the number of page colors
+    */
+    unsigned int num_colors;
+
+    /*
+    * For the coloring policies, the first and one-past-last color of each
+    * core's partition
+    */
+    unsigned int color_lo[2];
+    unsigned int color_hi[2];
+
+    /*
+    * For the coloring policies, the number of frames handed out per color
+    */
+    std::vector<uint64_t> color_next_frame;
+
+    /*
+    * Random number generator for the random policy
+    */
+    std::mt19937_64 rng;
+
+    /** The number of frames allocated to each core. */
+    unsigned long long stat_frames_allocated[2];
+} PageAllocator;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a page allocator.
+ *
+ * @param policy The frame allocation policy.
+ * @param num_frames The number of physical frames in memory.
+ * @param num_colors The number of page colors, used by the coloring policies.
+ * @param core0_colors The number of colors given to core 0 by the coloring
+ *                     policies, less than num_colors, or 0 to split the
+ *                     colors evenly.
+ * @param alloc_order The log2 of the number of frames allocated at a time.
+ * @return A pointer to the page allocator.
+ */
+PageAllocator *page_alloc_new(PageAllocPolicy policy, uint64_t num_frames,
+                              unsigned int num_colors,
+                              unsigned int core0_colors,
+                              unsigned int alloc_order);
+
+/**
+ * Look up the frame of the given virtual page in the core's page table,
+ * allocating a frame on the first touch of the page.
+ *
+ * @param pa The page allocator.
+ * @param vpn The virtual page number to translate.
+ * @param core_id The CPU core ID that owns the page.
+ * @return The physical frame number of the page.
+ */
+uint64_t page_alloc_translate(PageAllocator *pa, uint64_t vpn,
+                              unsigned int core_id);
+
+/**
+ * Look up the frame of the given virtual page in the core's page table
+ * without allocating one, e.g., to find where an upcoming access will go
+ * without changing the state of the allocator.
+ *
+ * @param pa The page allocator.
+ * @param vpn The virtual page number to translate.
+ * @param core_id The CPU core ID that owns the page.
+ * @param frame Set to the physical frame number of the page, if it is mapped.
+ * @return Whether the page is mapped.
+ */
+bool page_alloc_lookup(PageAllocator *pa, uint64_t vpn, unsigned int core_id,
+                       uint64_t *frame);
+
+/**
+ * Print the statistics of the page allocator.
+ *
+ * @param pa The page allocator to print the statistics of.
+ */
+void page_alloc_print_stats(PageAllocator *pa);
+
+#endif // __PAGEALLOC_H__
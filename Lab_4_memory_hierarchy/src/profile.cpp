@@ -0,0 +1,246 @@
+// profile.cpp
+// Defines the functions used to implement the memory system hot-spot
+// profiler.
+
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* Function to add the events of one sample to a running total
+*/
+static void profile_add(ProfileSample &total, const ProfileSample &sample)
+{
+    total.stall_cycles += sample.stall_cycles;
+    total.l1_misses += sample.l1_misses;
+    total.l2_misses += sample.l2_misses;
+    total.row_conflicts += sample.row_conflicts;
+}
+
+/**
+ * Allocate and initialize a profiler.
+ *
+ * @param capacity The number of keys tracked by each sketch, of which there
+ *                 are two per access type.
+ * @param rank_by_stalls Whether to rank by stall cycles rather than L1
+ *                       misses.
+ * @return A pointer to the profiler.
+ */
+Profiler *profiler_new(unsigned int capacity, bool rank_by_stalls)
+{
+    Profiler *prof = new Profiler;
+    prof->rank_by_stalls = rank_by_stalls;
+    for (unsigned int type = 0; type < PROFILE_NUM_ACCESS_TYPES; ++type)
+    {
+        prof->pc_sketch[type].capacity = capacity;
+        prof->pc_sketch[type].entries.reserve(capacity);
+        prof->page_sketch[type].capacity = capacity;
+        prof->page_sketch[type].entries.reserve(capacity);
+        prof->stat_type_accesses[type] = 0;
+        prof->stat_type_events[type] = ProfileSample();
+    }
+    prof->stat_accesses = 0;
+    prof->stat_events = ProfileSample();
+    return prof;
+}
+
+/*
+* Function to add a weighted key to a Space-Saving sketch
+*
+* A tracked key just accumulates. Otherwise the key takes over the entry with
+* the smallest weight, inheriting that weight as its error bound, so that the
+* estimated weight never underestimates the true weight.
+*
+ * @param sketch The sketch to update.
+ * @param key The key to count.
+ * @param weight The weight to add to the key.
+ * @param sample The events to add to the key.
+*/
+static void topk_add(TopKSketch &sketch, uint64_t key, uint64_t weight,
+                     const ProfileSample &sample)
+{
+    std::unordered_map<uint64_t, unsigned int>::iterator it =
+        sketch.index.find(key);
+    TopKEntry *entry;
+    if (it != sketch.index.end())
+    {
+        entry = &sketch.entries[it->second];
+    }
+    else if (sketch.entries.size() < sketch.capacity)
+    {
+        TopKEntry fresh = TopKEntry();
+        fresh.key = key;
+        sketch.index[key] = sketch.entries.size();
+        sketch.entries.push_back(fresh);
+        entry = &sketch.entries.back();
+    }
+    else
+    {
+        unsigned int min_pos = 0;
+        for (unsigned int i = 1; i < sketch.entries.size(); ++i)
+        {
+            if (sketch.entries[i].weight < sketch.entries[min_pos].weight)
+            {
+                min_pos = i;
+            }
+        }
+        entry = &sketch.entries[min_pos];
+        sketch.index.erase(entry->key);
+        sketch.index[key] = min_pos;
+
+        uint64_t inherited = entry->weight;
+        *entry = TopKEntry();
+        entry->key = key;
+        entry->weight = inherited;
+        entry->error = inherited;
+    }
+
+    entry->weight += weight;
+    entry->accesses++;
+    profile_add(entry->events, sample);
+}
+
+/**
+ * Attribute the events of one memory access to its instruction address and
+ * to the page it accessed, in the sketches of its access type.
+ *
+ * @param prof The profiler.
+ * @param type The type of the access.
+ * @param inst_addr The address of the instruction making the access.
+ * @param page The page number of the accessed address.
+ * @param sample The events caused by the access.
+ */
+void profiler_record(Profiler *prof, AccessType type, uint64_t inst_addr,
+                     uint64_t page, const ProfileSample &sample)
+{
+    prof->stat_accesses++;
+    profile_add(prof->stat_events, sample);
+    prof->stat_type_accesses[type]++;
+    profile_add(prof->stat_type_events[type], sample);
+
+    uint64_t weight = prof->rank_by_stalls ? sample.stall_cycles
+                                           : sample.l1_misses;
+    // Accesses that cost nothing cannot be hot spots, so keep them from
+    // churning the sketches.
+    if (weight == 0)
+    {
+        return;
+    }
+
+    topk_add(prof->pc_sketch[type], inst_addr, weight, sample);
+    topk_add(prof->page_sketch[type], page, weight, sample);
+}
+
+/*
+* Function to compare sketch entries by decreasing weight
+*/
+static bool topk_heavier(const TopKEntry &a, const TopKEntry &b)
+{
+    if (a.weight != b.weight)
+    {
+        return a.weight > b.weight;
+    }
+    return a.key < b.key;
+}
+
+/*
+* Function to print one sorted table of a sketch
+*/
+static void topk_print(Profiler *prof, const TopKSketch &sketch,
+                       const char *header, const char *key_name,
+                       unsigned int top_n)
+{
+    std::vector<TopKEntry> sorted(sketch.entries);
+    std::sort(sorted.begin(), sorted.end(), topk_heavier);
+    if (sorted.size() > top_n)
+    {
+        sorted.resize(top_n);
+    }
+
+    uint64_t total = prof->rank_by_stalls ? prof->stat_events.stall_cycles
+                                          : prof->stat_events.l1_misses;
+
+    printf("\n");
+    printf("%s (ranked by %s, top %u of %u tracked)\n", header,
+           prof->rank_by_stalls ? "stall cycles" : "L1 misses",
+           (unsigned int)sorted.size(), sketch.capacity);
+    printf("%4s %18s %12s %10s %7s %10s %10s %10s %10s\n", "RANK", key_name,
+           "WEIGHT", "ERROR", "PERC", "ACCESSES", "L1_MISS", "L2_MISS",
+           "ROW_CONF");
+    double cumulative = 0.0;
+    for (unsigned int i = 0; i < sorted.size(); ++i)
+    {
+        double perc = 0.0;
+        if (total)
+        {
+            perc = 100.0 * (double)(sorted[i].weight) / (double)total;
+        }
+        cumulative += perc;
+        printf("%4u %#18llx %12llu %10llu %7.3f %10llu %10llu %10llu %10llu\n",
+               i + 1, (unsigned long long)sorted[i].key,
+               (unsigned long long)sorted[i].weight,
+               (unsigned long long)sorted[i].error, perc,
+               sorted[i].accesses,
+               (unsigned long long)sorted[i].events.l1_misses,
+               (unsigned long long)sorted[i].events.l2_misses,
+               (unsigned long long)sorted[i].events.row_conflicts);
+    }
+    printf("%-31s\t : %10.3f\n", (std::string(header) + "_TOP_PERC").c_str(),
+           cumulative);
+}
+
+/**
+ * Print the hottest instruction addresses and pages of each access type,
+ * sorted by weight.
+ *
+ * @param prof The profiler.
+ * @param top_n The maximum number of rows to print per table.
+ */
+void profiler_print_report(Profiler *prof, unsigned int top_n)
+{
+    static const char *type_names[PROFILE_NUM_ACCESS_TYPES] = {
+        "IFETCH", "LOAD", "STORE"};
+
+    printf("\n");
+    printf("PROFILE_ACCESSES       \t\t : %10llu\n", prof->stat_accesses);
+    printf("PROFILE_STALL_CYCLES   \t\t : %10llu\n",
+           (unsigned long long)prof->stat_events.stall_cycles);
+    printf("PROFILE_L1_MISSES      \t\t : %10llu\n",
+           (unsigned long long)prof->stat_events.l1_misses);
+    printf("PROFILE_L2_MISSES      \t\t : %10llu\n",
+           (unsigned long long)prof->stat_events.l2_misses);
+    printf("PROFILE_ROW_CONFLICTS  \t\t : %10llu\n",
+           (unsigned long long)prof->stat_events.row_conflicts);
+
+
+    for (unsigned int type = 0; type < PROFILE_NUM_ACCESS_TYPES; ++type)
+    {
+        if (prof->stat_type_accesses[type] == 0)
+        {
+            continue;
+        }
+
+        std::string prefix = std::string("PROFILE_") + type_names[type];
+        printf("\n");
+        printf("%-31s\t : %10llu\n", (prefix + "_ACCESSES").c_str(),
+               prof->stat_type_accesses[type]);
+        printf("%-31s\t : %10llu\n", (prefix + "_STALL_CYCLES").c_str(),
+               (unsigned long long)prof->stat_type_events[type].stall_cycles);
+        printf("%-31s\t : %10llu\n", (prefix + "_L1_MISSES").c_str(),
+               (unsigned long long)prof->stat_type_events[type].l1_misses);
+        printf("%-31s\t : %10llu\n", (prefix + "_L2_MISSES").c_str(),
+               (unsigned long long)prof->stat_type_events[type].l2_misses);
+
+        topk_print(prof, prof->pc_sketch[type], (prefix + "_PC").c_str(),
+                   "PC", top_n);
+        topk_print(prof, prof->page_sketch[type], (prefix + "_PAGE").c_str(),
+                   "PAGE", top_n);
+    }
+}
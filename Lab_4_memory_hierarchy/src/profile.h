@@ -0,0 +1,170 @@
+// profile.h
+// Contains declarations of data structures and functions used to attribute
+// memory system events to instruction addresses and data pages.
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include "types.h"
+
+#include <vector>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of access types profiled separately (see AccessType). */
+#define PROFILE_NUM_ACCESS_TYPES 3
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* The events caused by a single memory access
+*/
+typedef struct ProfileSample
+{
+    /*
+    * Cycles the core stalled for this access
+    */
+    uint64_t stall_cycles;
+
+    /*
+    * Number of L1 (instruction or data) cache misses
+    */
+    uint64_t l1_misses;
+
+    /*
+    * Number of L2 cache misses, including misses of writebacks
+    */
+    uint64_t l2_misses;
+
+    /*
+    * Number of DRAM row buffer conflicts
+    */
+    uint64_t row_conflicts;
+
+} ProfileSample;
+
+/*
+* A tracked key of a top-K sketch
+*/
+typedef struct TopKEntry
+{
+    /*
+    * Instruction address or page number being tracked
+    */
+    uint64_t key;
+
+    /*
+    * Estimated ranking weight, which overestimates the true weight by at most
+    * error
+    */
+    uint64_t weight;
+
+    /*
+    * Weight inherited from the evicted entry when this key was inserted
+    */
+    uint64_t error;
+
+    /*
+    * Events seen since the key was inserted (lower bounds of the true counts)
+    */
+    unsigned long long accesses;
+    ProfileSample events;
+
+} TopKEntry;
+
+/*
+* A Space-Saving sketch keeping the heaviest keys of a stream in bounded memory
+*/
+typedef struct TopKSketch
+{
+    /*
+    * Maximum number of tracked keys
+    */
+    unsigned int capacity;
+
+    /*
+    * Tracked keys
+    */
+    std::vector<TopKEntry> entries;
+
+    /*
+    * Map from a tracked key to its position in entries
+    */
+    std::unordered_map<uint64_t, unsigned int> index;
+
+} TopKSketch;
+
+/** A hot-spot profiler of the memory system. */
+typedef struct Profiler
+{
+    /*
+    * Whether ranking uses stall cycles (timing modes) or L1 misses (mode A)
+    */
+    bool rank_by_stalls;
+
+    /*
+    * Sketches keyed by instruction address, one per access type, so that
+    * instruction fetch misses are reported apart from data misses
+    */
+    TopKSketch pc_sketch[PROFILE_NUM_ACCESS_TYPES];
+
+    /*
+    * Sketches keyed by 4 KB page number of the accessed address, one per
+    * access type
+    */
+    TopKSketch page_sketch[PROFILE_NUM_ACCESS_TYPES];
+
+    /** The total number of profiled accesses. */
+    unsigned long long stat_accesses;
+
+    /** The total events over all profiled accesses. */
+    ProfileSample stat_events;
+
+    /** The number of profiled accesses and their events per access type. */
+    unsigned long long stat_type_accesses[PROFILE_NUM_ACCESS_TYPES];
+    ProfileSample stat_type_events[PROFILE_NUM_ACCESS_TYPES];
+} Profiler;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a profiler.
+ *
+ * @param capacity The number of keys tracked by each sketch, of which there
+ *                 are two per access type.
+ * @param rank_by_stalls Whether to rank by stall cycles rather than L1
+ *                       misses.
+ * @return A pointer to the profiler.
+ */
+Profiler *profiler_new(unsigned int capacity, bool rank_by_stalls);
+
+/**
+ * Attribute the events of one memory access to its instruction address and
+ * to the page it accessed, in the sketches of its access type.
+ *
+ * @param prof The profiler.
+ * @param type The type of the access.
+ * @param inst_addr The address of the instruction making the access.
+ * @param page The page number of the accessed address.
+ * @param sample The events caused by the access.
+ */
+void profiler_record(Profiler *prof, AccessType type, uint64_t inst_addr,
+                     uint64_t page, const ProfileSample &sample);
+
+/**
+ * Print the hottest instruction addresses and pages of each access type,
+ * sorted by weight.
+ *
+ * @param prof The profiler.
+ * @param top_n The maximum number of rows to print per table.
+ */
+void profiler_print_report(Profiler *prof, unsigned int top_n);
+
+#endif // __PROFILE_H__
@@ -0,0 +1,472 @@
+// reuse.cpp
+// Defines the functions used to compute reuse-distance histograms and
+// working-set sizes of a memory trace.
+
+#include "reuse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The initial number of timestamps held by the Fenwick tree of a stack. */
+#define REUSE_INITIAL_CAPACITY (1 << 20)
+
+/** The log2 of the initial number of entries of a line or page table. */
+#define REUSE_TABLE_INITIAL_LOG2 16
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* Function to initialize an empty line or page table
+*/
+static void reuse_table_init(ReuseTable &table)
+{
+    table.entries.assign(1ULL << REUSE_TABLE_INITIAL_LOG2, ReuseTableEntry());
+    table.log2_size = REUSE_TABLE_INITIAL_LOG2;
+    table.num_keys = 0;
+}
+
+/*
+* Function to get the home slot of a key (Fibonacci hashing)
+*/
+static inline uint64_t reuse_table_slot(const ReuseTable &table, uint64_t key)
+{
+    return (key * 0x9E3779B97F4A7C15ULL) >> (64 - table.log2_size);
+}
+
+/*
+* Function to double the number of entries of a table and rehash its keys
+*/
+static void reuse_table_grow(ReuseTable &table)
+{
+    std::vector<ReuseTableEntry> old_entries;
+    old_entries.swap(table.entries);
+    table.log2_size++;
+    table.entries.assign(1ULL << table.log2_size, ReuseTableEntry());
+    uint64_t mask = table.entries.size() - 1;
+    for (uint64_t i = 0; i < old_entries.size(); ++i)
+    {
+        if (old_entries[i].key_plus_one == 0)
+        {
+            continue;
+        }
+        uint64_t slot = reuse_table_slot(table, old_entries[i].key_plus_one - 1);
+        while (table.entries[slot].key_plus_one != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+        table.entries[slot] = old_entries[i];
+    }
+}
+
+/*
+* Function to find the entry of a key, adding a fresh one (time and window 0)
+* if the table does not hold it yet
+*/
+static ReuseTableEntry *reuse_table_find(ReuseTable &table, uint64_t key)
+{
+    uint64_t mask = table.entries.size() - 1;
+    uint64_t slot = reuse_table_slot(table, key);
+    while (true)
+    {
+        ReuseTableEntry *entry = &table.entries[slot];
+        if (entry->key_plus_one == key + 1)
+        {
+            return entry;
+        }
+        if (entry->key_plus_one == 0)
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if ((table.num_keys + 1) * 2 > table.entries.size())
+    {
+        reuse_table_grow(table);
+        return reuse_table_find(table, key);
+    }
+    table.num_keys++;
+    table.entries[slot].key_plus_one = key + 1;
+    return &table.entries[slot];
+}
+
+/*
+* Function to initialize an empty LRU stack
+*/
+static void reuse_stack_init(ReuseStack &stack)
+{
+    reuse_table_init(stack.lines);
+    stack.fenwick.assign(REUSE_INITIAL_CAPACITY + 1, 0);
+    stack.next_time = 1;
+}
+
+/*
+* Function to add delta at a timestamp of the Fenwick tree
+*/
+static void fenwick_add(std::vector<uint32_t> &fenwick, uint64_t time,
+                        int delta)
+{
+    for (uint64_t i = time; i < fenwick.size(); i += i & (~i + 1))
+    {
+        fenwick[i] += delta;
+    }
+}
+
+/*
+* Function to count the marks at timestamps up to and including time
+*/
+static uint64_t fenwick_prefix(const std::vector<uint32_t> &fenwick,
+                               uint64_t time)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = time; i > 0; i -= i & (~i + 1))
+    {
+        sum += fenwick[i];
+    }
+    return sum;
+}
+
+/*
+* Function to renumber the live timestamps of a stack to 1..n once the
+* Fenwick tree runs out of timestamps, doubling it if it is over half live
+*/
+static void reuse_stack_compact(ReuseStack &stack)
+{
+    // Pairs of the last access time and the entry of each line
+    std::vector<std::pair<uint64_t, uint64_t>> by_time;
+    by_time.reserve(stack.lines.num_keys);
+    for (uint64_t i = 0; i < stack.lines.entries.size(); ++i)
+    {
+        if (stack.lines.entries[i].key_plus_one != 0)
+        {
+            by_time.push_back(std::make_pair(stack.lines.entries[i].time, i));
+        }
+    }
+    std::sort(by_time.begin(), by_time.end());
+
+    uint64_t capacity = stack.fenwick.size() - 1;
+    if (by_time.size() * 2 > capacity)
+    {
+        capacity *= 2;
+    }
+    stack.fenwick.assign(capacity + 1, 0);
+
+    for (uint64_t i = 0; i < by_time.size(); ++i)
+    {
+        stack.lines.entries[by_time[i].second].time = i + 1;
+        stack.fenwick[i + 1] = 1;
+    }
+    // Build the tree in place in linear time
+    for (uint64_t i = 1; i <= capacity; ++i)
+    {
+        uint64_t parent = i + (i & (~i + 1));
+        if (parent <= capacity)
+        {
+            stack.fenwick[parent] += stack.fenwick[i];
+        }
+    }
+    stack.next_time = by_time.size() + 1;
+}
+
+/*
+* Function to access a line in a stack and add its distance to a histogram
+ * @param stack The LRU stack.
+ * @param line The line address.
+ * @param hist The histogram to update.
+ * @return The table entry of the line.
+*/
+static ReuseTableEntry *reuse_stack_access(ReuseStack &stack, uint64_t line,
+                                           ReuseHistogram &hist)
+{
+    if (stack.next_time >= stack.fenwick.size())
+    {
+        reuse_stack_compact(stack);
+    }
+    uint64_t now = stack.next_time++;
+
+    hist.accesses++;
+    ReuseTableEntry *entry = reuse_table_find(stack.lines, line);
+    if (entry->time == 0)
+    {
+        hist.cold++;
+        entry->time = now;
+        fenwick_add(stack.fenwick, now, 1);
+        return entry;
+    }
+
+    // Every line whose last access is after this line's previous access has
+    // been accessed since, so it sits above this line in the LRU stack.
+    uint64_t previous = entry->time;
+    uint64_t distance = stack.lines.num_keys -
+                        fenwick_prefix(stack.fenwick, previous);
+
+    unsigned int bucket = 0;
+    while (distance >> bucket)
+    {
+        bucket++;
+    }
+    if (bucket >= REUSE_NUM_BUCKETS)
+    {
+        bucket = REUSE_NUM_BUCKETS - 1;
+    }
+    hist.buckets[bucket]++;
+
+    fenwick_add(stack.fenwick, previous, -1);
+    fenwick_add(stack.fenwick, now, 1);
+    entry->time = now;
+    return entry;
+}
+
+/**
+ * Allocate and initialize a reuse analyzer.
+ *
+ * @param line_size The number of bytes in a cache line.
+ * @param page_size The number of bytes in a page.
+ * @param window_size The number of instructions per working-set window.
+ * @return A pointer to the reuse analyzer.
+ */
+ReuseAnalyzer *reuse_new(uint64_t line_size, uint64_t page_size,
+                         uint64_t window_size)
+{
+    ReuseAnalyzer *ra = new ReuseAnalyzer;
+    ra->line_size = line_size;
+    ra->page_size = page_size;
+    reuse_stack_init(ra->istack);
+    reuse_stack_init(ra->dstack);
+    reuse_stack_init(ra->ustack);
+    memset(ra->hist, 0, sizeof(ra->hist));
+    memset(&ra->unified_hist, 0, sizeof(ra->unified_hist));
+    ra->window_size = window_size;
+    ra->window_insts = 0;
+    ra->window = 1;
+    reuse_table_init(ra->pages);
+    ra->window_lines = 0;
+    ra->window_pages = 0;
+    ra->stat_insts = 0;
+    return ra;
+}
+
+/*
+* Function to analyze a single access
+*/
+static void reuse_access(ReuseAnalyzer *ra, uint64_t addr, AccessType type)
+{
+    uint64_t line = addr / ra->line_size;
+    ReuseStack &split_stack = (type == ACCESS_TYPE_IFETCH) ? ra->istack
+                                                           : ra->dstack;
+    reuse_stack_access(split_stack, line, ra->hist[type]);
+    ReuseTableEntry *entry = reuse_stack_access(ra->ustack, line,
+                                                ra->unified_hist);
+
+    // Only the first touch of a line in a window can touch a new page
+    if (entry->window != ra->window)
+    {
+        entry->window = ra->window;
+        ra->window_lines++;
+        ReuseTableEntry *page = reuse_table_find(ra->pages,
+                                                 addr / ra->page_size);
+        if (page->window != ra->window)
+        {
+            page->window = ra->window;
+            ra->window_pages++;
+        }
+    }
+}
+
+/**
+ * Analyze the accesses of one trace record: its instruction fetch and, for a
+ * load or store, its data access.
+ *
+ * @param ra The reuse analyzer.
+ * @param inst_addr The address of the instruction.
+ * @param inst_type The type of the instruction (an InstType).
+ * @param ldst_addr The data address of a load or store.
+ */
+void reuse_record_inst(ReuseAnalyzer *ra, uint64_t inst_addr,
+                       uint64_t inst_type, uint64_t ldst_addr)
+{
+    ra->stat_insts++;
+    reuse_access(ra, inst_addr, ACCESS_TYPE_IFETCH);
+    if (inst_type == INST_TYPE_LOAD)
+    {
+        reuse_access(ra, ldst_addr, ACCESS_TYPE_LOAD);
+    }
+    if (inst_type == INST_TYPE_STORE)
+    {
+        reuse_access(ra, ldst_addr, ACCESS_TYPE_STORE);
+    }
+
+    if (++ra->window_insts == ra->window_size)
+    {
+        ra->window_line_counts.push_back(ra->window_lines);
+        ra->window_page_counts.push_back(ra->window_pages);
+        ra->window_lines = 0;
+        ra->window_pages = 0;
+        ra->window_insts = 0;
+        ra->window++;
+    }
+}
+
+/*
+* Function to get the number of hits of a fully associative LRU cache holding
+* 2^log2_lines lines
+*/
+static unsigned long long reuse_hits(const ReuseHistogram &hist,
+                                     unsigned int log2_lines)
+{
+    unsigned long long hits = 0;
+    for (unsigned int b = 0; b <= log2_lines && b < REUSE_NUM_BUCKETS; ++b)
+    {
+        hits += hist.buckets[b];
+    }
+    return hits;
+}
+
+/*
+* Function to get a hit rate in percent
+*/
+static double reuse_percent(unsigned long long hits, unsigned long long total)
+{
+    if (total == 0)
+    {
+        return 0.0;
+    }
+    return 100.0 * (double)hits / (double)total;
+}
+
+/**
+ * Print the reuse-distance histograms, the hit rates of fully associative LRU
+ * caches of power-of-two sizes and the working-set sizes per window.
+ *
+ * @param ra The reuse analyzer.
+ * @param label A label for the trace, printed in the table headers.
+ */
+void reuse_print_stats(ReuseAnalyzer *ra, const char *label)
+{
+    const ReuseHistogram *hists[4] = {&ra->hist[ACCESS_TYPE_IFETCH],
+                                      &ra->hist[ACCESS_TYPE_LOAD],
+                                      &ra->hist[ACCESS_TYPE_STORE],
+                                      &ra->unified_hist};
+
+    unsigned int last_bucket = 0;
+    for (unsigned int h = 0; h < 4; ++h)
+    {
+        for (unsigned int b = 0; b < REUSE_NUM_BUCKETS; ++b)
+        {
+            if (hists[h]->buckets[b] && b > last_bucket)
+            {
+                last_bucket = b;
+            }
+        }
+    }
+
+    printf("\n");
+    printf("REUSE_INST             \t\t : %10llu\n", ra->stat_insts);
+    printf("REUSE_IFETCH_ACCESS    \t\t : %10llu\n", hists[0]->accesses);
+    printf("REUSE_LOAD_ACCESS      \t\t : %10llu\n", hists[1]->accesses);
+    printf("REUSE_STORE_ACCESS     \t\t : %10llu\n", hists[2]->accesses);
+    printf("REUSE_IFETCH_LINES     \t\t : %10llu\n",
+           (unsigned long long)ra->istack.lines.num_keys);
+    printf("REUSE_DATA_LINES       \t\t : %10llu\n",
+           (unsigned long long)ra->dstack.lines.num_keys);
+
+    // IFETCH distances are within the instruction stream, LOAD and STORE
+    // distances within the data stream, as seen by split L1 caches.
+    printf("\n");
+    printf("REUSE DISTANCE HISTOGRAM (%s, in %llu B lines)\n", label,
+           (unsigned long long)ra->line_size);
+    printf("%23s %12s %12s %12s %12s\n", "DISTANCE", "IFETCH", "LOAD",
+           "STORE", "UNIFIED");
+    for (unsigned int b = 0; b <= last_bucket; ++b)
+    {
+        unsigned long long lo = (b == 0) ? 0 : (1ULL << (b - 1));
+        unsigned long long hi = (b == 0) ? 0 : (1ULL << b) - 1;
+        printf("%11llu - %-9llu %12llu %12llu %12llu %12llu\n", lo, hi,
+               hists[0]->buckets[b], hists[1]->buckets[b],
+               hists[2]->buckets[b], hists[3]->buckets[b]);
+    }
+    printf("%23s %12llu %12llu %12llu %12llu\n", "COLD", hists[0]->cold,
+           hists[1]->cold, hists[2]->cold, hists[3]->cold);
+
+    // A fully associative LRU cache of 2^k lines hits on every distance
+    // below 2^k, i.e., on buckets 0 through k.
+    printf("\n");
+    printf("FULLY ASSOCIATIVE LRU HIT RATE (%s)\n", label);
+    printf("%12s %12s %12s %12s %12s\n", "SIZE_KB", "IFETCH_PERC",
+           "LOAD_PERC", "STORE_PERC", "UNIFIED_PERC");
+    unsigned int first_log2_lines = 0;
+    while ((ra->line_size << first_log2_lines) < 1024)
+    {
+        first_log2_lines++;
+    }
+    for (unsigned int k = first_log2_lines; k <= last_bucket + 1; ++k)
+    {
+        unsigned long long size_kb = (ra->line_size << k) / 1024;
+        printf("%12llu", size_kb);
+        for (unsigned int h = 0; h < 4; ++h)
+        {
+            printf(" %12.3f", reuse_percent(reuse_hits(*hists[h], k),
+                                            hists[h]->accesses));
+        }
+        printf("\n");
+    }
+
+    // Working set per window of instructions, with the partial window at the
+    // end of the trace last
+    std::vector<uint64_t> lines = ra->window_line_counts;
+    std::vector<uint64_t> pages = ra->window_page_counts;
+    if (ra->window_insts > 0)
+    {
+        lines.push_back(ra->window_lines);
+        pages.push_back(ra->window_pages);
+    }
+    printf("\n");
+    printf("WORKING SET (%s, per %llu instructions)\n", label,
+           (unsigned long long)ra->window_size);
+    printf("%8s %14s %12s %12s %12s\n", "WINDOW", "START_INST", "INSTS",
+           "LINES_KB", "PAGES");
+    for (unsigned int w = 0; w < lines.size(); ++w)
+    {
+        uint64_t insts = ra->window_size;
+        if (w == ra->window_line_counts.size())
+        {
+            insts = ra->window_insts;
+        }
+        printf("%8u %14llu %12llu %12llu %12llu\n", w,
+               (unsigned long long)w * ra->window_size,
+               (unsigned long long)insts,
+               (unsigned long long)(lines[w] * ra->line_size / 1024),
+               (unsigned long long)pages[w]);
+    }
+
+    // A shorter partial window would pull the average down, so it only
+    // counts when there is no complete window
+    uint64_t num_summarized = ra->window_line_counts.size();
+    if (num_summarized == 0)
+    {
+        num_summarized = lines.size();
+    }
+    uint64_t max_lines = 0, sum_lines = 0;
+    for (unsigned int w = 0; w < num_summarized; ++w)
+    {
+        max_lines = std::max(max_lines, lines[w]);
+        sum_lines += lines[w];
+    }
+    double avg_kb = 0.0;
+    if (num_summarized > 0)
+    {
+        avg_kb = (double)sum_lines * ra->line_size / 1024.0 / num_summarized;
+    }
+    printf("REUSE_WSET_AVG_KB      \t\t : %10.3f\n", avg_kb);
+    printf("REUSE_WSET_MAX_KB      \t\t : %10llu\n",
+           (unsigned long long)(max_lines * ra->line_size / 1024));
+}
@@ -0,0 +1,227 @@
+// reuse.h
+// Contains declarations of data structures and functions used to compute
+// reuse-distance histograms and working-set sizes of a memory trace.
+
+#ifndef __REUSE_H__
+#define __REUSE_H__
+
+#include "types.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The number of power-of-two reuse distance buckets. Bucket 0 holds distance
+ * 0 and bucket b holds distances in [2^(b-1), 2^b).
+ */
+#define REUSE_NUM_BUCKETS 40
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* An entry of a flat line or page table
+*/
+typedef struct ReuseTableEntry
+{
+    /*
+    * Line or page number plus one, or 0 if the entry is free
+    */
+    uint64_t key_plus_one;
+
+    /*
+    * Timestamp of the last access, for the LRU stacks
+    */
+    uint64_t time;
+
+    /*
+    * Working-set window of the last access, counted from 1
+    */
+    uint64_t window;
+
+} ReuseTableEntry;
+
+/*
+* An open-addressing hash table with linear probing, holding every line or
+* page seen in one flat array; entries are never removed
+*/
+typedef struct ReuseTable
+{
+    /*
+    * Entries, a power-of-two number of them, kept at most half full
+    */
+    std::vector<ReuseTableEntry> entries;
+
+    /*
+    * log2 of the number of entries
+    */
+    unsigned int log2_size;
+
+    /*
+    * Number of keys held
+    */
+    uint64_t num_keys;
+
+} ReuseTable;
+
+/*
+* An LRU stack that reports the exact stack (reuse) distance of each access,
+* i.e., the number of distinct lines accessed since the previous access to
+* the same line
+*/
+typedef struct ReuseStack
+{
+    /*
+    * Timestamp of the last access to each line
+    */
+    ReuseTable lines;
+
+    /*
+    * Fenwick tree over timestamps, holding 1 at the last access time of
+    * every line
+    */
+    std::vector<uint32_t> fenwick;
+
+    /*
+    * Timestamp to give the next access (timestamps start at 1)
+    */
+    uint64_t next_time;
+
+} ReuseStack;
+
+/*
+* A histogram of reuse distances
+*/
+typedef struct ReuseHistogram
+{
+    /*
+    * Number of accesses per distance bucket
+    */
+    unsigned long long buckets[REUSE_NUM_BUCKETS];
+
+    /*
+    * Number of first accesses to a line (infinite distance)
+    */
+    unsigned long long cold;
+
+    /*
+    * Total number of accesses
+    */
+    unsigned long long accesses;
+
+} ReuseHistogram;
+
+/**
+ * A reuse-distance and working-set analyzer of one trace.
+ *
+ * Distances are exact, so every access costs a hash table probe and a few
+ * Fenwick tree updates per stack. On traces whose lines do not fit in the host
+ * caches these miss, which bounds the analysis at a few million accesses per
+ * second.
+ */
+typedef struct ReuseAnalyzer
+{
+    /*
+    * Number of bytes in a cache line
+    */
+    uint64_t line_size;
+
+    /*
+    * Number of bytes in a page
+    */
+    uint64_t page_size;
+
+    /*
+    * LRU stacks of the instruction stream, the data stream and both streams
+    */
+    ReuseStack istack;
+    ReuseStack dstack;
+    ReuseStack ustack;
+
+    /*
+    * Histograms per access type, indexed by AccessType
+    */
+    ReuseHistogram hist[3];
+
+    /*
+    * Histogram of the unified stream
+    */
+    ReuseHistogram unified_hist;
+
+    /*
+    * Number of instructions per working-set window
+    */
+    uint64_t window_size;
+
+    /*
+    * Number of instructions seen in the current window, and the number of
+    * the current window, counted from 1
+    */
+    uint64_t window_insts;
+    uint64_t window;
+
+    /*
+    * Pages seen so far, with the last window each was touched in; a line
+    * touched in a window is found from the window stamp of its unified
+    * stack entry instead
+    */
+    ReuseTable pages;
+
+    /*
+    * Distinct lines and pages of the current window
+    */
+    uint64_t window_lines;
+    uint64_t window_pages;
+
+    /*
+    * Distinct lines and pages of each completed window
+    */
+    std::vector<uint64_t> window_line_counts;
+    std::vector<uint64_t> window_page_counts;
+
+    /** The total number of instructions analyzed. */
+    unsigned long long stat_insts;
+} ReuseAnalyzer;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a reuse analyzer.
+ *
+ * @param line_size The number of bytes in a cache line.
+ * @param page_size The number of bytes in a page.
+ * @param window_size The number of instructions per working-set window.
+ * @return A pointer to the reuse analyzer.
+ */
+ReuseAnalyzer *reuse_new(uint64_t line_size, uint64_t page_size,
+                         uint64_t window_size);
+
+/**
+ * Analyze the accesses of one trace record: its instruction fetch and, for a
+ * load or store, its data access.
+ *
+ * @param ra The reuse analyzer.
+ * @param inst_addr The address of the instruction.
+ * @param inst_type The type of the instruction (an InstType).
+ * @param ldst_addr The data address of a load or store.
+ */
+void reuse_record_inst(ReuseAnalyzer *ra, uint64_t inst_addr,
+                       uint64_t inst_type, uint64_t ldst_addr);
+
+/**
+ * Print the reuse-distance histograms, the hit rates of fully associative LRU
+ * caches of power-of-two sizes and the working-set sizes per window, the last
+ * of which may be partial.
+ *
+ * @param ra The reuse analyzer.
+ * @param label A label for the trace, printed in the table headers.
+ */
+void reuse_print_stats(ReuseAnalyzer *ra, const char *label);
+
+#endif // __REUSE_H__
@@ -0,0 +1,219 @@
+// setsample.cpp
+// Defines the functions used to simulate a sample of the sets of a cache and
+// extrapolate its miss rates.
+
+#include "setsample.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The z-score of a two-sided 95% confidence interval. */
+#define SET_SAMPLE_Z95 1.96
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a set sampler, picking the simulated sets at random
+ * (with a fixed seed) so that they do not alias with strided access patterns
+ * or page colors.
+ *
+ * @param num_sets The number of sets in the cache.
+ * @param ratio One in this many sets is simulated.
+ * @return A pointer to the set sampler.
+ */
+SetSampler *set_sampler_new(unsigned int num_sets, unsigned int ratio)
+{
+    SetSampler *ss = new SetSampler;
+    ss->num_sets = num_sets;
+    for (unsigned int core = 0; core < 2; ++core)
+    {
+        ss->sampled_reads[core] = 0;
+        ss->sampled_read_misses[core] = 0;
+        ss->miss_credit[core] = 0.0;
+    }
+    ss->stat_filtered_read = 0;
+    ss->stat_filtered_write = 0;
+
+    unsigned int num_sampled = std::max(1u, num_sets / ratio);
+    std::vector<unsigned int> order(num_sets);
+    for (unsigned int i = 0; i < num_sets; ++i)
+    {
+        order[i] = i;
+    }
+    std::mt19937_64 rng(42);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    ss->slot.assign(num_sets, -1);
+    ss->sampled_sets.assign(num_sampled, SampledSet());
+    for (unsigned int i = 0; i < num_sampled; ++i)
+    {
+        ss->slot[order[i]] = i;
+    }
+    return ss;
+}
+
+/**
+ * Check whether the given set is simulated.
+ *
+ * @param ss The set sampler.
+ * @param set_index The index of the cache set.
+ * @return Whether accesses to the set must be simulated.
+ */
+bool set_sampler_is_sampled(SetSampler *ss, uint64_t set_index)
+{
+    return ss->slot[set_index] >= 0;
+}
+
+/**
+ * Count a simulated access to a sampled set.
+ *
+ * @param ss The set sampler.
+ * @param set_index The index of the (sampled) cache set.
+ * @param is_write Whether the access is a write.
+ * @param hit Whether the access hit.
+ * @param core_id The CPU core ID that made the access.
+ */
+void set_sampler_record(SetSampler *ss, uint64_t set_index, bool is_write,
+                        bool hit, unsigned int core_id)
+{
+    SampledSet &set = ss->sampled_sets[ss->slot[set_index]];
+    if (is_write)
+    {
+        set.write_access++;
+        set.write_miss += !hit;
+        return;
+    }
+    set.read_access++;
+    set.read_miss += !hit;
+    ss->sampled_reads[core_id]++;
+    ss->sampled_read_misses[core_id] += !hit;
+}
+
+/**
+ * Count an access to a set that is not simulated and decide whether to treat
+ * it as a miss, so that the levels below see the traffic they would without
+ * sampling: reads of a core are sent down at the miss rate of its simulated
+ * reads so far, spread evenly rather than at random.
+ *
+ * @param ss The set sampler.
+ * @param is_write Whether the access is a write.
+ * @param core_id The CPU core ID that made the access.
+ * @return Whether the access must be sent to the level below as a miss.
+ */
+bool set_sampler_filter(SetSampler *ss, bool is_write, unsigned int core_id)
+{
+    if (is_write)
+    {
+        ss->stat_filtered_write++;
+        return false;
+    }
+    ss->stat_filtered_read++;
+    if (ss->sampled_reads[core_id] == 0)
+    {
+        return false;
+    }
+
+    ss->miss_credit[core_id] += (double)ss->sampled_read_misses[core_id] /
+                                (double)ss->sampled_reads[core_id];
+    if (ss->miss_credit[core_id] < 1.0)
+    {
+        return false;
+    }
+    ss->miss_credit[core_id] -= 1.0;
+    return true;
+}
+
+/*
+* Function to estimate a miss ratio from the sampled sets and the half-width
+* of its 95% confidence interval
+*
+* The sets are clusters of accesses, so this is the ratio estimator of
+* cluster sampling with the finite population correction.
+*
+ * @param ss The set sampler.
+ * @param is_write Whether to estimate the write (or read) miss ratio.
+ * @param half_width Set to the half-width of the confidence interval.
+ * @return The estimated miss ratio.
+*/
+static double set_sampler_ratio(SetSampler *ss, bool is_write,
+                                double *half_width)
+{
+    double n = (double)ss->sampled_sets.size();
+    double accesses = 0.0;
+    double misses = 0.0;
+    for (const SampledSet &set : ss->sampled_sets)
+    {
+        accesses += is_write ? set.write_access : set.read_access;
+        misses += is_write ? set.write_miss : set.read_miss;
+    }
+
+    *half_width = 0.0;
+    if (accesses == 0.0)
+    {
+        return 0.0;
+    }
+    double ratio = misses / accesses;
+    if (n < 2.0)
+    {
+        return ratio;
+    }
+
+    double residuals = 0.0;
+    for (const SampledSet &set : ss->sampled_sets)
+    {
+        double a = is_write ? set.write_access : set.read_access;
+        double m = is_write ? set.write_miss : set.read_miss;
+        residuals += (m - ratio * a) * (m - ratio * a);
+    }
+    double mean_accesses = accesses / n;
+    double fpc = 1.0 - n / (double)ss->num_sets;
+    double variance = fpc * (residuals / (n - 1.0)) /
+                      (n * mean_accesses * mean_accesses);
+    *half_width = SET_SAMPLE_Z95 * sqrt(variance);
+    return ratio;
+}
+
+/**
+ * Print the miss counts and rates extrapolated from the sampled sets to the
+ * whole cache, with 95% confidence intervals.
+ *
+ * @param ss The set sampler.
+ * @param header A label for the cache, used as a prefix for each statistic.
+ */
+void set_sampler_print_stats(SetSampler *ss, const char *header)
+{
+    unsigned long long read_access = ss->stat_filtered_read;
+    unsigned long long write_access = ss->stat_filtered_write;
+    for (const SampledSet &set : ss->sampled_sets)
+    {
+        read_access += set.read_access;
+        write_access += set.write_access;
+    }
+
+    double read_ci, write_ci;
+    double read_ratio = set_sampler_ratio(ss, false, &read_ci);
+    double write_ratio = set_sampler_ratio(ss, true, &write_ci);
+
+    printf("\n");
+    printf("%s_SAMPLED_SETS    \t\t : %10u\n", header,
+           (unsigned int)ss->sampled_sets.size());
+    printf("%s_EST_READ_ACCESS \t\t : %10llu\n", header, read_access);
+    printf("%s_EST_WRITE_ACCESS \t : %10llu\n", header, write_access);
+    printf("%s_EST_READ_MISS   \t\t : %10.0f +- %.0f\n", header,
+           read_ratio * read_access, read_ci * read_access);
+    printf("%s_EST_WRITE_MISS  \t\t : %10.0f +- %.0f\n", header,
+           write_ratio * write_access, write_ci * write_access);
+    printf("%s_EST_READ_MISS_PERC \t : %10.3f +- %.3f\n", header,
+           100.0 * read_ratio, 100.0 * read_ci);
+    printf("%s_EST_WRITE_MISS_PERC \t : %10.3f +- %.3f\n", header,
+           100.0 * write_ratio, 100.0 * write_ci);
+}
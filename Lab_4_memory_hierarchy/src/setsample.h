@@ -0,0 +1,132 @@
+// setsample.h
+// Contains declarations of data structures and functions used to simulate a
+// sample of the sets of a cache and extrapolate its miss rates.
+
+#ifndef __SETSAMPLE_H__
+#define __SETSAMPLE_H__
+
+#include "types.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* The accesses and misses seen by one sampled set
+*/
+typedef struct SampledSet
+{
+    /*
+    * Number of read and write accesses to the set
+    */
+    unsigned long long read_access;
+    unsigned long long write_access;
+
+    /*
+    * Number of read and write misses of the set
+    */
+    unsigned long long read_miss;
+    unsigned long long write_miss;
+
+} SampledSet;
+
+/** A sampler that simulates one in every ratio sets of a cache. */
+typedef struct SetSampler
+{
+    /*
+    * Number of sets in the cache
+    */
+    unsigned int num_sets;
+
+    /*
+    * Slot of each set in sampled_sets, or -1 if the set is not simulated
+    */
+    std::vector<int> slot;
+
+    /*
+    * Per-set counters of the simulated sets
+    */
+    std::vector<SampledSet> sampled_sets;
+
+    /*
+    * Number of simulated reads and read misses of each core, whose ratio is
+    * the rate at which the reads of that core to other sets are sent to the
+    * level below as misses
+    */
+    unsigned long long sampled_reads[2];
+    unsigned long long sampled_read_misses[2];
+
+    /*
+    * Fractional misses of each core owed to the level below; a filtered read
+    * is sent down as a miss whenever a whole one has built up
+    */
+    double miss_credit[2];
+
+    /** The number of reads to sets that are not simulated. */
+    unsigned long long stat_filtered_read;
+
+    /** The number of writes to sets that are not simulated. */
+    unsigned long long stat_filtered_write;
+} SetSampler;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a set sampler, picking the simulated sets at random
+ * (with a fixed seed) so that they do not alias with strided access patterns
+ * or page colors.
+ *
+ * @param num_sets The number of sets in the cache.
+ * @param ratio One in this many sets is simulated.
+ * @return A pointer to the set sampler.
+ */
+SetSampler *set_sampler_new(unsigned int num_sets, unsigned int ratio);
+
+/**
+ * Check whether the given set is simulated.
+ *
+ * @param ss The set sampler.
+ * @param set_index The index of the cache set.
+ * @return Whether accesses to the set must be simulated.
+ */
+bool set_sampler_is_sampled(SetSampler *ss, uint64_t set_index);
+
+/**
+ * Count a simulated access to a sampled set.
+ *
+ * @param ss The set sampler.
+ * @param set_index The index of the (sampled) cache set.
+ * @param is_write Whether the access is a write.
+ * @param hit Whether the access hit.
+ * @param core_id The CPU core ID that made the access.
+ */
+void set_sampler_record(SetSampler *ss, uint64_t set_index, bool is_write,
+                        bool hit, unsigned int core_id);
+
+/**
+ * Count an access to a set that is not simulated and decide whether to treat
+ * it as a miss, so that the levels below see the traffic they would without
+ * sampling: reads of a core are sent down at the miss rate of its simulated
+ * reads so far, spread evenly rather than at random.
+ *
+ * @param ss The set sampler.
+ * @param is_write Whether the access is a write.
+ * @param core_id The CPU core ID that made the access.
+ * @return Whether the access must be sent to the level below as a miss.
+ */
+bool set_sampler_filter(SetSampler *ss, bool is_write, unsigned int core_id);
+
+/**
+ * Print the miss counts and rates extrapolated from the sampled sets to the
+ * whole cache, with 95% confidence intervals.
+ *
+ * @param ss The set sampler.
+ * @param header A label for the cache, used as a prefix for each statistic.
+ */
+void set_sampler_print_stats(SetSampler *ss, const char *header);
+
+#endif // __SETSAMPLE_H__
@@ -9,10 +9,19 @@
 #include "types.h"
 #include "memsys.h"
 #include "core.h"
+#include "checkpoint.h"
+#include "reuse.h"
+#include "simpoint.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <strings.h>
+#include <algorithm>
 #include <iostream>
+#include <vector>
+#include <string>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #define MAX_CORES 2
 #define PRINT_DOTS 1
@@ -51,6 +60,51 @@ uint64_t L2CACHE_ASSOC = 16;
 /** The replacement policy to use for the L2 cache. */
 ReplacementPolicy L2CACHE_REPL = LRU;
 
+/** The hit time of the L2 cache in cycles. */
+uint64_t L2CACHE_LATENCY = 10;
+
+/**
+ * Whether each core has a private L2 cache in parts D, E, and F, instead of
+ * one L2 cache shared by both cores.
+ */
+bool L2_PRIVATE = false;
+
+/** The size of the shared L3 cache in bytes, or 0 for no L3 cache. */
+uint64_t L3CACHE_SIZE = 0;
+
+/** The associativity of the L3 cache. */
+uint64_t L3CACHE_ASSOC = 16;
+
+/** The replacement policy to use for the L3 cache. */
+ReplacementPolicy L3CACHE_REPL = LRU;
+
+/** The hit time of the L3 cache in cycles, from the nearest bank. */
+uint64_t L3CACHE_LATENCY = 30;
+
+/**
+ * The number of NUCA banks of the L3 cache, interleaved by line address. 1
+ * gives a uniform access latency.
+ */
+unsigned int L3_NUM_BANKS = 1;
+
+/** The extra cycles per bank crossed to reach an L3 bank. */
+uint64_t L3_BANK_HOP_LATENCY = 2;
+
+/**
+ * One in this many L2 sets is simulated, and the L2 miss rates are
+ * extrapolated from them. 1 simulates every set.
+ */
+unsigned int L2_SAMPLE_RATIO = 1;
+
+/** Whether the L2 cache is compressed. */
+bool L2_COMPRESSION = false;
+
+/**
+ * The file giving the compressed size of specific L2 lines, or NULL to size
+ * every line with the synthetic model.
+ */
+const char *L2_COMPRESS_SIZES_FILE = NULL;
+
 /**
  * For static way partitioning, the quota of ways in each set that can be
  * assigned to core 0.
@@ -67,6 +121,120 @@ unsigned int NUM_CORES = 0;
 /** Which page policy the DRAM should use. */
 DRAMPolicy DRAM_PAGE_POLICY = OPEN_PAGE;
 
+/** The idle cycles after which the timeout page policy closes a row. */
+uint64_t DRAM_ROW_TIMEOUT = 200;
+
+/** Whether DRAM accesses wait for refreshes and the tRRD and tFAW limits. */
+bool DRAM_TIMING = false;
+
+/**
+ * Whether to run each trace alone and then both traces together under every
+ * L2 replacement policy and SWP quota, and print a table of the slowdowns.
+ */
+bool PARTITION_SWEEP = false;
+
+/** The DRAM bandwidth cap of each core in GB/s, or 0 if uncapped. */
+double DRAM_CORE_BW_CAP[2] = {0, 0};
+
+/**
+ * The IPC of each trace when run alone, to compute the slowdowns of the cores
+ * in a shared run, or 0 if unknown.
+ */
+double ALONE_IPC[2] = {0, 0};
+
+/** Whether to print the DRAM bandwidth, locality and energy statistics. */
+bool DRAM_POWER_STATS = false;
+
+/** Whether address translation is simulated with TLBs in parts D, E, and F. */
+bool ENABLE_TLB = false;
+
+/** Whether the TLBs and page tables use 2 MB huge pages. */
+bool ENABLE_HUGE_PAGES = false;
+
+/** The number of entries in each L1 instruction and data TLB. */
+uint64_t L1TLB_ENTRIES = 64;
+
+/** The associativity of the L1 instruction and data TLBs. */
+uint64_t L1TLB_ASSOC = 4;
+
+/** The number of entries in the shared L2 TLB. */
+uint64_t L2TLB_ENTRIES = 1024;
+
+/** The associativity of the shared L2 TLB. */
+uint64_t L2TLB_ASSOC = 8;
+
+/**
+ * Whether to only analyze the reuse distances and working sets of the traces
+ * instead of simulating them.
+ */
+bool REUSE_ANALYSIS = false;
+
+/** The number of instructions per working-set window of the reuse analysis. */
+uint64_t REUSE_WINDOW = 1000000;
+
+/**
+ * The largest number of SimPoints to simulate instead of the whole trace, or 0
+ * to simulate the whole trace. Only single-core modes are sampled.
+ */
+unsigned int SIMPOINT_MAX_K = 0;
+
+/** The number of instructions in each SimPoint interval. */
+uint64_t SIMPOINT_INTERVAL = 100000;
+
+/**
+ * The number of instructions before each SimPoint whose memory accesses warm
+ * up the caches without being timed.
+ */
+uint64_t SIMPOINT_WARMUP = 1000000;
+
+/**
+ * Whether to also simulate the whole trace and print the error of the
+ * SimPoint estimates.
+ */
+bool SIMPOINT_VALIDATE = false;
+
+/**
+ * The number of instructions of each trace whose memory accesses warm up the
+ * caches before timing starts, with all statistics cleared afterwards.
+ */
+uint64_t WARMUP_INSTS = 0;
+
+/** The checkpoint file to save the simulation to, or NULL to not save one. */
+const char *CHECKPOINT_SAVE_FILE = NULL;
+
+/**
+ * The cycle, counted from the end of any warm-up, at which the simulation is
+ * saved and stopped.
+ */
+uint64_t CHECKPOINT_CYCLE = 0;
+
+/**
+ * The checkpoint file to restore the simulation from instead of starting at
+ * the beginning of the traces, or NULL to start from the beginning.
+ */
+const char *CHECKPOINT_RESTORE_FILE = NULL;
+
+/**
+ * The number of instruction addresses and pages tracked by the hot-spot
+ * profiler for each access type, or 0 if profiling is disabled.
+ */
+unsigned int PROFILE_TOPK = 0;
+
+/** The number of rows printed per hot-spot profiler table. */
+unsigned int PROFILE_REPORT_ROWS = 20;
+
+/** How physical frames are allocated to virtual pages in parts D, E, and F. */
+PageAllocPolicy PAGE_ALLOC_POLICY = PAGE_ALLOC_FIXED;
+
+/** The size of physical memory in bytes, used by the page allocator. */
+uint64_t PHYS_MEM_SIZE = 4096ULL * 1024 * 1024;
+
+/**
+ * For the page coloring policies, the number of colors given to core 0, or 0
+ * to split the colors evenly between the cores.
+ */
+unsigned int COLOR_CORE0_COLORS = 0;
+
 /**
  * The current clock cycle number.
  * 
@@ -79,9 +247,22 @@ Core *core[MAX_CORES];
 const char *trace_filename[MAX_CORES];
 uint64_t last_printdot_cycle;
 
+/**
+ * In the partitioning sweep, the only core whose trace is simulated, with the
+ * other core idle from the start, or -1 to simulate every core.
+ */
+int alone_core = -1;
+
 int parse_args(int argc, char **argv);
+int run_reuse_analysis();
+int run_simulation();
+int run_warmup();
+int run_simpoints();
+int run_partition_sweep();
 void print_dots();
 void print_stats();
+void print_slowdowns(const double *alone_ipc, const double *shared_ipc,
+                     unsigned int num_cores);
 void print_usage(const char *program_name);
 
 int main(int argc, char **argv)
@@ -92,11 +273,59 @@ int main(int argc, char **argv)
         return status;
     }
 
+    if (REUSE_ANALYSIS)
+    {
+        return run_reuse_analysis();
+    }
+
+    if (SIMPOINT_MAX_K)
+    {
+        return run_simpoints();
+    }
+
+    if (PARTITION_SWEEP)
+    {
+        return run_partition_sweep();
+    }
+
+    status = run_simulation();
+    if (status != 0 || CHECKPOINT_SAVE_FILE)
+    {
+        return status;
+    }
+
+    print_stats();
+    return 0;
+}
+
+/**
+ * Simulate every trace to the end on a new memory system, starting from the
+ * beginning (after any functional warm-up) or from a checkpoint. When a
+ * checkpoint is to be saved, stop at the checkpoint cycle instead.
+ */
+int run_simulation()
+{
     srand(42);
+    current_cycle = 0;
     memsys = memsys_new();
     for (unsigned int i = 0; i < NUM_CORES; i++)
     {
         core[i] = core_new(memsys, trace_filename[i], i);
+        if (alone_core >= 0 && (int)i != alone_core)
+        {
+            core[i]->done = true;
+        }
+    }
+
+    if (CHECKPOINT_RESTORE_FILE &&
+        !checkpoint_restore(CHECKPOINT_RESTORE_FILE, memsys, core, NUM_CORES))
+    {
+        return 1;
+    }
+
+    if (WARMUP_INSTS && run_warmup() != 0)
+    {
+        return 1;
     }
 
     print_dots();
@@ -105,6 +334,20 @@ int main(int argc, char **argv)
     bool all_cores_done = false;
     while (!all_cores_done)
     {
+        uint64_t timed_cycles = current_cycle - core[0]->start_cycle;
+        if (CHECKPOINT_SAVE_FILE && timed_cycles == CHECKPOINT_CYCLE)
+        {
+            if (!checkpoint_save(CHECKPOINT_SAVE_FILE, memsys, core,
+                                 NUM_CORES))
+            {
+                return 1;
+            }
+            printf("\n\n");
+            printf("CHECKPOINT_CYCLE    \t\t : %10llu\n",
+                   (unsigned long long)timed_cycles);
+            return 0;
+        }
+
         all_cores_done = true;
 
         for (unsigned int i = 0; i < NUM_CORES; i++)
@@ -121,7 +364,36 @@ int main(int argc, char **argv)
         current_cycle++;
     }
 
-    print_stats();
+    if (CHECKPOINT_SAVE_FILE)
+    {
+        fprintf(stderr, "Error: the simulation ended before the checkpoint "
+                        "cycle\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Warm up the caches, TLBs and DRAM row buffers with the memory accesses of
+ * the first WARMUP_INSTS instructions of each trace, one instruction per core
+ * per cycle with no stalls, then clear every statistic so that timing starts
+ * from clean counters.
+ */
+int run_warmup()
+{
+    core_warm_insts(core, NUM_CORES, WARMUP_INSTS);
+
+    for (unsigned int i = 0; i < NUM_CORES; i++)
+    {
+        if (core[i]->done && (alone_core < 0 || (int)i == alone_core))
+        {
+            fprintf(stderr, "Error: trace %s ended during the warm-up\n",
+                    trace_filename[i]);
+            return 1;
+        }
+        core[i]->start_cycle = current_cycle;
+    }
+    memsys_clear_stats(memsys);
     return 0;
 }
 
@@ -249,6 +521,137 @@ int parse_args(int argc, char **argv)
                 L2CACHE_REPL = (ReplacementPolicy)l2repl;
             }
 
+            else if (strcasecmp(argv[i], "-L2assoc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2assoc\n");
+                    return 2;
+                }
+                L2CACHE_ASSOC = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L2latency") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2latency\n");
+                    return 2;
+                }
+                L2CACHE_LATENCY = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-L2private") == 0)
+            {
+                L2_PRIVATE = true;
+            }
+
+            else if (strcasecmp(argv[i], "-L3sizeKB") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L3sizeKB\n");
+                    return 2;
+                }
+                L3CACHE_SIZE = atoi(argv[i]) * 1024;
+            }
+
+            else if (strcasecmp(argv[i], "-L3assoc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L3assoc\n");
+                    return 2;
+                }
+                L3CACHE_ASSOC = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L3repl") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L3repl\n");
+                    return 2;
+                }
+
+                int l3repl = atoi(argv[i]);
+                if (l3repl < 0 || l3repl > 3)
+                {
+                    fprintf(stderr, "Error: L3repl must be between 0 and 3\n");
+                    return 2;
+                }
+
+                L3CACHE_REPL = (ReplacementPolicy)l3repl;
+            }
+
+            else if (strcasecmp(argv[i], "-L3latency") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L3latency\n");
+                    return 2;
+                }
+                L3CACHE_LATENCY = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-L3banks") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L3banks\n");
+                    return 2;
+                }
+                L3_NUM_BANKS = atoi(argv[i]);
+                if (L3_NUM_BANKS < 1)
+                {
+                    fprintf(stderr, "Error: L3banks must be positive\n");
+                    return 2;
+                }
+            }
+
+            else if (strcasecmp(argv[i], "-L3bank_hop") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L3bank_hop\n");
+                    return 2;
+                }
+                L3_BANK_HOP_LATENCY = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-L2sample") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2sample\n");
+                    return 2;
+                }
+                L2_SAMPLE_RATIO = atoi(argv[i]);
+                if (L2_SAMPLE_RATIO < 1)
+                {
+                    fprintf(stderr, "Error: L2sample must be positive\n");
+                    return 2;
+                }
+            }
+
+            else if (strcasecmp(argv[i], "-L2compress") == 0)
+            {
+                L2_COMPRESSION = true;
+            }
+
+            else if (strcasecmp(argv[i], "-L2compress_sizes") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L2compress_sizes\n");
+                    return 2;
+                }
+                L2_COMPRESSION = true;
+                L2_COMPRESS_SIZES_FILE = argv[i];
+            }
+
             else if (strcasecmp(argv[i], "-SWP_core0ways") == 0)
             {
                 if (++i >= argc)
@@ -270,48 +673,831 @@ int parse_args(int argc, char **argv)
                 }
 
                 int dram_policy = atoi(argv[i]);
-                if (dram_policy < 0 || dram_policy > 1)
+                if (dram_policy < 0 || dram_policy > 4)
                 {
-                    fprintf(stderr, "Error: dram_policy must be between 0 and 1\n");
+                    fprintf(stderr, "Error: dram_policy must be between 0 and 4\n");
                     return 2;
                 }
 
                 DRAM_PAGE_POLICY = (DRAMPolicy)dram_policy;
             }
 
-            else
+            else if (strcasecmp(argv[i], "-dram_timeout") == 0)
             {
-                fprintf(stderr, "Error: unrecognized option: %s\n", argv[i]);
-                return 2;
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_timeout\n");
+                    return 2;
+                }
+                DRAM_ROW_TIMEOUT = strtoull(argv[i], NULL, 10);
             }
-        }
-        else
-        {
-            // Parse trace file name.
-            if (NUM_CORES >= MAX_CORES)
+
+            else if (strcasecmp(argv[i], "-dram_bw_cap") == 0 ||
+                     strcasecmp(argv[i], "-alone_ipc") == 0)
             {
-                fprintf(stderr, "Error: too many trace files specified\n");
-                return 2;
+                const char *option = argv[i];
+                if (i + 2 >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to %s\n",
+                            option);
+                    return 2;
+                }
+                int core_id = atoi(argv[++i]);
+                if (core_id < 0 || core_id > 1)
+                {
+                    fprintf(stderr, "Error: core of %s must be 0 or 1\n",
+                            option);
+                    return 2;
+                }
+                double value = atof(argv[++i]);
+                if (strcasecmp(option, "-dram_bw_cap") == 0)
+                {
+                    DRAM_CORE_BW_CAP[core_id] = value;
+                }
+                else
+                {
+                    ALONE_IPC[core_id] = value;
+                }
             }
 
-            trace_filename[NUM_CORES] = argv[i];
-            NUM_CORES++;
-        }
-    }
-
-    if (NUM_CORES == 0)
-    {
-        fprintf(stderr, "Error: no trace file specified\n");
-        return 2;
-    }
+            else if (strcasecmp(argv[i], "-partition_sweep") == 0)
+            {
+                PARTITION_SWEEP = true;
+            }
 
-    return 0;
-}
+            else if (strcasecmp(argv[i], "-dram_timing") == 0)
+            {
+                DRAM_TIMING = true;
+            }
 
-void print_dots()
-{
-    unsigned int LINE_INTERVAL = 50 * DOT_INTERVAL;
-    last_printdot_cycle = current_cycle;
+            else if (strcasecmp(argv[i], "-dram_power") == 0)
+            {
+                DRAM_POWER_STATS = true;
+            }
+
+            else if (strcasecmp(argv[i], "-reuse") == 0)
+            {
+                REUSE_ANALYSIS = true;
+            }
+
+            else if (strcasecmp(argv[i], "-reuse_window") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-reuse_window\n");
+                    return 2;
+                }
+                REUSE_WINDOW = strtoull(argv[i], NULL, 10);
+                if (REUSE_WINDOW == 0)
+                {
+                    fprintf(stderr, "Error: reuse_window must be positive\n");
+                    return 2;
+                }
+            }
+
+            else if (strcasecmp(argv[i], "-simpoint") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -simpoint\n");
+                    return 2;
+                }
+                int max_k = atoi(argv[i]);
+                if (max_k < 1)
+                {
+                    fprintf(stderr, "Error: simpoint must be positive\n");
+                    return 2;
+                }
+                SIMPOINT_MAX_K = max_k;
+            }
+
+            else if (strcasecmp(argv[i], "-simpoint_interval") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-simpoint_interval\n");
+                    return 2;
+                }
+                SIMPOINT_INTERVAL = strtoull(argv[i], NULL, 10);
+                if (SIMPOINT_INTERVAL == 0)
+                {
+                    fprintf(stderr, "Error: simpoint_interval must be "
+                                    "positive\n");
+                    return 2;
+                }
+            }
+
+            else if (strcasecmp(argv[i], "-simpoint_warmup") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-simpoint_warmup\n");
+                    return 2;
+                }
+                SIMPOINT_WARMUP = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-simpoint_validate") == 0)
+            {
+                SIMPOINT_VALIDATE = true;
+            }
+
+            else if (strcasecmp(argv[i], "-warmup") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -warmup\n");
+                    return 2;
+                }
+                WARMUP_INSTS = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-checkpoint_save") == 0)
+            {
+                if (i + 2 >= argc)
+                {
+                    fprintf(stderr, "Error: missing arguments to "
+                                    "-checkpoint_save\n");
+                    return 2;
+                }
+                CHECKPOINT_SAVE_FILE = argv[++i];
+                CHECKPOINT_CYCLE = strtoull(argv[++i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-checkpoint_restore") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-checkpoint_restore\n");
+                    return 2;
+                }
+                CHECKPOINT_RESTORE_FILE = argv[i];
+            }
+
+            else if (strcasecmp(argv[i], "-profile") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -profile\n");
+                    return 2;
+                }
+                PROFILE_TOPK = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-profile_rows") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-profile_rows\n");
+                    return 2;
+                }
+                PROFILE_REPORT_ROWS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-page_alloc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-page_alloc\n");
+                    return 2;
+                }
+
+                int page_alloc = atoi(argv[i]);
+                if (page_alloc < 0 || page_alloc > 4)
+                {
+                    fprintf(stderr, "Error: page_alloc must be between 0 and "
+                                    "4\n");
+                    return 2;
+                }
+
+                PAGE_ALLOC_POLICY = (PageAllocPolicy)page_alloc;
+            }
+
+            else if (strcasecmp(argv[i], "-physmemMB") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-physmemMB\n");
+                    return 2;
+                }
+                PHYS_MEM_SIZE = (uint64_t)atoi(argv[i]) * 1024 * 1024;
+            }
+
+            else if (strcasecmp(argv[i], "-color_core0") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-color_core0\n");
+                    return 2;
+                }
+                COLOR_CORE0_COLORS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-tlb") == 0)
+            {
+                ENABLE_TLB = true;
+            }
+
+            else if (strcasecmp(argv[i], "-hugepages") == 0)
+            {
+                ENABLE_HUGE_PAGES = true;
+            }
+
+            else if (strcasecmp(argv[i], "-L1TLBentries") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L1TLBentries\n");
+                    return 2;
+                }
+                L1TLB_ENTRIES = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L1TLBassoc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L1TLBassoc\n");
+                    return 2;
+                }
+                L1TLB_ASSOC = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L2TLBentries") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L2TLBentries\n");
+                    return 2;
+                }
+                L2TLB_ENTRIES = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L2TLBassoc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L2TLBassoc\n");
+                    return 2;
+                }
+                L2TLB_ASSOC = atoi(argv[i]);
+            }
+
+            else
+            {
+                fprintf(stderr, "Error: unrecognized option: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else
+        {
+            // Parse trace file name.
+            if (NUM_CORES >= MAX_CORES)
+            {
+                fprintf(stderr, "Error: too many trace files specified\n");
+                return 2;
+            }
+
+            trace_filename[NUM_CORES] = argv[i];
+            NUM_CORES++;
+        }
+    }
+
+    if (NUM_CORES == 0)
+    {
+        fprintf(stderr, "Error: no trace file specified\n");
+        return 2;
+    }
+
+    if (PAGE_ALLOC_POLICY != PAGE_ALLOC_FIXED)
+    {
+        uint64_t max_block = (uint64_t)PAGE_SIZE << PAGE_ALLOC_MAX_ORDER;
+        if (PHYS_MEM_SIZE == 0 || PHYS_MEM_SIZE % max_block != 0)
+        {
+            fprintf(stderr, "Error: physmemMB must be a positive multiple of "
+                            "%llu\n",
+                    (unsigned long long)(max_block / (1024 * 1024)));
+            return 2;
+        }
+        if (ENABLE_HUGE_PAGES && (PAGE_ALLOC_POLICY == PAGE_ALLOC_COLOR_L2 ||
+                                  PAGE_ALLOC_POLICY == PAGE_ALLOC_COLOR_BANK))
+        {
+            fprintf(stderr, "Error: a huge page spans every color, so page "
+                            "coloring needs 4 KB pages\n");
+            return 2;
+        }
+        if (COLOR_CORE0_COLORS >= memsys_page_colors() &&
+            (PAGE_ALLOC_POLICY == PAGE_ALLOC_COLOR_L2 ||
+             PAGE_ALLOC_POLICY == PAGE_ALLOC_COLOR_BANK))
+        {
+            fprintf(stderr, "Error: color_core0 must be less than the %u page "
+                            "colors, leaving some to core 1\n",
+                    memsys_page_colors());
+            return 2;
+        }
+    }
+
+    if (WARMUP_INSTS && (CHECKPOINT_RESTORE_FILE || SIMPOINT_MAX_K ||
+                         REUSE_ANALYSIS))
+    {
+        fprintf(stderr, "Error: -warmup only applies to a full timing "
+                        "simulation from the start\n");
+        return 2;
+    }
+
+    if ((CHECKPOINT_SAVE_FILE || CHECKPOINT_RESTORE_FILE) &&
+        (SIMPOINT_MAX_K || REUSE_ANALYSIS))
+    {
+        fprintf(stderr, "Error: checkpoints need a full timing simulation\n");
+        return 2;
+    }
+
+    if (PARTITION_SWEEP && (SIM_MODE != SIM_MODE_DEF || NUM_CORES != 2 ||
+                            CHECKPOINT_SAVE_FILE || CHECKPOINT_RESTORE_FILE ||
+                            SIMPOINT_MAX_K || REUSE_ANALYSIS))
+    {
+        fprintf(stderr, "Error: -partition_sweep needs mode 4 with two "
+                        "traces and a full timing simulation\n");
+        return 2;
+    }
+
+    if (L2_PRIVATE && (SIM_MODE != SIM_MODE_DEF || L2CACHE_REPL == SWP ||
+                       L2CACHE_REPL == DWP || L2_SAMPLE_RATIO > 1 ||
+                       L2_COMPRESSION || PARTITION_SWEEP))
+    {
+        fprintf(stderr, "Error: -L2private needs mode 4, and L2 partitioning, "
+                        "sampling and\n       compression need a shared L2 "
+                        "cache\n");
+        return 2;
+    }
+
+    if (L3CACHE_SIZE && SIM_MODE == SIM_MODE_A)
+    {
+        fprintf(stderr, "Error: mode 1 has no L2 cache to put an L3 cache "
+                        "under\n");
+        return 2;
+    }
+
+    if (L2_COMPRESSION)
+    {
+        ReplacementPolicy l2repl = SIM_MODE == SIM_MODE_DEF ? L2CACHE_REPL
+                                                             : REPL_POLICY;
+        if (SIM_MODE == SIM_MODE_A || l2repl != LRU || PARTITION_SWEEP)
+        {
+            fprintf(stderr, "Error: -L2compress needs an L2 cache with LRU "
+                            "replacement\n");
+            return 2;
+        }
+    }
+
+    if (SIMPOINT_MAX_K && NUM_CORES != 1)
+    {
+        // The intervals are picked from the basic block vectors of one
+        // instruction stream. With two cores the interleaving of the streams
+        // in the shared L2 and DRAM depends on both, so an interval of one
+        // core stands for no fixed part of the other's run.
+        fprintf(stderr, "Error: SimPoint sampling needs a single trace, since "
+                        "the intervals of one core\n");
+        fprintf(stderr, "       do not line up with those of the other core "
+                        "sharing the L2 and DRAM\n");
+        return 2;
+    }
+
+    if (ENABLE_TLB)
+    {
+        uint64_t tlb_entries[2] = {L1TLB_ENTRIES, L2TLB_ENTRIES};
+        uint64_t tlb_assoc[2] = {L1TLB_ASSOC, L2TLB_ASSOC};
+        for (int t = 0; t < 2; t++)
+        {
+            uint64_t sets = tlb_assoc[t] ? tlb_entries[t] / tlb_assoc[t] : 0;
+            if (sets == 0 || sets * tlb_assoc[t] != tlb_entries[t] ||
+                (sets & (sets - 1)) != 0)
+            {
+                fprintf(stderr, "Error: TLB entries / assoc must be a power "
+                                "of two\n");
+                return 2;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Analyze each trace on its own in a single pass, without simulating the
+ * memory system, and print its reuse-distance and working-set report.
+ */
+int run_reuse_analysis()
+{
+    for (unsigned int i = 0; i < NUM_CORES; i++)
+    {
+        Core *trace = core_new(NULL, trace_filename[i], i);
+        if (trace == NULL)
+        {
+            return 1;
+        }
+
+        ReuseAnalyzer *ra = reuse_new(CACHE_LINESIZE, PAGE_SIZE,
+                                      REUSE_WINDOW);
+        while (!trace->done)
+        {
+            reuse_record_inst(ra, trace->trace_inst_addr,
+                              trace->trace_inst_type, trace->trace_ldst_addr);
+            core_read_trace(trace);
+        }
+
+        printf("\n");
+        printf("TRACE_%01u              \t\t : %s\n", i, trace_filename[i]);
+        reuse_print_stats(ra, trace_filename[i]);
+        delete ra;
+    }
+    return 0;
+}
+
+/**
+ * Get the total accesses and misses of a cache so far.
+ */
+static void cache_counts(Cache *c, double *access, double *miss)
+{
+    *access = (double)(c->stat_read_access + c->stat_write_access);
+    *miss = (double)(c->stat_read_miss + c->stat_write_miss);
+}
+
+/**
+ * Pick SimPoints from the basic block vectors of the trace and simulate only
+ * those intervals, each after warming up the memory system with the accesses
+ * of the instructions before it. Print the weighted CPI and miss rates and,
+ * with -simpoint_validate, their error against a simulation of the whole
+ * trace.
+ */
+int run_simpoints()
+{
+    // Profile the basic block vectors of the whole trace. The trace has no
+    // branch types, so basic blocks only end at jumps in the PC.
+    Core *trace = core_new(NULL, trace_filename[0], 0);
+    if (trace == NULL)
+    {
+        return 1;
+    }
+    SimPointProfiler *sp = simpoint_profiler_new(SIMPOINT_INTERVAL);
+    while (!trace->done)
+    {
+        simpoint_profile_inst(sp, trace->trace_inst_addr, false);
+        core_read_trace(trace);
+    }
+
+    std::vector<SimPoint> points = simpoint_pick(sp, SIMPOINT_MAX_K);
+    if (points.empty())
+    {
+        fprintf(stderr, "Error: trace is shorter than one SimPoint "
+                        "interval\n");
+        return 1;
+    }
+
+    // Simulate each SimPoint, warming up on the instructions before it and
+    // skipping the rest of the trace.
+    srand(42);
+    current_cycle = 0;
+    memsys = memsys_new();
+    core[0] = core_new(memsys, trace_filename[0], 0);
+    if (core[0] == NULL)
+    {
+        return 1;
+    }
+
+    std::vector<double> cpis, dcache_access, dcache_miss, l2_access, l2_miss;
+    uint64_t trace_pos = 0;
+    unsigned long long detailed_inst = 0;
+    for (const SimPoint &point : points)
+    {
+        uint64_t start = point.interval * SIMPOINT_INTERVAL;
+        uint64_t warm_start = start > SIMPOINT_WARMUP ? start - SIMPOINT_WARMUP
+                                                      : 0;
+        for (; !core[0]->done && trace_pos < warm_start; trace_pos++)
+        {
+            core_read_trace(core[0]);
+        }
+        if (trace_pos < start)
+        {
+            trace_pos += core_warm_insts(core, 1, start - trace_pos);
+        }
+
+        uint64_t start_cycle = current_cycle;
+        unsigned long long start_inst = core[0]->inst_count;
+        double dcache_access0, dcache_miss0, l2_access0 = 0, l2_miss0 = 0;
+        cache_counts(memsys->dcache, &dcache_access0, &dcache_miss0);
+        if (memsys->l2cache)
+        {
+            cache_counts(memsys->l2cache, &l2_access0, &l2_miss0);
+        }
+
+        while (!core[0]->done &&
+               core[0]->inst_count - start_inst < SIMPOINT_INTERVAL)
+        {
+            core_cycle(core[0]);
+            current_cycle++;
+        }
+        // The interval ends when its last instruction stops stalling.
+        current_cycle = std::max(current_cycle, core[0]->snooze_end_cycle + 1);
+
+        unsigned long long num_inst = core[0]->inst_count - start_inst;
+        trace_pos += num_inst;
+        detailed_inst += num_inst;
+        cpis.push_back(num_inst ? (double)(current_cycle - start_cycle) /
+                                      (double)num_inst
+                                : 0.0);
+
+        double access, miss;
+        cache_counts(memsys->dcache, &access, &miss);
+        dcache_access.push_back(access - dcache_access0);
+        dcache_miss.push_back(miss - dcache_miss0);
+        access = miss = 0;
+        if (memsys->l2cache)
+        {
+            cache_counts(memsys->l2cache, &access, &miss);
+        }
+        l2_access.push_back(access - l2_access0);
+        l2_miss.push_back(miss - l2_miss0);
+    }
+
+    double cpi = simpoint_weighted(points, cpis);
+    double dcache_miss_perc = 100.0 * simpoint_weighted_ratio(
+                                          points, dcache_miss, dcache_access);
+    double l2_miss_perc = 100.0 * simpoint_weighted_ratio(points, l2_miss,
+                                                          l2_access);
+
+    printf("\n");
+    simpoint_print_points(sp, points);
+    printf("%8s %10s %12s %12s\n", "POINT", "CPI", "DCACHE_MISS%",
+           "L2_MISS%");
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        printf("%8lu %10.3f %12.3f %12.3f\n", (unsigned long)i, cpis[i],
+               dcache_access[i] ? 100.0 * dcache_miss[i] / dcache_access[i]
+                                : 0.0,
+               l2_access[i] ? 100.0 * l2_miss[i] / l2_access[i] : 0.0);
+    }
+    printf("\n");
+    printf("SIMPOINT_DETAILED_INST \t\t : %10llu\n", detailed_inst);
+    printf("SIMPOINT_CPI           \t\t : %10.3f\n", cpi);
+    printf("SIMPOINT_DCACHE_MISS_PERC \t : %10.3f\n", dcache_miss_perc);
+    if (memsys->l2cache)
+    {
+        printf("SIMPOINT_L2CACHE_MISS_PERC \t : %10.3f\n", l2_miss_perc);
+    }
+
+    if (!SIMPOINT_VALIDATE)
+    {
+        return 0;
+    }
+
+    if (run_simulation() != 0)
+    {
+        return 1;
+    }
+    print_stats();
+
+    double full_cpi = core[0]->done_inst_count
+                          ? (double)core[0]->done_cycle_count /
+                                (double)core[0]->done_inst_count
+                          : 0.0;
+    double access, miss;
+    cache_counts(memsys->dcache, &access, &miss);
+    double full_dcache_miss_perc = access ? 100.0 * miss / access : 0.0;
+
+    printf("\n");
+    printf("SIMPOINT_CPI_ERR_PERC  \t\t : %10.3f\n",
+           full_cpi ? 100.0 * (cpi - full_cpi) / full_cpi : 0.0);
+    printf("SIMPOINT_DCACHE_MISS_ERR \t : %10.3f\n",
+           dcache_miss_perc - full_dcache_miss_perc);
+    if (memsys->l2cache)
+    {
+        cache_counts(memsys->l2cache, &access, &miss);
+        double full_l2_miss_perc = access ? 100.0 * miss / access : 0.0;
+        printf("SIMPOINT_L2CACHE_MISS_ERR \t : %10.3f\n",
+               l2_miss_perc - full_l2_miss_perc);
+    }
+    return 0;
+}
+
+/** One simulation of the partitioning sweep and its outcome. */
+typedef struct SweepRun
+{
+    std::string name;
+    ReplacementPolicy l2_repl;
+    unsigned int swp_core0_ways;
+
+    /**
+     * The trace simulated alone, on its own core with the whole L2 to itself,
+     * or -1 to simulate both together.
+     */
+    int alone_trace;
+
+    pid_t pid;
+    int result_fd;
+    bool ok;
+    double ipc[MAX_CORES];
+} SweepRun;
+
+/*
+* Function to start one simulation of the partitioning sweep in a child
+* process, which sends the IPC of each core back through a pipe
+*/
+static bool start_sweep_run(SweepRun *run)
+{
+    int pipefd[2];
+    if (pipe(pipefd) != 0)
+    {
+        perror("pipe");
+        return false;
+    }
+
+    run->pid = fork();
+    if (run->pid < 0)
+    {
+        perror("fork");
+        close(pipefd[0]);
+        close(pipefd[1]);
+        run->pid = 0;
+        return false;
+    }
+
+    if (run->pid == 0)
+    {
+        close(pipefd[0]);
+        if (!freopen("/dev/null", "w", stdout))
+        {
+            _exit(1);
+        }
+
+        L2CACHE_REPL = run->l2_repl;
+        SWP_CORE0_WAYS = run->swp_core0_ways;
+        alone_core = run->alone_trace;
+
+        double ipc[MAX_CORES] = {0, 0};
+        if (run_simulation() != 0)
+        {
+            _exit(1);
+        }
+        for (unsigned int i = 0; i < NUM_CORES; i++)
+        {
+            if (core[i]->done_cycle_count)
+            {
+                ipc[i] = (double)core[i]->done_inst_count /
+                         core[i]->done_cycle_count;
+            }
+        }
+        bool sent = write(pipefd[1], ipc, sizeof(ipc)) == sizeof(ipc);
+        _exit(sent ? 0 : 1);
+    }
+
+    close(pipefd[1]);
+    run->result_fd = pipefd[0];
+    return true;
+}
+
+/*
+* Function to wait for one simulation of the partitioning sweep to finish and
+* collect its IPCs
+*/
+static void finish_sweep_run(std::vector<SweepRun> &runs)
+{
+    int status;
+    pid_t pid = wait(&status);
+    for (SweepRun &run : runs)
+    {
+        if (run.pid != pid)
+        {
+            continue;
+        }
+        run.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                 read(run.result_fd, run.ipc, sizeof(run.ipc)) ==
+                     sizeof(run.ipc);
+        close(run.result_fd);
+        run.pid = 0;
+    }
+}
+
+/*
+* Function to kill the simulations of the partitioning sweep that are still
+* running and reap them, so that none is left behind when the sweep fails
+*/
+static void stop_sweep_runs(std::vector<SweepRun> &runs)
+{
+    for (SweepRun &run : runs)
+    {
+        if (run.pid <= 0)
+        {
+            continue;
+        }
+        kill(run.pid, SIGKILL);
+        waitpid(run.pid, NULL, 0);
+        close(run.result_fd);
+        run.pid = 0;
+    }
+}
+
+/**
+ * Simulate each trace alone with an LRU L2, then both traces together under
+ * every L2 replacement policy and SWP quota, in parallel processes, and print
+ * the IPC and slowdown of each core, the weighted and harmonic speedups, the
+ * maximum slowdown and the fairness (minimum over maximum slowdown) of each
+ * shared configuration in a single table.
+ */
+int run_partition_sweep()
+{
+    std::vector<SweepRun> runs;
+    for (int t = 0; t < MAX_CORES; t++)
+    {
+        runs.push_back({"alone_" + std::to_string(t), LRU, 0, t});
+    }
+    runs.push_back({"LRU", LRU, 0, -1});
+    runs.push_back({"random", RANDOM, 0, -1});
+    for (unsigned int ways = 1; ways < L2CACHE_ASSOC; ways++)
+    {
+        runs.push_back({"SWP_" + std::to_string(ways), SWP, ways, -1});
+    }
+    runs.push_back({"DWP", DWP, 0, -1});
+
+    long max_jobs = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    long running = 0;
+    fflush(stdout);
+    for (SweepRun &run : runs)
+    {
+        if (running == max_jobs)
+        {
+            finish_sweep_run(runs);
+            running--;
+        }
+        if (!start_sweep_run(&run))
+        {
+            stop_sweep_runs(runs);
+            return 1;
+        }
+        running++;
+    }
+    for (; running > 0; running--)
+    {
+        finish_sweep_run(runs);
+    }
+
+    for (const SweepRun &run : runs)
+    {
+        if (!run.ok)
+        {
+            fprintf(stderr, "Error: the %s simulation failed\n",
+                    run.name.c_str());
+            return 1;
+        }
+    }
+
+    double alone_ipc[MAX_CORES] = {runs[0].ipc[0], runs[1].ipc[1]};
+    printf("\n");
+    printf("ALONE_IPC_0          \t\t : %10.3f\n", alone_ipc[0]);
+    printf("ALONE_IPC_1          \t\t : %10.3f\n", alone_ipc[1]);
+    printf("\n");
+    printf("%-10s %8s %8s %8s %8s %8s %8s %8s %8s\n", "L2_POLICY", "IPC_0",
+           "IPC_1", "SLOW_0", "SLOW_1", "WS", "HS", "MAX_SLOW", "FAIRNESS");
+    for (size_t r = MAX_CORES; r < runs.size(); r++)
+    {
+        const SweepRun &run = runs[r];
+        double slowdown[MAX_CORES];
+        double weighted_speedup = 0;
+        double slowdown_sum = 0;
+        for (int i = 0; i < MAX_CORES; i++)
+        {
+            slowdown[i] = run.ipc[i] > 0 ? alone_ipc[i] / run.ipc[i] : 0;
+            weighted_speedup += run.ipc[i] / alone_ipc[i];
+            slowdown_sum += slowdown[i];
+        }
+        double max_slowdown = std::max(slowdown[0], slowdown[1]);
+        double min_slowdown = std::min(slowdown[0], slowdown[1]);
+        printf("%-10s %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+               run.name.c_str(), run.ipc[0], run.ipc[1], slowdown[0],
+               slowdown[1], weighted_speedup,
+               slowdown_sum > 0 ? MAX_CORES / slowdown_sum : 0, max_slowdown,
+               max_slowdown > 0 ? min_slowdown / max_slowdown : 0);
+    }
+    return 0;
+}
+
+void print_dots()
+{
+    unsigned int LINE_INTERVAL = 50 * DOT_INTERVAL;
+    last_printdot_cycle = current_cycle;
 
     if (!PRINT_DOTS)
     {
@@ -338,7 +1524,7 @@ void print_stats()
 {
     printf("\n\n");
     printf("CYCLES              \t\t : %10llu\n",
-           (unsigned long long)current_cycle);
+           (unsigned long long)(current_cycle - core[0]->start_cycle));
 
     for (unsigned int i = 0; i < NUM_CORES; i++)
     {
@@ -346,6 +1532,53 @@ void print_stats()
     }
 
     memsys_print_stats(memsys);
+
+    bool alone_ipc_known = true;
+    for (unsigned int i = 0; i < NUM_CORES; i++)
+    {
+        alone_ipc_known = alone_ipc_known && ALONE_IPC[i] > 0;
+    }
+    if (alone_ipc_known)
+    {
+        double shared_ipc[2];
+        for (unsigned int i = 0; i < NUM_CORES; i++)
+        {
+            shared_ipc[i] = 0;
+            if (core[i]->done_cycle_count)
+            {
+                shared_ipc[i] = (double)core[i]->done_inst_count /
+                                core[i]->done_cycle_count;
+            }
+        }
+        print_slowdowns(ALONE_IPC, shared_ipc, NUM_CORES);
+    }
+}
+
+/**
+ * Print the slowdown of each core in a shared run, alone IPC over shared IPC,
+ * and the weighted speedup (sum of shared over alone IPCs), harmonic speedup
+ * (number of cores over the sum of slowdowns) and maximum slowdown.
+ */
+void print_slowdowns(const double *alone_ipc, const double *shared_ipc,
+                     unsigned int num_cores)
+{
+    double weighted_speedup = 0;
+    double slowdown_sum = 0;
+    double max_slowdown = 0;
+    printf("\n");
+    for (unsigned int i = 0; i < num_cores; i++)
+    {
+        double slowdown = shared_ipc[i] > 0 ? alone_ipc[i] / shared_ipc[i]
+                                            : 0;
+        weighted_speedup += shared_ipc[i] / alone_ipc[i];
+        slowdown_sum += slowdown;
+        max_slowdown = std::max(max_slowdown, slowdown);
+        printf("CORE_%01u_SLOWDOWN     \t\t : %10.3f\n", i, slowdown);
+    }
+    double harmonic_speedup = slowdown_sum > 0 ? num_cores / slowdown_sum : 0;
+    printf("WEIGHTED_SPEEDUP     \t\t : %10.3f\n", weighted_speedup);
+    printf("HARMONIC_SPEEDUP     \t\t : %10.3f\n", harmonic_speedup);
+    printf("MAX_SLOWDOWN         \t\t : %10.3f\n", max_slowdown);
 }
 
 void print_usage(const char *program_name)
@@ -377,9 +1610,126 @@ void print_usage(const char *program_name)
                     "L2 cache [0: LRU,\n");
     fprintf(stderr, "                            1: random, 2: SWP, 3: DWP] "
                     "(default: 0)\n");
+    fprintf(stderr, "    -L2assoc <num>          Set associativity of the L2 "
+                    "cache (default: 16)\n");
+    fprintf(stderr, "    -L2latency <num>        Set hit time in cycles of "
+                    "the L2 cache (default: 10)\n");
+    fprintf(stderr, "    -L2private              Give each core a private L2 "
+                    "cache (mode 4 only)\n");
+    fprintf(stderr, "    -L3sizeKB <num>         Add a shared L3 cache of "
+                    "this capacity in KB\n");
+    fprintf(stderr, "                            (default: 0, no L3 cache)\n");
+    fprintf(stderr, "    -L3assoc <num>          Set associativity of the L3 "
+                    "cache (default: 16)\n");
+    fprintf(stderr, "    -L3repl <num>           Set replacement policy for "
+                    "L3 cache [0: LRU,\n");
+    fprintf(stderr, "                            1: random, 2: SWP, 3: DWP] "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -L3latency <num>        Set hit time in cycles of "
+                    "the nearest L3 bank\n");
+    fprintf(stderr, "                            (default: 30)\n");
+    fprintf(stderr, "    -L3banks <num>          Split the L3 cache into "
+                    "<num> NUCA banks (default: 1)\n");
+    fprintf(stderr, "    -L3bank_hop <num>       Set extra cycles per bank "
+                    "crossed in the L3 cache\n");
+    fprintf(stderr, "                            (default: 2)\n");
+    fprintf(stderr, "    -L2sample <num>         Simulate one in <num> L2 "
+                    "sets and extrapolate\n");
+    fprintf(stderr, "                            its miss rates (default: 1, "
+                    "all sets)\n");
+    fprintf(stderr, "    -L2compress             Compress the L2 cache, with "
+                    "twice the tags and\n");
+    fprintf(stderr, "                            8-byte data segments (needs "
+                    "LRU)\n");
+    fprintf(stderr, "    -L2compress_sizes <file> Compress the L2 cache, "
+                    "sizing the lines listed\n");
+    fprintf(stderr, "                            in <file> (hex address, "
+                    "bytes) by the file\n");
     fprintf(stderr, "    -SWP_core0ways <num>    Set static quota for core 0 "
                     "in SWP (default: 1)\n");
     fprintf(stderr, "    -dram_policy <num>      Set DRAM page policy "
-                    "[0: open-page, 1: close-page]\n");
+                    "[0: open-page, 1: close-page,\n");
+    fprintf(stderr, "                            2: timeout, 3: row-hit "
+                    "predictor, 4: hybrid]\n");
     fprintf(stderr, "                            (default: 0)\n");
+    fprintf(stderr, "    -dram_timeout <num>     Set idle cycles before the "
+                    "timeout policy closes\n");
+    fprintf(stderr, "                            a row (default: 200)\n");
+    fprintf(stderr, "    -dram_bw_cap <core> <num>  Cap the DRAM "
+                    "bandwidth of a core to <num> GB/s\n");
+    fprintf(stderr, "    -alone_ipc <core> <num> Give the IPC of a trace run "
+                    "alone to print the\n");
+    fprintf(stderr, "                            slowdowns of a shared run\n");
+    fprintf(stderr, "    -partition_sweep        Run each trace alone and "
+                    "both together under\n");
+    fprintf(stderr, "                            every L2 policy and SWP "
+                    "quota in mode 4, and\n");
+    fprintf(stderr, "                            print their slowdowns\n");
+    fprintf(stderr, "    -dram_timing            Model DRAM refresh and the "
+                    "tRRD/tFAW activation\n");
+    fprintf(stderr, "                            limits in modes 3 and 4\n");
+    fprintf(stderr, "    -dram_power             Print DRAM bandwidth, row "
+                    "buffer locality and energy\n");
+    fprintf(stderr, "    -reuse                  Only print reuse-distance "
+                    "and working-set\n");
+    fprintf(stderr, "                            histograms of each trace; "
+                    "exact, so about 1M\n");
+    fprintf(stderr, "                            accesses/s (2M with -O2) on "
+                    "traces with a large\n");
+    fprintf(stderr, "                            footprint\n");
+    fprintf(stderr, "    -reuse_window <num>     Set instructions per "
+                    "working-set window\n");
+    fprintf(stderr, "                            (default: 1000000)\n");
+    fprintf(stderr, "    -simpoint <num>         Simulate only up to <num> "
+                    "SimPoint intervals of a\n");
+    fprintf(stderr, "                            single trace; not supported "
+                    "with two traces\n");
+    fprintf(stderr, "                            (default: 0, whole trace)\n");
+    fprintf(stderr, "    -simpoint_interval <num> Set instructions per "
+                    "SimPoint interval\n");
+    fprintf(stderr, "                            (default: 100000)\n");
+    fprintf(stderr, "    -simpoint_warmup <num>  Set instructions of cache "
+                    "warm-up per SimPoint\n");
+    fprintf(stderr, "                            (default: 1000000)\n");
+    fprintf(stderr, "    -simpoint_validate      Also simulate the whole "
+                    "trace and print the error\n");
+    fprintf(stderr, "    -warmup <num>           Warm up the caches on the "
+                    "first <num> instructions\n");
+    fprintf(stderr, "                            of each trace without timing "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -checkpoint_save <file> <cycle>  Save the "
+                    "simulation at <cycle> and stop\n");
+    fprintf(stderr, "    -checkpoint_restore <file>  Resume the simulation "
+                    "from a checkpoint\n");
+    fprintf(stderr, "    -profile <num>          Track the <num> hottest PCs "
+                    "and pages by memory\n");
+    fprintf(stderr, "                            stall cycles, per access "
+                    "type (default: 0,\n");
+    fprintf(stderr, "                            disabled)\n");
+    fprintf(stderr, "    -profile_rows <num>     Set rows printed per "
+                    "profile table (default: 20)\n");
+    fprintf(stderr, "    -page_alloc <num>       Set physical page allocator "
+                    "in mode 4 [0: fixed,\n");
+    fprintf(stderr, "                            1: random, 2: buddy, "
+                    "3: L2 set coloring,\n");
+    fprintf(stderr, "                            4: DRAM bank coloring] "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -physmemMB <num>        Set physical memory size for "
+                    "the page allocator\n");
+    fprintf(stderr, "                            (default: 4096 MB)\n");
+    fprintf(stderr, "    -color_core0 <num>      Set colors given to core 0 "
+                    "by page coloring\n");
+    fprintf(stderr, "                            (default: half)\n");
+    fprintf(stderr, "    -tlb                    Simulate TLBs and page walks "
+                    "in mode 4\n");
+    fprintf(stderr, "    -hugepages              Use 2 MB pages for the TLBs "
+                    "and page walks\n");
+    fprintf(stderr, "    -L1TLBentries <num>     Set entries of each L1 I/D "
+                    "TLB (default: 64)\n");
+    fprintf(stderr, "    -L1TLBassoc <num>       Set associativity of the L1 "
+                    "TLBs (default: 4)\n");
+    fprintf(stderr, "    -L2TLBentries <num>     Set entries of the shared L2 "
+                    "TLB (default: 1024)\n");
+    fprintf(stderr, "    -L2TLBassoc <num>       Set associativity of the L2 "
+                    "TLB (default: 8)\n");
 }
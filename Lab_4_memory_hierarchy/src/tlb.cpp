@@ -0,0 +1,165 @@
+// tlb.cpp
+// Defines the functions used to implement the TLBs.
+
+#include "tlb.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cmath>
+#include <limits>
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The current clock cycle number.
+ *
+ * This is used as a timestamp for implementing the LRU replacement policy.
+ */
+extern uint64_t current_cycle;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a TLB.
+ *
+ * @param num_entries The total number of entries in the TLB.
+ * @param associativity The associativity of the TLB.
+ * @return A pointer to the TLB.
+ */
+TLB *tlb_new(uint64_t num_entries, uint64_t associativity)
+{
+    TLB *tlb = new TLB;
+    tlb->num_ways = associativity;
+    tlb->num_sets = num_entries / associativity;
+    tlb->tlb_sets.reserve(tlb->num_sets);
+    for (unsigned int i = 0; i < tlb->num_sets; ++i)
+    {
+        TLBSet ts;
+        for (unsigned int j = 0; j < tlb->num_ways; ++j)
+        {
+            TLBEntry te;
+            te.valid = false;
+            te.vpn = 0;
+            te.pfn = 0;
+            te.coreID = 0;
+            te.last_access_time = 0;
+            ts.entries.push_back(te);
+        }
+        tlb->tlb_sets.push_back(ts);
+    }
+
+    tlb->num_index_bits = std::log2(tlb->num_sets);
+
+    // Init stats
+    tlb->stat_access = 0;
+    tlb->stat_miss = 0;
+
+    return tlb;
+}
+
+/*
+* Function to get the set index of a virtual page number
+ * @param tlb The TLB to access.
+ * @param vpn The virtual page number.
+ * @return The set index.
+*/
+static uint64_t tlb_get_index(TLB *tlb, uint64_t vpn)
+{
+    uint64_t mask = std::numeric_limits<uint64_t>::max();
+    mask = mask << tlb->num_index_bits;
+    return vpn & ~mask;
+}
+
+/**
+ * Look up the given virtual page number in the TLB.
+ *
+ * Also update the TLB statistics accordingly.
+ *
+ * @param tlb The TLB to look up.
+ * @param vpn The virtual page number to translate.
+ * @param core_id The CPU core ID that requested this translation.
+ * @param pfn Set to the physical frame number on a hit.
+ * @return Whether the lookup was a hit or a miss.
+ */
+CacheResult tlb_lookup(TLB *tlb, uint64_t vpn, unsigned int core_id,
+                       uint64_t *pfn)
+{
+    tlb->stat_access++;
+    TLBSet &ts = tlb->tlb_sets[tlb_get_index(tlb, vpn)];
+    for (unsigned int i = 0; i < tlb->num_ways; ++i)
+    {
+        if (ts.entries[i].valid == true
+            && ts.entries[i].vpn == vpn
+            && ts.entries[i].coreID == core_id)
+        {
+            ts.entries[i].last_access_time = current_cycle;
+            *pfn = ts.entries[i].pfn;
+            return HIT;
+        }
+    }
+    tlb->stat_miss++;
+    return MISS;
+}
+
+/**
+ * Install the given translation into the TLB, evicting the LRU entry of the
+ * set if needed.
+ *
+ * @param tlb The TLB to install the translation into.
+ * @param vpn The virtual page number of the translation.
+ * @param pfn The physical frame number of the translation.
+ * @param core_id The CPU core ID that owns the translation.
+ */
+void tlb_install(TLB *tlb, uint64_t vpn, uint64_t pfn, unsigned int core_id)
+{
+    TLBSet &ts = tlb->tlb_sets[tlb_get_index(tlb, vpn)];
+    // Prefer an invalid entry, otherwise evict the LRU entry
+    unsigned int victim = 0;
+    uint64_t least_cycle_num = std::numeric_limits<uint64_t>::max();
+    for (unsigned int i = 0; i < tlb->num_ways; ++i)
+    {
+        if (ts.entries[i].valid == false)
+        {
+            victim = i;
+            break;
+        }
+        if (ts.entries[i].last_access_time < least_cycle_num)
+        {
+            least_cycle_num = ts.entries[i].last_access_time;
+            victim = i;
+        }
+    }
+
+    ts.entries[victim].valid = true;
+    ts.entries[victim].vpn = vpn;
+    ts.entries[victim].pfn = pfn;
+    ts.entries[victim].coreID = core_id;
+    ts.entries[victim].last_access_time = current_cycle;
+}
+
+/**
+ * Print the statistics of the given TLB.
+ *
+ * @param tlb The TLB to print the statistics of.
+ * @param header A label for the TLB, which is used as a prefix for each
+ *               statistic.
+ */
+void tlb_print_stats(TLB *tlb, const char *header)
+{
+    double miss_percent = 0.0;
+
+    if (tlb->stat_access)
+    {
+        miss_percent = 100.0 * (double)(tlb->stat_miss) /
+                       (double)(tlb->stat_access);
+    }
+
+    printf("\n");
+    printf("%s_ACCESS          \t\t : %10llu\n", header, tlb->stat_access);
+    printf("%s_MISS            \t\t : %10llu\n", header, tlb->stat_miss);
+    printf("%s_MISS_PERC       \t\t : %10.3f\n", header, miss_percent);
+}
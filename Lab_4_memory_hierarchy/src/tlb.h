@@ -0,0 +1,138 @@
+// tlb.h
+// Contains declarations of data structures and functions used to implement a
+// translation lookaside buffer (TLB).
+
+#ifndef __TLB_H__
+#define __TLB_H__
+
+#include "types.h"
+#include "cache.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+* A single TLB entry, holding one virtual to physical page mapping
+*/
+typedef struct TLBEntry
+{
+    /*
+    * Valid bit to denote presence in the TLB
+    */
+    bool valid;
+
+    /*
+    * Virtual page number this entry translates (used as the tag)
+    */
+    uint64_t vpn;
+
+    /*
+    * Physical frame number the virtual page maps to
+    */
+    uint64_t pfn;
+
+    /*
+    * Core ID owning the mapping, since there are no address space IDs
+    */
+    unsigned int coreID;
+
+    /*
+    * Last access time to implement LRU replacement
+    */
+    uint64_t last_access_time;
+
+} TLBEntry;
+
+/*
+* A set of TLB entries
+*/
+typedef struct TLBSet
+{
+    /*
+    * Array of entries to denote the different ways
+    */
+    std::vector<TLBEntry> entries;
+
+} TLBSet;
+
+/** A single set-associative TLB. */
+typedef struct TLB
+{
+    /*
+    * Number of ways in set
+    */
+    unsigned int num_ways;
+
+    /*
+    * Number of sets in the TLB
+    */
+    unsigned int num_sets;
+
+    /*
+    * Number of index bits
+    */
+    unsigned int num_index_bits;
+
+    /*
+    * TLB set holding vector
+    */
+    std::vector<TLBSet> tlb_sets;
+
+    /** The total number of lookups in this TLB. */
+    unsigned long long stat_access;
+
+    /** The total number of lookups that missed this TLB. */
+    unsigned long long stat_miss;
+} TLB;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a TLB.
+ *
+ * @param num_entries The total number of entries in the TLB.
+ * @param associativity The associativity of the TLB.
+ * @return A pointer to the TLB.
+ */
+TLB *tlb_new(uint64_t num_entries, uint64_t associativity);
+
+/**
+ * Look up the given virtual page number in the TLB.
+ *
+ * Also update the TLB statistics accordingly.
+ *
+ * @param tlb The TLB to look up.
+ * @param vpn The virtual page number to translate.
+ * @param core_id The CPU core ID that requested this translation.
+ * @param pfn Set to the physical frame number on a hit.
+ * @return Whether the lookup was a hit or a miss.
+ */
+CacheResult tlb_lookup(TLB *tlb, uint64_t vpn, unsigned int core_id,
+                       uint64_t *pfn);
+
+/**
+ * Install the given translation into the TLB, evicting the LRU entry of the
+ * set if needed.
+ *
+ * @param tlb The TLB to install the translation into.
+ * @param vpn The virtual page number of the translation.
+ * @param pfn The physical frame number of the translation.
+ * @param core_id The CPU core ID that owns the translation.
+ */
+void tlb_install(TLB *tlb, uint64_t vpn, uint64_t pfn, unsigned int core_id);
+
+/**
+ * Print the statistics of the given TLB.
+ *
+ * @param tlb The TLB to print the statistics of.
+ * @param header A label for the TLB, which is used as a prefix for each
+ *               statistic.
+ */
+void tlb_print_stats(TLB *tlb, const char *header);
+
+#endif // __TLB_H__
@@ -0,0 +1,436 @@
+// simpoint.cpp
+// Implements the basic block vector (BBV) profiler and the k-means clustering
+// used to pick representative simulation intervals (SimPoints) of a trace.
+
+#include "simpoint.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+/** The number of k-means runs, from different seeds, tried for each k. */
+#define SIMPOINT_KMEANS_RUNS 5
+
+/** The maximum number of k-means iterations per run. */
+#define SIMPOINT_KMEANS_ITERATIONS 100
+
+/** The fraction of the BIC score range the chosen clustering must reach. */
+#define SIMPOINT_BIC_THRESHOLD 0.9
+
+/**
+ * Hash a 64-bit value with the SplitMix64 finalizer.
+ *
+ * @param x the value to hash
+ * @return the hash of x
+ */
+static uint64_t simpoint_hash(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Get one coordinate of the random projection of a basic block, uniformly
+ * distributed in [-1, 1).
+ *
+ * Deriving it from a hash of the block address means the projection matrix
+ * never has to be stored.
+ *
+ * @param block_addr the address of the first instruction of the block
+ * @param dim the coordinate to get
+ * @return the coordinate
+ */
+static double simpoint_projection(uint64_t block_addr, unsigned int dim)
+{
+    uint64_t h = simpoint_hash(block_addr * SIMPOINT_DIMS + dim);
+    return (double)(h >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+/**
+ * Add the instructions counted so far for the current basic block to the
+ * vector of the current interval.
+ *
+ * @param sp the profiler
+ */
+static void simpoint_flush_block(SimPointProfiler *sp)
+{
+    if (sp->block_insts == 0)
+    {
+        return;
+    }
+    for (unsigned int d = 0; d < SIMPOINT_DIMS; d++)
+    {
+        sp->current[d] += (double)sp->block_insts *
+                          simpoint_projection(sp->block_addr, d);
+    }
+    sp->block_insts = 0;
+}
+
+/**
+ * Allocate and initialize a BBV profiler.
+ *
+ * @param interval_size the number of instructions in each interval
+ * @return a pointer to a newly allocated profiler
+ */
+SimPointProfiler *simpoint_profiler_new(uint64_t interval_size)
+{
+    SimPointProfiler *sp = new SimPointProfiler;
+    sp->interval_size = interval_size;
+    sp->interval_insts = 0;
+    sp->block_addr = 0;
+    sp->block_insts = 0;
+    sp->last_addr = 0;
+    sp->last_ended_block = true;
+    memset(sp->current, 0, sizeof(sp->current));
+    return sp;
+}
+
+/**
+ * Add one instruction of the trace to the profile.
+ *
+ * @param sp the profiler
+ * @param inst_addr the address (PC) of the instruction
+ * @param ends_block whether the instruction is a branch, which ends its basic
+ *                   block even when the next instruction is sequential
+ */
+void simpoint_profile_inst(SimPointProfiler *sp, uint64_t inst_addr,
+                           bool ends_block)
+{
+    if (sp->last_ended_block ||
+        inst_addr - sp->last_addr > SIMPOINT_MAX_INST_BYTES)
+    {
+        simpoint_flush_block(sp);
+        sp->block_addr = inst_addr;
+    }
+    sp->block_insts++;
+    sp->last_addr = inst_addr;
+    sp->last_ended_block = ends_block;
+
+    if (++sp->interval_insts == sp->interval_size)
+    {
+        // A block running across the boundary counts toward both intervals.
+        simpoint_flush_block(sp);
+        std::vector<double> vector(SIMPOINT_DIMS);
+        for (unsigned int d = 0; d < SIMPOINT_DIMS; d++)
+        {
+            vector[d] = sp->current[d] / (double)sp->interval_size;
+            sp->current[d] = 0.0;
+        }
+        sp->vectors.push_back(vector);
+        sp->interval_insts = 0;
+    }
+}
+
+/**
+ * Get the squared Euclidean distance between two vectors.
+ *
+ * @param a the first vector
+ * @param b the second vector
+ * @return the squared distance
+ */
+static double simpoint_dist2(const std::vector<double> &a,
+                             const std::vector<double> &b)
+{
+    double sum = 0.0;
+    for (unsigned int d = 0; d < SIMPOINT_DIMS; d++)
+    {
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    }
+    return sum;
+}
+
+/**
+ * Run k-means once, seeded with k-means++.
+ *
+ * @param x the points to cluster
+ * @param k the number of clusters
+ * @param rng the random number generator used for seeding
+ * @param centroids set to the centroids of the clusters
+ * @param assign set to the cluster of each point
+ * @return the sum of squared distances from each point to its centroid
+ */
+static double simpoint_kmeans(const std::vector<std::vector<double>> &x,
+                              unsigned int k, std::mt19937_64 &rng,
+                              std::vector<std::vector<double>> &centroids,
+                              std::vector<unsigned int> &assign)
+{
+    size_t n = x.size();
+    centroids.clear();
+    centroids.push_back(x[rng() % n]);
+    std::vector<double> nearest(n, std::numeric_limits<double>::max());
+    while (centroids.size() < k)
+    {
+        double total = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            nearest[i] = std::min(nearest[i],
+                                  simpoint_dist2(x[i], centroids.back()));
+            total += nearest[i];
+        }
+        if (total == 0.0)
+        {
+            // Fewer distinct points than clusters
+            centroids.push_back(x[rng() % n]);
+            continue;
+        }
+        double target = std::uniform_real_distribution<double>(0.0,
+                                                               total)(rng);
+        size_t pick = 0;
+        while (pick + 1 < n && target >= nearest[pick])
+        {
+            target -= nearest[pick++];
+        }
+        centroids.push_back(x[pick]);
+    }
+
+    assign.assign(n, k);
+    double sse = 0.0;
+    for (unsigned int iter = 0; iter < SIMPOINT_KMEANS_ITERATIONS; iter++)
+    {
+        bool changed = false;
+        sse = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            unsigned int best = 0;
+            double best_dist = simpoint_dist2(x[i], centroids[0]);
+            for (unsigned int c = 1; c < k; c++)
+            {
+                double dist = simpoint_dist2(x[i], centroids[c]);
+                if (dist < best_dist)
+                {
+                    best = c;
+                    best_dist = dist;
+                }
+            }
+            changed = changed || assign[i] != best;
+            assign[i] = best;
+            sse += best_dist;
+        }
+        if (!changed)
+        {
+            break;
+        }
+
+        // An emptied cluster keeps its old centroid.
+        std::vector<std::vector<double>> sums(
+            k, std::vector<double>(SIMPOINT_DIMS, 0.0));
+        std::vector<size_t> sizes(k, 0);
+        for (size_t i = 0; i < n; i++)
+        {
+            sizes[assign[i]]++;
+            for (unsigned int d = 0; d < SIMPOINT_DIMS; d++)
+            {
+                sums[assign[i]][d] += x[i][d];
+            }
+        }
+        for (unsigned int c = 0; c < k; c++)
+        {
+            if (sizes[c] == 0)
+            {
+                continue;
+            }
+            for (unsigned int d = 0; d < SIMPOINT_DIMS; d++)
+            {
+                centroids[c][d] = sums[c][d] / (double)sizes[c];
+            }
+        }
+    }
+    return sse;
+}
+
+/**
+ * Score a clustering with the Bayesian information criterion of a mixture of
+ * spherical Gaussians sharing one variance (as in X-means and SimPoint).
+ *
+ * @param n the number of points
+ * @param k the number of clusters
+ * @param assign the cluster of each point
+ * @param sse the sum of squared distances from each point to its centroid
+ * @return the BIC score; higher is better
+ */
+static double simpoint_bic(size_t n, unsigned int k,
+                           const std::vector<unsigned int> &assign,
+                           double sse)
+{
+    double r = (double)n;
+    double m = (double)SIMPOINT_DIMS;
+    double variance = 1e-12;
+    if (n > k && sse > 0.0)
+    {
+        variance = std::max(variance, sse / ((r - k) * m));
+    }
+
+    std::vector<size_t> sizes(k, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        sizes[assign[i]]++;
+    }
+    double loglik = -sse / (2.0 * variance);
+    for (unsigned int c = 0; c < k; c++)
+    {
+        if (sizes[c] == 0)
+        {
+            continue;
+        }
+        double rc = (double)sizes[c];
+        loglik += rc * log(rc / r) - rc * m / 2.0 * log(2.0 * M_PI * variance);
+    }
+    double params = (k - 1) + m * k + 1;
+    return loglik - params / 2.0 * log(r);
+}
+
+/**
+ * Cluster the intervals of the profile with k-means for every k up to max_k,
+ * keep the smallest k whose Bayesian information criterion (BIC) score is
+ * within 90% of the best, and pick the interval closest to each centroid.
+ *
+ * A trailing partial interval is not part of the profile.
+ *
+ * @param sp the profiler
+ * @param max_k the largest number of clusters to try
+ * @return the representative intervals, sorted by interval index
+ */
+std::vector<SimPoint> simpoint_pick(SimPointProfiler *sp, unsigned int max_k)
+{
+    const std::vector<std::vector<double>> &x = sp->vectors;
+    std::vector<SimPoint> points;
+    if (x.empty())
+    {
+        return points;
+    }
+    max_k = std::min<size_t>(std::max(max_k, 1u), x.size());
+
+    // Best (lowest SSE) clustering of each k
+    std::vector<std::vector<std::vector<double>>> centroids(max_k + 1);
+    std::vector<std::vector<unsigned int>> assigns(max_k + 1);
+    std::vector<double> scores(max_k + 1);
+    std::mt19937_64 rng(42);
+    for (unsigned int k = 1; k <= max_k; k++)
+    {
+        double best_sse = std::numeric_limits<double>::max();
+        for (unsigned int run = 0; run < SIMPOINT_KMEANS_RUNS; run++)
+        {
+            std::vector<std::vector<double>> c;
+            std::vector<unsigned int> a;
+            double sse = simpoint_kmeans(x, k, rng, c, a);
+            if (sse < best_sse)
+            {
+                best_sse = sse;
+                centroids[k] = c;
+                assigns[k] = a;
+            }
+        }
+        scores[k] = simpoint_bic(x.size(), k, assigns[k], best_sse);
+    }
+
+    double lo = *std::min_element(scores.begin() + 1, scores.end());
+    double hi = *std::max_element(scores.begin() + 1, scores.end());
+    unsigned int k = 1;
+    while (k < max_k && scores[k] < lo + SIMPOINT_BIC_THRESHOLD * (hi - lo))
+    {
+        k++;
+    }
+
+    // The interval nearest to each centroid represents its cluster.
+    for (unsigned int c = 0; c < k; c++)
+    {
+        SimPoint point = {0, 0.0, 0};
+        double best_dist = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            if (assigns[k][i] != c)
+            {
+                continue;
+            }
+            point.cluster_size++;
+            double dist = simpoint_dist2(x[i], centroids[k][c]);
+            if (dist < best_dist)
+            {
+                best_dist = dist;
+                point.interval = i;
+            }
+        }
+        if (point.cluster_size)
+        {
+            point.weight = (double)point.cluster_size / (double)x.size();
+            points.push_back(point);
+        }
+    }
+    std::sort(points.begin(), points.end(),
+              [](const SimPoint &a, const SimPoint &b)
+              { return a.interval < b.interval; });
+    return points;
+}
+
+/**
+ * Get the weighted sum of per-point values, e.g., the estimated CPI of the
+ * whole trace from the CPI of each SimPoint.
+ *
+ * @param points the SimPoints
+ * @param values one value per SimPoint
+ * @return the weighted sum
+ */
+double simpoint_weighted(const std::vector<SimPoint> &points,
+                         const std::vector<double> &values)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        sum += points[i].weight * values[i];
+    }
+    return sum;
+}
+
+/**
+ * Get the ratio of the weighted sums of per-point event counts, e.g., the
+ * estimated miss rate of the whole trace from the misses and accesses of each
+ * SimPoint.
+ *
+ * @param points the SimPoints
+ * @param numerators one numerator count per SimPoint
+ * @param denominators one denominator count per SimPoint
+ * @return the weighted ratio, or 0 if the weighted denominator is 0
+ */
+double simpoint_weighted_ratio(const std::vector<SimPoint> &points,
+                               const std::vector<double> &numerators,
+                               const std::vector<double> &denominators)
+{
+    double denominator = simpoint_weighted(points, denominators);
+    if (denominator == 0.0)
+    {
+        return 0.0;
+    }
+    return simpoint_weighted(points, numerators) / denominator;
+}
+
+/**
+ * Print the chosen SimPoints.
+ *
+ * @param sp the profiler the SimPoints were picked from
+ * @param points the SimPoints
+ */
+void simpoint_print_points(SimPointProfiler *sp,
+                           const std::vector<SimPoint> &points)
+{
+    printf("\n");
+    printf("SIMPOINT_INTERVAL_SIZE  \t : %10lu\n",
+           (unsigned long)sp->interval_size);
+    printf("SIMPOINT_INTERVALS      \t : %10lu\n",
+           (unsigned long)sp->vectors.size());
+    printf("SIMPOINT_CLUSTERS       \t : %10lu\n",
+           (unsigned long)points.size());
+    printf("%8s %10s %12s %8s %8s\n", "POINT", "INTERVAL", "START_INST",
+           "WEIGHT", "SIZE");
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        printf("%8lu %10lu %12lu %8.4f %8u\n", (unsigned long)i,
+               (unsigned long)points[i].interval,
+               (unsigned long)(points[i].interval * sp->interval_size),
+               points[i].weight, points[i].cluster_size);
+    }
+}
@@ -0,0 +1,135 @@
+// simpoint.h
+// Declares the basic block vector (BBV) profiler and the k-means clustering
+// used to pick representative simulation intervals (SimPoints) of a trace.
+// Shared by the simulators of Labs 2, 3 and 4.
+
+#ifndef _SIMPOINT_H_
+#define _SIMPOINT_H_
+
+#include <inttypes.h>
+#include <vector>
+
+/**
+ * The number of dimensions each basic block vector is randomly projected to
+ * before clustering.
+ */
+#define SIMPOINT_DIMS 15
+
+/**
+ * The largest forward distance in bytes from one instruction to the next that
+ * is still considered sequential; anything else starts a new basic block.
+ */
+#define SIMPOINT_MAX_INST_BYTES 16
+
+/**
+ * Builds one projected basic block vector per fixed-size interval of the
+ * trace.
+ */
+typedef struct SimPointProfiler
+{
+    /** The number of instructions in each interval. */
+    uint64_t interval_size;
+
+    /** The number of instructions seen so far in the current interval. */
+    uint64_t interval_insts;
+
+    /** The address of the first instruction of the current basic block. */
+    uint64_t block_addr;
+
+    /** The number of instructions of the current basic block seen so far. */
+    uint64_t block_insts;
+
+    /** The address of the previous instruction. */
+    uint64_t last_addr;
+
+    /** Whether the previous instruction ended its basic block. */
+    bool last_ended_block;
+
+    /** The projected basic block vector of the current interval. */
+    double current[SIMPOINT_DIMS];
+
+    /** The normalized, projected basic block vector of every full interval. */
+    std::vector<std::vector<double>> vectors;
+} SimPointProfiler;
+
+/** A representative interval of a trace. */
+typedef struct SimPoint
+{
+    /** The index of the interval; it starts at instruction index times the
+     *  interval size. */
+    uint64_t interval;
+
+    /** The fraction of all intervals that this interval stands for. */
+    double weight;
+
+    /** The number of intervals in the cluster of this interval. */
+    unsigned int cluster_size;
+} SimPoint;
+
+/**
+ * Allocate and initialize a BBV profiler.
+ *
+ * @param interval_size the number of instructions in each interval
+ * @return a pointer to a newly allocated profiler
+ */
+SimPointProfiler *simpoint_profiler_new(uint64_t interval_size);
+
+/**
+ * Add one instruction of the trace to the profile.
+ *
+ * @param sp the profiler
+ * @param inst_addr the address (PC) of the instruction
+ * @param ends_block whether the instruction is a branch, which ends its basic
+ *                   block even when the next instruction is sequential
+ */
+void simpoint_profile_inst(SimPointProfiler *sp, uint64_t inst_addr,
+                           bool ends_block);
+
+/**
+ * Cluster the intervals of the profile with k-means for every k up to max_k,
+ * keep the smallest k whose Bayesian information criterion (BIC) score is
+ * within 90% of the best, and pick the interval closest to each centroid.
+ *
+ * A trailing partial interval is not part of the profile.
+ *
+ * @param sp the profiler
+ * @param max_k the largest number of clusters to try
+ * @return the representative intervals, sorted by interval index
+ */
+std::vector<SimPoint> simpoint_pick(SimPointProfiler *sp, unsigned int max_k);
+
+/**
+ * Get the weighted sum of per-point values, e.g., the estimated CPI of the
+ * whole trace from the CPI of each SimPoint.
+ *
+ * @param points the SimPoints
+ * @param values one value per SimPoint
+ * @return the weighted sum
+ */
+double simpoint_weighted(const std::vector<SimPoint> &points,
+                         const std::vector<double> &values);
+
+/**
+ * Get the ratio of the weighted sums of per-point event counts, e.g., the
+ * estimated miss rate of the whole trace from the misses and accesses of each
+ * SimPoint.
+ *
+ * @param points the SimPoints
+ * @param numerators one numerator count per SimPoint
+ * @param denominators one denominator count per SimPoint
+ * @return the weighted ratio, or 0 if the weighted denominator is 0
+ */
+double simpoint_weighted_ratio(const std::vector<SimPoint> &points,
+                               const std::vector<double> &numerators,
+                               const std::vector<double> &denominators);
+
+/**
+ * Print the chosen SimPoints.
+ *
+ * @param sp the profiler the SimPoints were picked from
+ * @param points the SimPoints
+ */
+void simpoint_print_points(SimPointProfiler *sp,
+                           const std::vector<SimPoint> &points);
+
+#endif